@@ -501,6 +501,15 @@ class EditorActivity : BaseActivity() {
                     saveFile(openedFile)
                 }                
             }
+            R.id.action_goto_definition -> binding.editor.gotoDefinition()
+            R.id.action_find_references -> binding.editor.findReferences()
+            R.id.action_expand_selection -> binding.editor.expandSelection()
+            R.id.action_shrink_selection -> binding.editor.shrinkSelection()
+            R.id.action_select_function -> binding.editor.selectTextObject("function.outer")
+            R.id.action_next_sibling -> binding.editor.selectSibling(true)
+            R.id.action_prev_sibling -> binding.editor.selectSibling(false)
+            R.id.action_next_function -> binding.editor.moveTextObject("function.outer", true)
+            R.id.action_prev_function -> binding.editor.moveTextObject("function.outer", false)
             R.id.action_settings -> {
                 binding.editor.gotoLine(500)
             }
@@ -885,11 +894,12 @@ class EditorActivity : BaseActivity() {
                     serializeFile.delete()
                 }
             }                      
-            // initialize the tree-sitter
+            // initialize the tree-sitter, parse around the restored cursor first
             service.initTreeSitter(
                 document.getName(),
                 binding.editor.treeSitter,
-                binding.editor.getTextBuffer()
+                binding.editor.getTextBuffer(),
+                savedState?.position?.lineNumber ?: 1
             )
             return@loadSerializeFile savedState       
         
@@ -95,9 +95,10 @@ public class EditorService : Service() {
     suspend fun initTreeSitter(
         fileName: String,
         treeSitter: TreeSitter,
-        textBuffer: PieceTreeTextBuffer
+        textBuffer: PieceTreeTextBuffer,
+        visibleLine: Int = 1
     ) {
-        treeSitter.init(fileName, textBuffer)
+        treeSitter.init(fileName, textBuffer, visibleLine)
     }
     
     @WorkerThread
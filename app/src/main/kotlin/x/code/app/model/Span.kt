@@ -16,6 +16,8 @@
 
 package x.code.app.model
 
+import x.github.module.treesitter.TSStyleTable
+
 data class Span(
     var fg: Int? = null,
     var bg: Int? = null,
@@ -23,5 +25,8 @@ data class Span(
     var italic: Boolean = false,
     var strikethrough: Boolean = false,
     var underline: Boolean = false
-)
+) {
+    // pack the span to the style of TSStyleTable
+    fun toStyle() = TSStyleTable.pack(fg, bg, bold, italic, underline, strikethrough)
+}
 
@@ -18,20 +18,12 @@ package x.code.app.model
 
 import android.content.Context
 import android.graphics.Color
-import android.graphics.Typeface
-import android.text.SpannableStringBuilder
-import android.text.SpannableString
-import android.text.Spanned
-import android.text.style.CharacterStyle
-import android.text.style.BackgroundColorSpan
-import android.text.style.ForegroundColorSpan
-import android.text.style.StyleSpan
-import android.text.style.StrikethroughSpan
-import android.text.style.UnderlineSpan
 import android.text.TextUtils
+import android.util.SparseArray
 
 import androidx.annotation.MainThread
 
+import kotlinx.coroutines.*
 import kotlinx.serialization.*
 import kotlinx.serialization.json.*
 
@@ -41,13 +33,21 @@ import java.io.InputStream
 import x.code.app.util.JsonUtils
 import x.github.module.document.DocumentFile
 import x.github.module.piecetable.common.ContentChange
-import x.github.module.piecetable.common.Range
+import x.github.module.piecetable.common.Strings
 import x.github.module.piecetable.PieceTreeTextBuffer
 
-import x.github.module.treesitter.TSInputEdit
+import x.github.module.treesitter.TSCompletion
+import x.github.module.treesitter.TSContextStack
+import x.github.module.treesitter.TSEditRecorder
 import x.github.module.treesitter.TSLanguage
+import x.github.module.treesitter.TSLocals
+import x.github.module.treesitter.TSOffsetIndex
 import x.github.module.treesitter.TSParser
 import x.github.module.treesitter.TSQuery
+import x.github.module.treesitter.TSRange
+import x.github.module.treesitter.TSSelection
+import x.github.module.treesitter.TSStyleTable
+import x.github.module.treesitter.TSSymbolType
 import x.github.module.treesitter.TSTree
 import x.github.module.treesitter.TSNode
 import x.github.module.treesitter.TSPoint
@@ -65,14 +65,56 @@ class TreeSitter(private val context: Context) {
     private lateinit var tsParser: TSParser
     // the tree sitter query
     private lateinit var tsQuery: TSQuery
+    // the highlight query source, the pruned query is created again for a new theme
+    private lateinit var queryPattern: String
+    private var isQueryPruned = false
     // the tree sitter tree
     private lateinit var tsTree: TSTree    
+    // the UTF-8 copy of the text buffer, the tree offsets are UTF-8 bytes
+    private lateinit var offsetIndex: TSOffsetIndex
+    
+    // record the edits for the ts-replay benchmark, see startRecording
+    private var recorder: TSEditRecorder? = null
+    
+    // the background full parse after the viewport parse, see parseViewport
+    private val parseScope = CoroutineScope(SupervisorJob() + Dispatchers.Default)
+    private var fullParseJob: Job? = null
+    // the edits applied while the full parse is running
+    private val pendingEdits = mutableListOf<Pair<IntArray, List<String>>>()
+    // the tree is parsed from the included ranges of the viewport, which are moved by the edits
+    private var isViewportTree = false
+    
+    // the number of the parses, the cached lookups of an older tree are stale
+    public var generation: Long = 0L
+        private set
+    
+    // called on the main thread when the tree is replaced by the full parse
+    public var onTreeChanged: (() -> Unit)? = null
     
     // map the file name and file extension to the tree-sitter grammar
     private val fileTypeMap by lazy { mutableMapOf<String, String>() }
     
-    // map the scope name to the span type
-    private val spanTypeMap by lazy { mutableMapOf<String, Span>() }
+    // map the scope name to the packed style of the theme
+    private val themeStyles by lazy { mutableMapOf<String, Long>() }
+    // the theme compiled for the capture ids of the query, see compileStyles
+    private var styleTable: TSStyleTable? = null
+    // the highlight runs of the lines, shifted by the edits and dropped
+    // by the changed ranges of the parse, cleared when the theme is changed
+    private var lineRuns = SparseArray<IntArray>()
+    
+    // the scopes and symbols resolved by the locals query, if the grammar has one
+    private var localsQuery: TSQuery? = null
+    private var locals: TSLocals? = null
+    
+    // the enclosing classes and functions of the first visible line, see getContextLines
+    private var contextStack: TSContextStack? = null
+    
+    // the keywords and the identifiers offered for the word being typed, see getCompletions
+    private var completion: TSCompletion? = null
+    
+    // the expand and shrink selection and the text objects, see expandSelection
+    private var textobjectsQuery: TSQuery? = null
+    private var selection: TSSelection? = null
     
     public var isEnabled: Boolean = false
         set(value) {
@@ -86,9 +128,10 @@ class TreeSitter(private val context: Context) {
      *     
      * @fileName the name of document file 
      * @textBuffer contents of the text editor
+     * @visibleLine the first visible line, the large file is parsed around it first
      * @return
      */
-    fun init(fileName: String, textBuffer: PieceTreeTextBuffer) {
+    fun init(fileName: String, textBuffer: PieceTreeTextBuffer, visibleLine: Int = 1) {
         val language = getLanguage(fileName)                               
         // the query files directory, default is /data/data/package_name/files/query
         val queryDir = File(context.getFilesDir(), "query")
@@ -99,13 +142,72 @@ class TreeSitter(private val context: Context) {
         if (language != null && pattern != null) {
             this.tsParser = TSParser(language)
             this.tsQuery = TSQuery(language, pattern)
-            // first time parse the oldTree is null
-            this.tsTree = parse(null, textBuffer)           
+            this.queryPattern = pattern
+            this.isQueryPruned = false
+            compileStyles()
+            this.contextStack = TSContextStack(getScopeTypes(language))
+            this.completion = TSCompletion(getIdentifierTypes(language))
+            // the semantic highlight and the occurrences are optional
+            getPattern(queryDir, language.getName(), "locals")?.let {
+                runCatching { TSQuery(language, it) }.getOrNull()
+            }?.let { query ->
+                this.localsQuery = query
+                this.locals = TSLocals(query, tsQuery)
+            }
+            // the expand and shrink selection work without the text objects
+            this.textobjectsQuery = getPattern(queryDir, language.getName(), "textobjects")?.let {
+                runCatching { TSQuery(language, it) }.getOrNull()
+            }
+            this.selection = TSSelection(textobjectsQuery)
+            // copy the text buffer to UTF-8 block by block
+            this.offsetIndex = TSOffsetIndex().apply {
+                var start = 0
+                splitBuffer(textBuffer.length, 1048576).forEach { end ->
+                    append(textBuffer.substring(start, end.toInt()))
+                    start = end.toInt()
+                }
+            }
+            // first time parse the oldTree is null, the large text
+            // only parses the visible lines before the full parse
+            this.tsTree = if (textBuffer.length > VIEWPORT_PARSE_THRESHOLD) {
+                parseViewport(textBuffer, visibleLine)
+            } else {
+                parse(null, textBuffer)
+            }
             // now enable the tree-sitter
             this.isEnabled = true
+            // the edit trace is recorded only if the traces directory exists
+            // like adb shell mkdir /sdcard/Android/data/package_name/files/traces
+            context.getExternalFilesDir("traces")?.takeIf { it.exists() }?.let { dir ->
+                startRecording(File(dir, "${language.getName()}-${System.currentTimeMillis()}.tstrace"), textBuffer)
+            }
         }
     }
     
+    /**
+     * Start recording the edits of the syntax tree to the trace file
+     * the trace can be replayed on the host by the ts-replay benchmark
+     *
+     * @file the trace file
+     * @textBuffer contents of the text editor before the first edit
+     * @return
+     */
+    fun startRecording(file: File, textBuffer: PieceTreeTextBuffer) {
+        stopRecording()
+        if (this::tsTree.isInitialized) {
+            recorder = TSEditRecorder(file, tsTree.language.getName(), textBuffer.toString())
+        }
+    }
+    
+    /**
+     * Stop recording the edits and close the trace file
+     * @return
+     */
+    fun stopRecording() {
+        recorder?.close()
+        recorder = null
+    }
+    
     /**
      * Release the memory allocated by the native layer
      * @return
@@ -114,11 +216,41 @@ class TreeSitter(private val context: Context) {
         // now disable the tree-sitter
         this.isEnabled = false
         
+        // the background parser and index are released by the job itself
+        val job = fullParseJob
+        job?.cancel()
+        fullParseJob = null
+        pendingEdits.clear()
+        isViewportTree = false
+        
+        stopRecording()
+        
         // free up the memory
         if(this::tsParser.isInitialized) {
             tsParser.close()
         }
         
+        styleTable?.close()
+        styleTable = null
+        lineRuns.clear()
+        
+        locals?.close()
+        locals = null
+        // the job may be indexing the full tree by the locals query
+        localsQuery?.let { query -> job?.invokeOnCompletion { query.close() } ?: query.close() }
+        localsQuery = null
+        
+        contextStack?.close()
+        contextStack = null
+        
+        completion?.close()
+        completion = null
+        
+        selection?.close()
+        selection = null
+        textobjectsQuery?.close()
+        textobjectsQuery = null
+        
         if(this::tsQuery.isInitialized) {
             tsQuery.close()
         }
@@ -126,6 +258,10 @@ class TreeSitter(private val context: Context) {
         if(this::tsTree.isInitialized) {
             tsTree.close()
         }
+        
+        if(this::offsetIndex.isInitialized) {
+            offsetIndex.close()
+        }
     }
     
     /**
@@ -169,72 +305,234 @@ class TreeSitter(private val context: Context) {
     /**
      * Parse the text buffer to get the abstract syntax tree
      * you must ensure that TSParser has been initialized before calling this method
-     * here we use utf-16 encoding to process unicode
+     * here we parse the UTF-8 copy of the offset index, which has been edited
+     * by edit(changes), so the text buffer is only used by the query predicates
      *
      * @oldTree old TSTree this can be null for the first initialization of TSTree
      * @textBuffer contents of the text editor
      * @return the new TSTree
      */
     fun parse(oldTree: TSTree?, textBuffer: PieceTreeTextBuffer): TSTree {        
-        // 1024 * 1024 * 2 = 2MB
-        if(textBuffer.length > 2097152) {
-            // index of the indexs
-            var index: Int = 0
-            // default block size 1024 * 1024 = 1048576
-            val table = splitBuffer(textBuffer.length, 1048576)
-            // parse callback
-            tsTree = tsParser.parse(oldTree) { byteIndex, point ->            
-                // for UTF-16 encoding requires byteIndex / 2U
-                if (
-                    index < table.size && 
-                    byteIndex / 2U != 0U && 
-                    byteIndex / 2U >= table[index]
-                ) {
-                    index++
-                }
-
-                if (index < table.size && byteIndex / 2U < table[index]) {
-                    return@parse textBuffer
-                        .substring((byteIndex / 2U).toInt(), table[index].toInt())
-                        .toByteArray(Charsets.UTF_16LE)
-                } else {
-                    return@parse String().toByteArray(Charsets.UTF_16LE)
-                }
+        // 1024 * 1024 * 2 = 2MB, the predicates are skipped for the large text
+        val source = if (textBuffer.length > 2097152) null else textBuffer.toString()
+        // the cached runs were shifted by edit, only the changed lines are dropped
+        val isIncremental = oldTree != null && oldTree === tsTree
+        val newTree = tsParser.parse(oldTree, offsetIndex, source)
+        // the children of the root queried again by the locals, whose semantic styles may change,
+        // the locals query the whole tree if the old tree is not the tree of their last update
+        val localRows = locals?.update(newTree, oldTree, offsetIndex)
+        // only the identifiers of the changed children of the root are harvested again, like the locals
+        completion?.update(newTree, oldTree, offsetIndex)
+        if (isIncremental) {
+            oldTree!!.changedRanges(newTree).forEach {
+                removeLineRuns(it.startPoint.row.toInt() + 1, it.endPoint.row.toInt() + 1)
+            }
+            localRows?.let { rows ->
+                for (i in 0 until rows.size step 2) removeLineRuns(rows[i] + 1, rows[i + 1] + 1)
             }
         } else {
-            // parse string, note the string using utf16 encoding in native
-            tsTree = tsParser.parse(oldTree, textBuffer.toString())
+            lineRuns.clear()
         }
+        tsTree = newTree
+        generation += 1
+        // the stack and the selection cache the tree pointer, which a new tree may reuse
+        contextStack?.reset()
+        selection?.reset()
         // return the new TSTree
         return tsTree
     }
     
     /**
-     * Query text to find specific patterns in source code
+     * Parse the lines around the visible line as a standalone tree by the included
+     * ranges, so that the large text is highlighted without waiting for the full parse
+     * the window is snapped to the lines that start at column 1, which are the top-level
+     * declarations of most languages, then the full text is parsed in the background
+     * from a copy of the offset index, and swapped in on the main thread
+     *
+     * @textBuffer contents of the text editor
+     * @visibleLine the first visible line
+     * @return the TSTree of the visible lines
+     */
+    fun parseViewport(textBuffer: PieceTreeTextBuffer, visibleLine: Int): TSTree {
+        val lineCount = textBuffer.getLineCount()
+        val isTopLevel = { line: Int ->
+            textBuffer.getLineLength(line) > 0 && textBuffer.getLineFirstNonWhitespaceColumn(line) == 1
+        }
+        var startLine = maxOf(1, visibleLine - VIEWPORT_LINES / 2)
+        var endLine = minOf(lineCount, visibleLine + VIEWPORT_LINES)
+        // snap to the top-level boundaries, but don't search too far
+        val startLimit = maxOf(1, startLine - VIEWPORT_LINES)
+        while (startLine > startLimit && !isTopLevel(startLine)) startLine--
+        val endLimit = minOf(lineCount, endLine + VIEWPORT_LINES)
+        while (endLine < endLimit && !isTopLevel(endLine + 1)) endLine++
+        
+        val startByte = offsetIndex.toUtf8(textBuffer.getOffsetAt(startLine, 1))
+        val endByte = offsetIndex.toUtf8(
+            textBuffer.getOffsetAt(endLine, textBuffer.getLineLength(endLine) + 1)
+        )
+        tsParser.includedRanges = listOf(
+            TSRange(
+                TSPoint((startLine - 1).toUInt(), 0U),
+                TSPoint((endLine - 1).toUInt(), (endByte - offsetIndex.toUtf8(textBuffer.getOffsetAt(endLine, 1))).toUInt()),
+                startByte.toUInt(),
+                endByte.toUInt()
+            )
+        )
+        // 1024 * 1024 * 2 = 2MB, the predicates are skipped for the large text
+        val source = if (textBuffer.length > 2097152) null else textBuffer.toString()
+        val tree = tsParser.parse(null, offsetIndex, source)
+        locals?.update(tree, null, offsetIndex)
+        completion?.update(tree, null, offsetIndex)
+        isViewportTree = true
+        
+        // the background parser reads a copy, the index is edited on the main thread
+        val snapshot = offsetIndex.copy()
+        // the full tree is indexed in the background too, and swapped in with the tree
+        val fullLocals = localsQuery?.let { TSLocals(it, tsQuery) }
+        val fullCompletion = completion?.let { TSCompletion(getIdentifierTypes(tree.language)) }
+        fullParseJob = parseScope.launch {
+            val fullTree = TSParser(tree.language).use { parser ->
+                try {
+                    parser.parse(null, snapshot, source)
+                } catch (e: IllegalStateException) {
+                    null
+                }
+            }
+            fullTree?.let {
+                fullLocals?.update(it, null, snapshot)
+                fullCompletion?.update(it, null, snapshot)
+            }
+            // the native parse can't be cancelled, release the tree if recycled meanwhile
+            val job = coroutineContext.job
+            withContext(NonCancellable + Dispatchers.Main) {
+                try {
+                    if (!job.isCancelled && fullTree != null) {
+                        swapFullTree(fullTree, fullLocals, fullCompletion, snapshot, textBuffer)
+                    } else {
+                        fullTree?.close()
+                        fullLocals?.close()
+                        fullCompletion?.close()
+                    }
+                } finally {
+                    // a failed full parse keeps the viewport tree, but stops collecting the edits
+                    if (fullParseJob === job) {
+                        fullParseJob = null
+                        pendingEdits.clear()
+                    }
+                }
+            }
+        }.apply {
+            invokeOnCompletion { snapshot.close() }
+        }
+        return tree
+    }
+    
+    /**
+     * Replace the viewport tree by the full tree, the edits applied since the
+     * snapshot are replayed to the full tree, then it is reparsed incrementally
+     * from the live offset index, so the new tree references the live index
+     * the locals and the completion of the full tree are replaced too, so only the children
+     * edited since the snapshot are queried again on the main thread
+     * note that this method must be run on the main thread
+     */
+    @MainThread
+    private fun swapFullTree(
+        fullTree: TSTree,
+        fullLocals: TSLocals?,
+        fullCompletion: TSCompletion?,
+        snapshot: TSOffsetIndex,
+        textBuffer: PieceTreeTextBuffer
+    ) {
+        // replay the edits to the snapshot, which translates them for the full tree
+        pendingEdits.forEach { (edits, texts) -> snapshot.edit(fullTree, edits, texts) }
+        pendingEdits.clear()
+        tsParser.includedRanges = emptyList()
+        isViewportTree = false
+        fullLocals?.let {
+            locals?.close()
+            locals = it
+        }
+        fullCompletion?.let {
+            completion?.close()
+            completion = it
+        }
+        // reparse from the live index, which reuses the whole tree if no edits
+        val viewportTree = tsTree
+        parse(fullTree, textBuffer)
+        fullTree.close()
+        viewportTree.close()
+        onTreeChanged?.invoke()
+    }
+    
+    /**
+     * Get the cached highlight runs of the line, see highlightLines
+     *
+     * @line the line number
+     * @return the runs packed as [start, end, styleId], or null if not highlighted
+     */
+    fun getLineRuns(line: Int): IntArray? = lineRuns.get(line)
+    
+    /**
+     * Query the syntax tree for the highlight runs of the lines in one execution
      * tree-sitter provides a simple pattern-matching language for this purpose
      * note that the query predicate only for parse string not parse callback
+     * the query covers the lines from startLine until the first highlighted line,
+     * the captures are scattered to the lines they cover, and resolved to the
+     * non-overlapping runs by the style table, a later capture is the inner node
+     * and overrides the outer one, so the nested nodes like the string interpolation
+     * are resolved without span objects, the runs are cached until the lines are changed
      *
-     * @text the current line of text in the editor
-     * @lineStart the starting index of the current line of text in textBuffer
-     * @startOffset the starting index position of the query in the current line of text
-     * @endOffset the ending index position of the query in the current line of text
-     * @return spannable string
-     */
-    fun query(text: String, lineStart: Int, startOffset: Int, endOffset: Int): SpannableString {
-        val spannable = SpannableString(text)       
+     * @textBuffer contents of the text editor
+     * @startLine the first line to highlight
+     * @endLine the last line to highlight
+     * @return
+     */
+    fun highlightLines(textBuffer: PieceTreeTextBuffer, startLine: Int, endLine: Int) {
+        val table = styleTable ?: return
+        if (lineRuns.size() > MAX_CACHED_LINES) {
+            lineRuns.clear()
+        }
+        // stop before the lines highlighted already, like scrolling by a few lines
+        var lastLine = startLine
+        while (lastLine < endLine && lineRuns.indexOfKey(lastLine + 1) < 0) lastLine++
         
-        var spanMark: Any? = null
-        var markStart: Int = 0
-        var markEnd: Int = 0
+        val count = lastLine - startLine + 1
+        val lineStarts = IntArray(count) { textBuffer.getOffsetAt(startLine + it, 1) }
+        val lineEnds = IntArray(count) { lineStarts[it] + textBuffer.getLineLength(startLine + it) }
+        // the captures of every line packed as [start, end, captureId]
+        val captures = Array(count) { IntArray(TSStyleTable.RUN_STRIDE * 8) }
+        val captureCounts = IntArray(count)
+        
+        // scatter the capture to the lines it covers, like a multiline comment
+        val scatter = { start: Int, end: Int, id: Int ->
+            // the last line which starts at or before the capture
+            var index = lineStarts.binarySearch(start).let { if (it < 0) maxOf(-it - 2, 0) else it }
+            while (index < count && lineStarts[index] < end) {
+                val from = maxOf(start, lineStarts[index])
+                val to = minOf(end, lineEnds[index])
+                if (from < to) {
+                    var buffer = captures[index]
+                    val offset = captureCounts[index] * TSStyleTable.RUN_STRIDE
+                    if (offset + TSStyleTable.RUN_STRIDE > buffer.size) {
+                        buffer = buffer.copyOf(buffer.size * 2)
+                        captures[index] = buffer
+                    }
+                    buffer[offset] = from - lineStarts[index]
+                    buffer[offset + 1] = to - lineStarts[index]
+                    buffer[offset + 2] = id
+                    captureCounts[index]++
+                }
+                index++
+            }
+        }
         
         var prevNode: TSNode? = null
         var prevResult: Boolean = false
         var prevIndex: UInt = 0U
-        // offset * 2 for UTF-16 encoding
-        tsQuery.byteRange = UIntRange(
-            (lineStart + startOffset).toUInt() * 2U,
-            (lineStart + endOffset).toUInt() * 2U
-        )
+        // translate the offsets to UTF-8 bytes
+        val startByte = offsetIndex.toUtf8(lineStarts[0])
+        val endByte = offsetIndex.toUtf8(lineEnds[count - 1])
+        tsQuery.byteRange = UIntRange(startByte.toUInt(), endByte.toUInt())
         
         tsQuery.matches(tsTree.rootNode).forEach { match ->          
             for (capture in match.captures) {
@@ -250,155 +548,294 @@ class TreeSitter(private val context: Context) {
                 prevResult = match.predicateResult
                 prevIndex = match.patternIndex
         
-                var start = (capture.node.startByte / 2U).toInt() - lineStart
-                var end = (capture.node.endByte / 2U).toInt() - lineStart
-                // check offset boundary
-                if (end <= startOffset || start >= endOffset) {
-                    continue
-                } 
-                // reset offset boundary         
-                if (start < startOffset) start = startOffset
-                if (end > endOffset) end = endOffset
-                
-                spanTypeMap[capture.name]?.let { span ->              
-                    // remove previous span, which was attached markup object
-                    spannable.getSpans(start, end, CharacterStyle::class.java).forEach { markup ->                       
-                        val spanStart = spannable.getSpanStart(markup)
-                        val spanEnd = spannable.getSpanEnd(markup)                        
-                        // handle the string interpolate identifier
-                        // like println("$test -> ${ foo() }"), $test and ${ foo() }
-                        if (start > spanStart && end < spanEnd) {                           
-                            spanMark = markup                            
-                            markStart = spanStart
-                            markEnd = spanEnd                                                                 
-                        }                                           
-                        spannable.removeSpan(markup)
-                    }
-                    
-                    var typeface = Typeface.NORMAL                  
-                    // bold
-                    if (span.bold) {
-                        typeface = typeface or Typeface.BOLD
-                    }
-                                      
-                    // italic
-                    if (span.italic) {
-                        typeface = typeface or Typeface.ITALIC
-                    }
-                    
-                    // typeface
-                    if (typeface != Typeface.NORMAL) {
-                        spannable.setSpan(StyleSpan(typeface), start, end, Spanned.SPAN_INCLUSIVE_EXCLUSIVE)
-                    }
-                    
-                    // strikethrough
-                    if (span.underline) {
-                        spannable.setSpan(StrikethroughSpan(), start, end, Spanned.SPAN_INCLUSIVE_EXCLUSIVE)
-                    }
-
-                    // underline
-                    if (span.underline) {
-                        spannable.setSpan(UnderlineSpan(), start, end, Spanned.SPAN_INCLUSIVE_EXCLUSIVE)
-                    }
-                    
-                    // background color
-                    span.bg?.let {
-                        spannable.setSpan(BackgroundColorSpan(it), start, end, Spanned.SPAN_INCLUSIVE_EXCLUSIVE)
-                    }
-                                      
-                    // foreground color
-                    span.fg?.let {
-                        spannable.setSpan(ForegroundColorSpan(it), start, end, Spanned.SPAN_INCLUSIVE_EXCLUSIVE)
-                    }
-                    
-                    // handle the string interpolate identifier
-                    if (spanMark != null && start >= markEnd) {                        
-                        val spArray = spannable.getSpans(markStart, markEnd, CharacterStyle::class.java).apply {
-                            sortBy { spannable.getSpanStart(it) }
-                        }
-                        
-                        var start = spannable.getSpanStart(spArray[0])
-                        var end = spannable.getSpanEnd(spArray[0])                                               
-                        if (start != markStart) {                            
-                            spannable.setSpan(
-                                ForegroundColorSpan((spanMark as ForegroundColorSpan).getForegroundColor()), 
-                                markStart, 
-                                start, 
-                                Spanned.SPAN_INCLUSIVE_EXCLUSIVE
-                            )
-                        }
-                        
-                        for (i in 1..spArray.size - 1) {
-                            start = spannable.getSpanStart(spArray[i])
-                            // prev span end index => next span start index
-                            if (end != start) {
-                                spannable.setSpan(
-                                    ForegroundColorSpan((spanMark as ForegroundColorSpan).getForegroundColor()), 
-                                    end, 
-                                    start, 
-                                    Spanned.SPAN_INCLUSIVE_EXCLUSIVE
-                                )
-                            }
-                            end = spannable.getSpanEnd(spArray[i])
-                        }
-                        
-                        if (end != markEnd) {
-                            spannable.setSpan(
-                                ForegroundColorSpan((spanMark as ForegroundColorSpan).getForegroundColor()), 
-                                end, 
-                                markEnd, 
-                                Spanned.SPAN_INCLUSIVE_EXCLUSIVE
-                            )
-                        }
-                        // reset span mark to null
-                        spanMark = null
-                    }              
-                }
+                scatter(
+                    offsetIndex.toUtf16(capture.node.startByte.toInt()),
+                    offsetIndex.toUtf16(capture.node.endByte.toInt()),
+                    capture.id.toInt()
+                )
+            }
+        }
+        // the semantic captures are painted last, so a parameter overrides the variable
+        locals?.captures(startByte, endByte)?.let { semantics ->
+            for (i in 0 until semantics.size step TSLocals.STRIDE) {
+                scatter(
+                    offsetIndex.toUtf16(semantics[i]),
+                    offsetIndex.toUtf16(semantics[i + 1]),
+                    semantics[i + 2]
+                )
             }
         }
-        // return the spannable string
-        return spannable
+        // paint the captures of every line in order and merge them to runs
+        for (i in 0 until count) {
+            lineRuns.put(
+                startLine + i, 
+                table.resolveRuns(captures[i], captureCounts[i], 0, lineEnds[i] - lineStarts[i])
+            )
+        }
+    }
+    
+    /**
+     * Get the occurrences of the identifier at the offset, resolved by the locals query
+     * the definitions and references of the same symbol, like the parameter and its uses
+     *
+     * @offset the UTF-16 offset of the text buffer, like the cursor offset
+     * @return the UTF-16 ranges packed as [start, end], empty if there is no identifier
+     */
+    fun getOccurrences(offset: Int) = lookupLocals(offset) { occurrences(it) }
+    
+    /**
+     * Get the definition of the identifier at the offset, like the declaration of
+     * a local variable, a global symbol may be defined more than once
+     *
+     * @offset the UTF-16 offset of the text buffer, like the cursor offset
+     * @return the UTF-16 ranges packed as [start, end], empty if not found
+     */
+    fun getDefinition(offset: Int) = lookupLocals(offset) { definition(it) }
+    
+    /**
+     * Get the references of the identifier at the offset, without the definitions
+     *
+     * @offset the UTF-16 offset of the text buffer, like the cursor offset
+     * @return the UTF-16 ranges packed as [start, end], empty if not found
+     */
+    fun getReferences(offset: Int) = lookupLocals(offset) { references(it) }
+    
+    // look up the locals by the UTF-8 offset, and translate the ranges back to UTF-16
+    private inline fun lookupLocals(offset: Int, lookup: TSLocals.(Int) -> IntArray): IntArray {
+        val locals = locals?.takeIf { isEnabled } ?: return IntArray(0)
+        return locals.lookup(offsetIndex.toUtf8(offset)).also { ranges ->
+            for (i in ranges.indices) ranges[i] = offsetIndex.toUtf16(ranges[i])
+        }
     }
     
     /**
-     * When the text changes, the syntax tree is updated synchronously
+     * Expand the selection to the smallest syntax node enclosing it, the chain of the
+     * enclosing nodes is cached, so the repeated presses don't walk the tree again
+     *
+     * @start the UTF-16 start offset of the selection, or the cursor offset
+     * @end the UTF-16 end offset of the selection
+     * @return the UTF-16 range packed as [start, end], empty if the root is selected
+     */
+    fun expandSelection(start: Int, end: Int) = lookupSelection { expand(tsTree, it(start), it(end)) }
+    
+    /**
+     * Shrink the selection back to the range before the last expand
+     *
+     * @start the UTF-16 start offset of the selection
+     * @end the UTF-16 end offset of the selection
+     * @return the UTF-16 range packed as [start, end], empty if not found
+     */
+    fun shrinkSelection(start: Int, end: Int) = lookupSelection { shrink(tsTree, it(start), it(end)) }
+    
+    /**
+     * Select the next or the previous syntax node of the same parent
+     *
+     * @start the UTF-16 start offset of the selection
+     * @end the UTF-16 end offset of the selection
+     * @forward true for the next node, false for the previous one
+     * @return the UTF-16 range packed as [start, end], empty if not found
+     */
+    fun selectSibling(start: Int, end: Int, forward: Boolean) =
+        lookupSelection { sibling(tsTree, it(start), it(end), forward) }
+    
+    /**
+     * Select the text object of the textobjects query enclosing the selection
+     *
+     * @capture the capture name without @, like function.outer or parameter.inner
+     * @start the UTF-16 start offset of the selection
+     * @end the UTF-16 end offset of the selection
+     * @return the UTF-16 range packed as [start, end], empty if not found
+     */
+    fun selectTextObject(capture: String, start: Int, end: Int) =
+        lookupSelection { select(tsTree, offsetIndex, capture, it(start), it(end)) }
+    
+    /**
+     * Find the next or the previous text object, like the next function
+     *
+     * @capture the capture name without @, like function.outer or class.outer
+     * @offset the UTF-16 offset of the text buffer, like the cursor offset
+     * @forward true for the next object, false for the previous one
+     * @return the UTF-16 range packed as [start, end], empty if not found
+     */
+    fun moveTextObject(capture: String, offset: Int, forward: Boolean) =
+        lookupSelection { move(tsTree, offsetIndex, capture, it(offset), forward) }
+    
+    // translate the offsets to UTF-8 for the lookup, and the range back to UTF-16
+    private inline fun lookupSelection(lookup: TSSelection.((Int) -> Int) -> IntArray): IntArray {
+        val selection = selection?.takeIf { isEnabled } ?: return IntArray(0)
+        return selection.lookup(offsetIndex::toUtf8).also { range ->
+            for (i in range.indices) range[i] = offsetIndex.toUtf16(range[i])
+        }
+    }
+    
+    /**
+     * Get the start lines of the classes and functions enclosing the line, for the
+     * sticky header, the scope chain of the previous line is reused by the native
+     * stack, so scrolling by a few lines only walks the changed part of the chain
+     *
+     * @textBuffer contents of the text editor
+     * @line the first visible line
+     * @maxDepth the innermost scopes kept at most
+     * @return the start lines of the scopes above the line, outermost first
+     */
+    fun getContextLines(textBuffer: PieceTreeTextBuffer, line: Int, maxDepth: Int = MAX_CONTEXT_LINES): IntArray {
+        val stack = contextStack?.takeIf { isEnabled } ?: return IntArray(0)
+        val levels = stack.at(tsTree, offsetIndex.toUtf8(textBuffer.getOffsetAt(line, 1)))
+        val lines = ArrayList<Int>()
+        for (i in 0 until levels.size step TSContextStack.STRIDE) {
+            // the scope starting at the line is visible itself
+            val startLine = levels[i + 1] + 1
+            if (startLine < line && lines.lastOrNull() != startLine) lines.add(startLine)
+        }
+        return lines.takeLast(maxDepth).toIntArray()
+    }
+    
+    /**
+     * Get the symbols of the scope nodes shown by the sticky header, by the naming
+     * of the grammars, like class_declaration, function_definition and impl_item
+     *
+     * @language the tree-sitter language
+     * @return the symbols of the scope nodes
+     */
+    private fun getScopeTypes(language: TSLanguage): ShortArray {
+        val types = ArrayList<Short>()
+        for (symbol in 0U until language.symbolCount) {
+            if (language.symbolType(symbol.toUShort()) != TSSymbolType.REGULAR) continue
+            val name = language.symbolName(symbol.toUShort()) ?: continue
+            if (SCOPE_TYPE_PATTERN.matches(name)) types.add(symbol.toShort())
+        }
+        return types.toShortArray()
+    }
+    
+    /**
+     * Get the completions of the word before the offset, the keywords valid after
+     * the previous token and the identifiers of the document, ranked best first
+     *
+     * @offset the UTF-16 offset of the text buffer, like the cursor offset
+     * @maxResults the completions returned at most
+     * @return the completions, the prefixStart is the UTF-16 start of the word
+     *  being typed, which is replaced by the chosen word, or null if disabled
+     */
+    fun getCompletions(offset: Int, maxResults: Int = MAX_COMPLETIONS): TSCompletion.Result? {
+        val completion = completion?.takeIf { isEnabled } ?: return null
+        val result = completion.complete(tsTree, offsetIndex, offsetIndex.toUtf8(offset), maxResults)
+        return TSCompletion.Result(result.words, result.kinds, offsetIndex.toUtf16(result.prefixStart))
+    }
+    
+    /**
+     * Get the symbols of the identifier leaves offered by the completion, by the
+     * naming of the grammars, like identifier, type_identifier and field_identifier
+     *
+     * @language the tree-sitter language
+     * @return the symbols of the identifier nodes
+     */
+    private fun getIdentifierTypes(language: TSLanguage): ShortArray {
+        val types = ArrayList<Short>()
+        for (symbol in 0U until language.symbolCount) {
+            if (language.symbolType(symbol.toUShort()) != TSSymbolType.REGULAR) continue
+            val name = language.symbolName(symbol.toUShort()) ?: continue
+            if (IDENTIFIER_TYPE_PATTERN.matches(name)) types.add(symbol.toShort())
+        }
+        return types.toShortArray()
+    }
+    
+    /**
+     * Get the packed style of the highlight run
+     *
+     * @styleId the style id of the run returned by highlight
+     * @return the packed style, or TSStyleTable.NONE for the text without a style
+     */
+    fun style(styleId: Int): Long = styleTable?.takeIf { styleId >= 0 }?.get(styleId.toUInt()) ?: TSStyleTable.NONE
+    
+    /**
+     * Apply all the text changes of one edit operation to the syntax tree
+     * the changes are packed to an IntArray and edited in a single native call
      * note that this method must be run on the main thread
      *
-     * @range the range where the text changes
-     * @rangeOffset the starting offset of the text change range
-     * @insertedTextLength the amount of text to insert
-     * @deletedTextLength the amount of text to delete
-     * @finalLineNumber final row position after text insertion and deletion
-     * @finalColumn final column position after text insertion and deletion
+     * @changes the content changes from PieceTreeTextBuffer.applyEdits
      */
     @MainThread
-    fun edit(
-        range: Range,
-        rangeOffset: Int,
-        insertedTextLength: Int,
-        deletedTextLength: Int,
-        finalLineNumber: Int,
-        finalColumn: Int
-    ) {
-        // offset * 2U for utf-16 encoding
-        val tsInput = TSInputEdit(
-            startByte = rangeOffset.toUInt() * 2U,
-            oldEndByte = (rangeOffset + deletedTextLength).toUInt() * 2U,
-            newEndByte = (rangeOffset + insertedTextLength).toUInt() * 2U,
-            startPoint = TSPoint(
-                (range.startLine - 1).toUInt(),
-                (range.startColumn - 1).toUInt() * 2U
-            ),
-            oldEndPoint = TSPoint(
-                (range.endLine - 1).toUInt(),
-                (range.endColumn - 1).toUInt() * 2U
-            ),
-            newEndPoint = TSPoint(
-                (finalLineNumber - 1).toUInt(),
-                (finalColumn - 1).toUInt() * 2U
-            )
-        )
-        tsTree.edit(tsInput)
+    fun edit(changes: List<ContentChange>) {
+        val texts = changes.map { it.text ?: "" }
+        val edits = IntArray(changes.size * TSTree.EDIT_STRIDE)
+        changes.forEachIndexed { index, change ->
+            val text = texts[index]
+            val (insertingLinesCnt, _, lastLineLength, _) = Strings.countEOL(text)
+            // final position after text insertion and deletion
+            val finalLineNumber = change.range.startLine + insertingLinesCnt
+            val finalColumn = when {
+                text.length == 0 -> change.range.startColumn
+                insertingLinesCnt == 0 -> change.range.startColumn + lastLineLength
+                else -> lastLineLength + 1
+            }
+            // the highlight of the following lines is moved at once, not after the parse
+            shiftLineRuns(change.range.startLine, change.range.endLine, finalLineNumber)
+            // utf-16 code units, translated to utf-8 bytes by the offset index
+            with(index * TSTree.EDIT_STRIDE) {
+                edits[this] = change.rangeOffset
+                edits[this + 1] = change.rangeOffset + change.rangeLength
+                edits[this + 2] = change.rangeOffset + text.length
+                edits[this + 3] = change.range.startLine - 1
+                edits[this + 4] = change.range.startColumn - 1
+                edits[this + 5] = change.range.endLine - 1
+                edits[this + 6] = change.range.endColumn - 1
+                edits[this + 7] = finalLineNumber - 1
+                edits[this + 8] = finalColumn - 1
+            }
+        }
+        offsetIndex.edit(tsTree, edits, texts)
+        // the cached nodes have the positions before the edit
+        contextStack?.reset()
+        selection?.reset()
+        if (fullParseJob != null) {
+            pendingEdits += edits to texts
+        }
+        // the tree edit moved its included ranges, the parser must reparse the same window
+        if (isViewportTree) {
+            tsParser.includedRanges = tsTree.includedRanges
+        }
+        // the utf-16 edits are translated by the replay, same as the offset index
+        recorder?.record(edits, texts)
+    }
+    
+    /**
+     * Move the cached highlight runs of the lines after an edit to their new line numbers
+     * the edited lines are dropped, so only they are queried again when drawn
+     *
+     * @startLine the first line of the edit
+     * @oldEndLine the last line of the edit before the change
+     * @newEndLine the last line of the edit after the change
+     */
+    private fun shiftLineRuns(startLine: Int, oldEndLine: Int, newEndLine: Int) {
+        val delta = newEndLine - oldEndLine
+        if (delta == 0) {
+            removeLineRuns(startLine, oldEndLine)
+            return
+        }
+        // the lines keep the ascending order, so append the lines directly
+        val shifted = SparseArray<IntArray>(lineRuns.size())
+        for (i in 0 until lineRuns.size()) {
+            val line = lineRuns.keyAt(i)
+            when {
+                line < startLine -> shifted.append(line, lineRuns.valueAt(i))
+                line > oldEndLine -> shifted.append(line + delta, lineRuns.valueAt(i))
+            }
+        }
+        lineRuns = shifted
+    }
+    
+    /**
+     * Remove the cached highlight runs of the lines, they are queried again when drawn
+     *
+     * @startLine the first line to remove
+     * @endLine the last line to remove
+     */
+    private fun removeLineRuns(startLine: Int, endLine: Int) {
+        for (i in lineRuns.size() - 1 downTo 0) {
+            if (lineRuns.keyAt(i) in startLine..endLine) {
+                lineRuns.removeAt(i)
+            }
+        }
     }
     
     /**
@@ -489,13 +926,37 @@ class TreeSitter(private val context: Context) {
                     }
                     
                     // add the span
-                    spanTypeMap.put(it.key, span)  
+                    themeStyles.put(it.key, span.toStyle())
                 } else if (it.value !is JsonNull) {
                     // foreground color and add span
-                    spanTypeMap.put(it.key, Span(Color.parseColor(it.value.jsonPrimitive.content)))  
+                    themeStyles.put(it.key, Span(Color.parseColor(it.value.jsonPrimitive.content)).toStyle())
                 }                     
             }
         }
+        // the theme is changed after the query is compiled
+        if (isEnabled) compileStyles()
+    }
+    
+    /**
+     * Compile the theme styles for the capture ids of the highlight query
+     * the capture name without a style falls back to its parent name
+     * like function.method to function, so the query only looks up an id
+     * then the captures and patterns without any style are disabled in the query
+     * the disabled ones can't be restored, so the query is created again first
+     */
+    fun compileStyles() {
+        if (isQueryPruned) {
+            val query = TSQuery(tsQuery.language, queryPattern)
+            tsQuery.close()
+            tsQuery = query
+        }
+        val table = TSStyleTable(tsQuery, themeStyles)
+        styleTable?.close()
+        styleTable = table
+        lineRuns.clear()
+        // the capture ids of the new query are the same, the pattern is not changed
+        tsQuery.prune { id -> table[id] != TSStyleTable.NONE }
+        isQueryPruned = true
     }
     
     /**
@@ -566,5 +1027,24 @@ class TreeSitter(private val context: Context) {
         // return the s-expression string
         return pattern
     }
+    
+    companion object {
+        // the text larger than 256KB is parsed around the visible lines first
+        private const val VIEWPORT_PARSE_THRESHOLD = 262144
+        // the number of lines parsed around the visible line
+        private const val VIEWPORT_LINES = 200
+        // the highlight runs of the lines cached at most, a few screens
+        private const val MAX_CACHED_LINES = 512
+        // the scopes shown by the sticky header at most
+        private const val MAX_CONTEXT_LINES = 3
+        // the completions offered for the word being typed at most
+        private const val MAX_COMPLETIONS = 32
+        // the node types of the identifiers of the most grammars
+        private val IDENTIFIER_TYPE_PATTERN = Regex("\\w*identifier")
+        // the node types of the classes and functions of the most grammars
+        private val SCOPE_TYPE_PATTERN = Regex(
+            "\\w*(class|function|method|constructor|struct|interface|enum|namespace|impl|trait|object|module)\\w*" +
+            "_(declaration|definition|item|specifier)"
+        )
+    }
 }
-
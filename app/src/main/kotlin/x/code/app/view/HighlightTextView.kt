@@ -20,17 +20,8 @@ import android.content.Context
 import android.graphics.Canvas
 import android.graphics.Color
 import android.graphics.Rect
-import android.graphics.Typeface
+import android.graphics.drawable.ColorDrawable
 
-import android.text.SpannableStringBuilder
-import android.text.SpannableString
-import android.text.Spanned
-import android.text.style.CharacterStyle
-import android.text.style.BackgroundColorSpan
-import android.text.style.ForegroundColorSpan
-import android.text.style.StyleSpan
-import android.text.style.StrikethroughSpan
-import android.text.style.UnderlineSpan
 import android.text.StaticLayout
 import android.text.TextPaint
 
@@ -54,6 +45,7 @@ import x.code.app.model.TreeSitter
 
 import x.github.module.editor.util.sumOf
 import x.github.module.editor.view.EditorView
+import x.github.module.editor.view.WordwrapLayout
 import x.github.module.editor.SavedState
 import x.github.module.piecetable.PieceTreeTextBuffer
 import x.github.module.piecetable.common.ContentChange
@@ -77,6 +69,26 @@ class HighlightTextView @JvmOverloads constructor(
     private val lifecycleScope by obtainViewLifecycleScope()
     
     public val treeSitter by lazy { TreeSitter(context) }
+    
+    // the paints of the style ids, and the packed styles they were created for
+    private var stylePaints = arrayOfNulls<TextPaint>(64)
+    private var paintStyles = LongArray(64)
+    private val backgroundPaint = TextPaint()
+    
+    // the last visible line of the current frame, see onPrepareDraw
+    private var visibleEndLine = 1
+    // some lines are drawn without highlight during a fast fling
+    private var hasDeferredLines = false
+    
+    // the occurrences of the identifier at the cursor, found again when
+    // the cursor is moved or the text is parsed, see onPrepareDraw
+    private var occurrences = emptyList<Range>()
+    private var occurrenceOffset = -1
+    private var occurrenceGeneration = -1L
+    
+    // the sticky header of the enclosing classes and functions, see drawStickyHeader
+    private val headerPaint = TextPaint()
+    public var isStickyHeaderEnabled = true
         
     private val viewModel by lazy {
         findViewTreeViewModelStoreOwner()!!.run {
@@ -87,6 +99,11 @@ class HighlightTextView @JvmOverloads constructor(
     init {
         // hardware accelerated
         setLayerType(View.LAYER_TYPE_HARDWARE, null)
+        // redraw when the viewport tree is replaced by the full tree
+        treeSitter.onTreeChanged = {
+            recycleRenderNode()
+            invalidate()
+        }
     }    
     
     override fun onScaleBegin(detector: ScaleGestureDetector): Boolean {
@@ -149,21 +166,6 @@ class HighlightTextView @JvmOverloads constructor(
         lifecycleScope.launch(Dispatchers.Default.limitedParallelism(1)) {
             textLayout.measure()
         }
-        
-        // update the abstract syntax tree 
-        // this must be running on main thread
-        with(treeSitter) TreeSitter@ { 
-            if (isEnabled) {
-                this@TreeSitter.edit(
-                    range,
-                    rangeOffset, 
-                    insertedTextLength,
-                    deletedTextLength,
-                    finalLineNumber,
-                    finalColumn
-                )
-            }
-        }            
     }
 
     override fun afterTextChanged(
@@ -174,9 +176,13 @@ class HighlightTextView @JvmOverloads constructor(
         // perform text changed callback
         viewModel.setTextChanged(true)
         
-        // reparse the abstract syntax tree        
+        // update the abstract syntax tree in one batch
+        // and reparse, this must be running on main thread
         with(treeSitter) {
-            if (isEnabled) parse(pieceTreeBuffer)
+            if (isEnabled) {
+                edit(changes)
+                parse(pieceTreeBuffer)
+            }
         }
                
         // update text and cursor state
@@ -213,6 +219,215 @@ class HighlightTextView @JvmOverloads constructor(
         return viewModel.canRedo.value
     }
     
+    override fun onPrepareDraw(startLine: Int, endLine: Int) {
+        visibleEndLine = endLine
+        updateOccurrences()
+        // redraw the lines drawn without highlight once the fling settles
+        if (hasDeferredLines && !isFastScrolling()) {
+            hasDeferredLines = false
+            cacheRenderNodes.forEach { it.isDirty = true }
+        }
+    }
+    
+    override fun computeScroll() {
+        super.computeScroll()
+        // the fling may slow down or finish without requesting another frame
+        if (hasDeferredLines && !isFastScrolling()) {
+            postInvalidateOnAnimation()
+        }
+    }
+    
+    override fun onDraw(canvas: Canvas) {
+        super.onDraw(canvas)
+        drawStickyHeader(canvas)
+    }
+    
+    /**
+     * Draw the first lines of the scopes enclosing the first visible line on top
+     * of the text, the scopes are found by the native context stack of the tree,
+     * which only walks the changed part of the chain when scrolling by a few lines
+     * the word wrap mode is skipped, the first visible row may not start a line
+     */
+    private fun drawStickyHeader(canvas: Canvas) {
+        if (!isStickyHeaderEnabled || !treeSitter.isEnabled || textLayout is WordwrapLayout) return
+        // the line under the header, so the header doesn't hide its own scope
+        var line = scrollY / getLineHeight() + 1
+        var lines = treeSitter.getContextLines(pieceTreeBuffer, line)
+        if (lines.isEmpty()) return
+        line += lines.size
+        lines = treeSitter.getContextLines(pieceTreeBuffer, minOf(line, getLineCount()))
+        if (lines.isEmpty()) return
+        
+        canvas.save()
+        canvas.translate(paddingLeft.toFloat(), paddingTop.toFloat())
+        headerPaint.color = (background as? ColorDrawable)?.color ?: Color.DKGRAY
+        canvas.drawRect(
+            scrollX, scrollY, scrollX + getWidth(), scrollY + lines.size * getLineHeight(), headerPaint
+        )
+        lines.forEachIndexed { index, contextLine ->
+            val text = getLine(contextLine)
+            val paintY = getBaseLine(index + 1) + scrollY.toFloat()
+            drawLineNumber(canvas, contextLine, 0f, paintY)
+            // the header scrolls horizontally with the text
+            canvas.drawText(text, 0, text.length, getStartSpacing().toFloat(), paintY, textPaint)
+        }
+        // the separator line below the header
+        val bottom = (scrollY + lines.size * getLineHeight()).toFloat()
+        textPaint.color = Color.GRAY
+        canvas.drawLine(scrollX.toFloat(), bottom, (scrollX + getWidth()).toFloat(), bottom, textPaint)
+        textPaint.color = defaultPaintColor
+        canvas.restore()
+    }
+    
+    override fun drawRegionHighlight(
+        canvas: Canvas, rLine: Int, mLine: Int, start: Int, end: Int
+    ) {
+        super.drawRegionHighlight(canvas, rLine, mLine, start, end)
+        if (!isSelected()) {
+            drawOccurrencesBackground(canvas, rLine, mLine)
+        }
+    }
+    
+    /**
+     * Move the cursor to the definition of the identifier at the cursor
+     * the definition before the cursor is preferred for a global symbol
+     *
+     * @return true if the definition is found
+     */
+    fun gotoDefinition(): Boolean {
+        val offset = getOffset(cursor.lineNumber, cursor.column)
+        val ranges = treeSitter.getDefinition(offset)
+        if (ranges.isEmpty()) return false
+        var index = 0
+        while (index + 2 < ranges.size && ranges[index + 2] <= offset) index += 2
+        setSelection(Range.fromPositions(getPosition(ranges[index]), getPosition(ranges[index + 1])))
+        return true
+    }
+    
+    /**
+     * Mark the references of the identifier at the cursor as the search results
+     *
+     * @return the number of the references
+     */
+    fun findReferences(): Int {
+        val ranges = treeSitter.getReferences(getOffset(cursor.lineNumber, cursor.column))
+        setSearchResults(MutableList(ranges.size / 2) {
+            Range.fromPositions(getPosition(ranges[it * 2]), getPosition(ranges[it * 2 + 1]))
+        })
+        return ranges.size / 2
+    }
+    
+    /**
+     * Expand the selection to the syntax node enclosing it, the repeated
+     * presses expand the returned selection along the cached node chain
+     *
+     * @return true if the selection is expanded
+     */
+    fun expandSelection() = selectRange { start, end -> treeSitter.expandSelection(start, end) }
+    
+    /**
+     * Shrink the selection back to the range before the last expand
+     *
+     * @return true if the selection is shrunk
+     */
+    fun shrinkSelection() = selectRange { start, end -> treeSitter.shrinkSelection(start, end) }
+    
+    /**
+     * Select the text object enclosing the selection, like the function
+     *
+     * @capture the capture name of the textobjects query, like function.outer
+     * @return true if the text object is found
+     */
+    fun selectTextObject(capture: String) =
+        selectRange { start, end -> treeSitter.selectTextObject(capture, start, end) }
+    
+    /**
+     * Select the next or the previous syntax node of the same parent,
+     * the selection can be expanded from the sibling again
+     *
+     * @forward true for the next node, false for the previous one
+     * @return true if the sibling is selected
+     */
+    fun selectSibling(forward: Boolean) =
+        selectRange { start, end -> treeSitter.selectSibling(start, end, forward) }
+    
+    /**
+     * Select the next text object after the selection, or the previous one before it,
+     * like the next function, so the repeated presses walk through the functions
+     *
+     * @capture the capture name of the textobjects query, like function.outer
+     * @forward true for the next object, false for the previous one
+     * @return true if the text object is found
+     */
+    fun moveTextObject(capture: String, forward: Boolean): Boolean {
+        val range = getSelection()
+        val offset = if (forward) {
+            getOffset(range.endLine, range.endColumn)
+        } else {
+            getOffset(range.startLine, range.startColumn)
+        }
+        val ranges = treeSitter.moveTextObject(capture, offset, forward)
+        if (ranges.isEmpty()) return false
+        setSelection(Range.fromPositions(getPosition(ranges[0]), getPosition(ranges[1])))
+        return true
+    }
+    
+    // select the UTF-16 range packed as [start, end] found for the current selection
+    private inline fun selectRange(lookup: (Int, Int) -> IntArray): Boolean {
+        val range = getSelection()
+        val result = lookup(
+            getOffset(range.startLine, range.startColumn), getOffset(range.endLine, range.endColumn)
+        )
+        if (result.isEmpty()) return false
+        setSelection(Range.fromPositions(getPosition(result[0]), getPosition(result[1])))
+        return true
+    }
+    
+    /**
+     * Find the occurrences of the identifier at the cursor, only when the cursor
+     * offset or the syntax tree is changed, the lookup itself is a binary search
+     */
+    private fun updateOccurrences() {
+        if (!treeSitter.isEnabled || isSelected()) {
+            occurrences = emptyList()
+            occurrenceOffset = -1
+            return
+        }
+        val offset = getOffset(cursor.lineNumber, cursor.column)
+        if (offset == occurrenceOffset && treeSitter.generation == occurrenceGeneration) return
+        occurrenceOffset = offset
+        occurrenceGeneration = treeSitter.generation
+        val ranges = treeSitter.getOccurrences(offset)
+        // a symbol without another occurrence is not marked
+        occurrences = if (ranges.size <= 2) emptyList() else List(ranges.size / 2) {
+            Range.fromPositions(getPosition(ranges[it * 2]), getPosition(ranges[it * 2 + 1]))
+        }
+    }
+    
+    /**
+     * @rLine really line number
+     * @mLine measured line number
+     */
+    private fun drawOccurrencesBackground(canvas: Canvas, rLine: Int, mLine: Int) {
+        if (occurrences.isEmpty()) return
+        textPaint.color = Color.argb(68, 97, 175, 239)
+        for (range in occurrences) {
+            // the identifiers are in one line, the wrapped part is skipped
+            if (range.startLine != rLine || textLayout.getIndexAt(range.startLine, range.startColumn) + 1 != mLine) {
+                continue
+            }
+            val result = textLayout.getLineResult(mLine)
+            canvas.drawRect(
+                getStartSpacing() + getLineWidthAdvance(rLine, result.start + 1, range.startColumn),
+                (mLine - 1) * getLineHeight(),
+                getStartSpacing() + getLineWidthAdvance(rLine, result.start + 1, range.endColumn),
+                mLine * getLineHeight()
+            )
+        }
+        // restore to default color
+        textPaint.color = defaultPaintColor
+    }
+    
     /**
      *
      */
@@ -225,65 +440,57 @@ class HighlightTextView @JvmOverloads constructor(
         xPaint: Float,      // draw the starting x coordinate
         yPaint: Float,      // draw the starting y coordinate
     ) {
-        if (text.length > 0 && treeSitter.isEnabled) {
-            // draw the spannable string
+        // the visible lines are highlighted in one query, but not during a fast fling
+        val runs = if (text.length > 0 && treeSitter.isEnabled) {
+            treeSitter.getLineRuns(line) ?: if (isFastScrolling()) {
+                hasDeferredLines = true
+                null
+            } else {
+                treeSitter.highlightLines(pieceTreeBuffer, line, maxOf(line, visibleEndLine))
+                treeSitter.getLineRuns(line)
+            }
+        } else null
+        
+        if (runs != null) {
+            // draw the style runs with the cached paints, no span objects
             // for performance reasons, StaticLayout is not used to directly draw spans
-            val lineStart = getLineStart(line)
-            val spannable = treeSitter.query(text, lineStart, startOffset, endOffset)
             val widths = getTextWidths(text, startOffset, endOffset)
             
             var xStart = xPaint
-            var xEnd = xPaint
-            var start = startOffset
-            var end = startOffset
-            
-            while (start < endOffset) {
-                end = spannable.nextSpanTransition(start, endOffset, CharacterStyle::class.java)                
-                xEnd = xStart + widths.sumOf(start, end, startOffset)
+            for (i in 0 until runs.size step TSStyleTable.RUN_STRIDE) {
+                // the runs cover the whole line, clip them to the visible columns
+                val start = maxOf(runs[i], startOffset)
+                val end = minOf(runs[i + 1], endOffset)
+                if (start >= end) continue
+                val style = treeSitter.style(runs[i + 2])
+                val xEnd = xStart + widths.sumOf(start, end, startOffset)
+                
+                if (style == TSStyleTable.NONE) {
+                    canvas.drawText(text, start, end, xStart, yPaint, textPaint)
+                    xStart = xEnd
+                    continue
+                }
                 
                 // background color
-                spannable.getSpans(start, end, BackgroundColorSpan::class.java).firstOrNull()?.let {
-                    textPaint.color = it.backgroundColor
+                TSStyleTable.background(style).takeIf { it != 0 }?.let {
+                    backgroundPaint.color = it
                     canvas.drawRect(
                         xStart,
                         (line - 1) * getLineHeight(),
                         xEnd,
                         line * getLineHeight(),
+                        backgroundPaint
                     )
                 }
                 
+                val paint = obtainStylePaint(runs[i + 2], style)
                 // underline
-                spannable.getSpans(start, end, UnderlineSpan::class.java).firstOrNull()?.let {
-                    //textPaint.color = underlineColor
-                    canvas.drawLine(xStart, yPaint, xEnd, yPaint, textPaint)
-                }
-                
-                // foreground color
-                spannable.getSpans(start, end, ForegroundColorSpan::class.java).firstOrNull()?.let {
-                    textPaint.color = it.foregroundColor
-                }
-                
-                // typeface
-                spannable.getSpans(start, end, StyleSpan::class.java).firstOrNull()?.let {               
-                    when (it.style) {
-                        Typeface.BOLD_ITALIC -> {
-                            textPaint.setFakeBoldText(true)
-                            textPaint.setTextSkewX(-0.2f)
-                        }
-                        Typeface.BOLD -> textPaint.setFakeBoldText(true)
-                        Typeface.ITALIC -> textPaint.setTextSkewX(-0.2f)                         
-                    }
+                if (TSStyleTable.isUnderline(style)) {
+                    canvas.drawLine(xStart, yPaint, xEnd, yPaint, paint)
                 }
-                
                 // draw the content text
-                canvas.drawText(text, start, end, xStart, yPaint, textPaint)
-                // restore the paint state
-                textPaint.setColor(defaultPaintColor)
-                textPaint.setFakeBoldText(false)
-                textPaint.setTextSkewX(0f)
-                
+                canvas.drawText(text, start, end, xStart, yPaint, paint)
                 xStart = xEnd
-                start = end
             }
         } else {
             // no highlight for the text
@@ -291,6 +498,41 @@ class HighlightTextView @JvmOverloads constructor(
         }
     }
     
+    /**
+     * Get the cached paint of the style id, the paint is created again
+     * when the theme or the text size of the editor is changed
+     *
+     * @styleId the style id of the run
+     * @style the packed style of the style id
+     * @return the paint for drawing the run
+     */
+    private fun obtainStylePaint(styleId: Int, style: Long): TextPaint {
+        if (styleId >= stylePaints.size) {
+            val size = maxOf(styleId + 1, stylePaints.size * 2)
+            stylePaints = stylePaints.copyOf(size)
+            paintStyles = paintStyles.copyOf(size)
+        }
+        stylePaints[styleId]?.let { paint ->
+            if (
+                paintStyles[styleId] == style && 
+                paint.textSize == textPaint.textSize && 
+                paint.typeface == textPaint.typeface
+            ) {
+                return paint
+            }
+        }
+        
+        return TextPaint(textPaint).apply {
+            TSStyleTable.foreground(style).let { color = if (it != 0) it else defaultPaintColor }
+            setFakeBoldText(TSStyleTable.isBold(style))
+            setTextSkewX(if (TSStyleTable.isItalic(style)) -0.2f else 0f)
+            setStrikeThruText(TSStyleTable.isStrikethrough(style))
+        }.also {
+            stylePaints[styleId] = it
+            paintStyles[styleId] = style
+        }
+    }
+    
     override fun restoreState(
         savedState: SavedState, 
         textBuffer: PieceTreeTextBuffer
@@ -0,0 +1,58 @@
+plugins {
+    id("org.jetbrains.kotlin.jvm")
+    id("me.champeau.jmh")
+}
+
+// the JNI microbenchmark of the treesitter module on a desktop JVM
+// ./gradlew :benchmark:jmh -Pjmh.includes=QueryBenchmark
+
+val nativeDir = layout.buildDirectory.dir("native")
+val cppDir = "${rootProject.projectDir}/treesitter/src/main/cpp"
+
+kotlin {
+    jvmToolchain(21)
+}
+
+sourceSets {
+    main {
+        // the treesitter sources are compiled against the host stubs of src/main/java
+        kotlin.srcDir("${rootProject.projectDir}/treesitter/src/main/kotlin")
+    }
+}
+
+// build the android-tree-sitter JNI library for the host
+val configureNative = tasks.register<Exec>("configureNative") {
+    commandLine(
+        "cmake", "-S", cppDir, "-B", nativeDir.get().asFile.absolutePath,
+        "-DCMAKE_BUILD_TYPE=Release", "-DTREE_SITTER_JNI_HOST=ON", "-DTREE_SITTER_BENCHMARK=OFF"
+    )
+}
+
+val buildNative = tasks.register<Exec>("buildNative") {
+    dependsOn(configureNative)
+    commandLine("cmake", "--build", nativeDir.get().asFile.absolutePath, "--parallel")
+}
+
+jmh {
+    warmupIterations.set(3)
+    iterations.set(5)
+    fork.set(1)
+    benchmarkMode.set(listOf("avgt"))
+    timeUnit.set("ns")
+    // gc.alloc.rate.norm is the allocated bytes per operation
+    profilers.add("gc")
+    resultFormat.set("JSON")
+    jvmArgsAppend.addAll(
+        "-Djava.library.path=${nativeDir.get().asFile.absolutePath}",
+        "-Dts.corpus=$cppDir/benchmark/corpus",
+        "-Dts.queries=$cppDir/treesitter/nvim-treesitter"
+    )
+}
+
+tasks.named("jmh") {
+    dependsOn(buildNative)
+}
+
+dependencies {
+    implementation(libs.kotlin.reflect)
+}
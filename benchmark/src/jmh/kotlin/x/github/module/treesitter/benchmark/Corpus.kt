@@ -0,0 +1,57 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package x.github.module.treesitter.benchmark
+
+import java.io.File
+
+/**
+ * Load the corpus files and highlight queries of the host benchmark,
+ * see treesitter/src/main/cpp/benchmark.
+ */
+object Corpus {
+
+    private val corpusDir = File(System.getProperty("ts.corpus", "corpus"))
+
+    private val queriesDir = File(System.getProperty("ts.queries", "queries")).let {
+        if (File(it, "runtime/queries").exists()) File(it, "runtime/queries") else File(it, "queries")
+    }
+
+    /**
+     * Get the corpus text of the grammar
+     *
+     * @name grammar name like `c`, `kotlin` etc
+     * @return the text of the file like `corpus/kotlin.kt`
+     */
+    fun text(name: String): String {
+        val file = corpusDir.listFiles()?.firstOrNull { it.nameWithoutExtension == name }
+            ?: throw IllegalArgumentException("No corpus file of $name in $corpusDir")
+        return file.readText()
+    }
+
+    /**
+     * Get the highlights pattern, the `; inherits:` modeline is resolved
+     *
+     * @name grammar name like `c`, `kotlin` etc
+     * @return s-expression pattern string literal
+     */
+    fun highlights(name: String): String {
+        val file = File(queriesDir, "$name/highlights.scm")
+        if (!file.exists()) return ""
+        val source = file.readText()
+        val supers = Regex("^; inherits: ?([\\w,()]+)").find(source)?.groupValues?.get(1) ?: return source
+        return supers.split(',').joinToString("") { highlights(it.trim('(', ')', ' ')) } + source
+    }
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package x.github.module.treesitter.benchmark
+
+import java.util.concurrent.TimeUnit
+
+import org.openjdk.jmh.annotations.Benchmark
+import org.openjdk.jmh.annotations.Level
+import org.openjdk.jmh.annotations.OutputTimeUnit
+import org.openjdk.jmh.annotations.Param
+import org.openjdk.jmh.annotations.Scope
+import org.openjdk.jmh.annotations.Setup
+import org.openjdk.jmh.annotations.State
+import org.openjdk.jmh.annotations.TearDown
+import org.openjdk.jmh.infra.Blackhole
+
+import x.github.module.treesitter.TSLanguage
+import x.github.module.treesitter.TSNode
+import x.github.module.treesitter.TSParser
+import x.github.module.treesitter.TSTree
+
+/**
+ * The cost of the node accessors, each of them marshals the
+ * node or its fields through JNI.
+ */
+@State(Scope.Benchmark)
+@OutputTimeUnit(TimeUnit.NANOSECONDS)
+open class NodeBenchmark {
+
+    @Param("kotlin", "c", "json")
+    lateinit var language: String
+
+    private lateinit var parser: TSParser
+    private lateinit var tree: TSTree
+    private lateinit var node: TSNode
+
+    @Setup(Level.Trial)
+    fun setup() {
+        parser = TSParser(TSLanguage("tree_sitter_$language"))
+        tree = parser.parse(null, Corpus.text(language))
+        // a node with some children in the middle of the tree
+        node = tree.rootNode.children.maxBy { it.childCount }
+    }
+
+    @TearDown(Level.Trial)
+    fun tearDown() {
+        tree.close()
+        parser.close()
+    }
+
+    @Benchmark
+    fun rootNode() = tree.rootNode
+
+    @Benchmark
+    fun type() = node.type
+
+    @Benchmark
+    fun startByte() = node.startByte
+
+    @Benchmark
+    fun startPoint() = node.startPoint
+
+    @Benchmark
+    fun childCount() = node.childCount
+
+    @Benchmark
+    fun child() = node.child(0U)
+
+    @Benchmark
+    fun parent() = node.parent
+
+    @Benchmark
+    fun children() = node.children
+
+    @Benchmark
+    fun childrenLoop(blackhole: Blackhole) {
+        // the alternative of children, a JNI call per child
+        for (i in 0U until node.childCount) {
+            blackhole.consume(node.child(i))
+        }
+    }
+
+    @Benchmark
+    fun walk(blackhole: Blackhole) {
+        // visit all the nodes of the tree by the tree cursor
+        tree.walk().use { cursor ->
+            do {
+                blackhole.consume(cursor.currentNode)
+                if (cursor.gotoFirstChild()) continue
+                while (!cursor.gotoNextSibling()) {
+                    if (!cursor.gotoParent()) return
+                }
+            } while (true)
+        }
+    }
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package x.github.module.treesitter.benchmark
+
+import java.util.concurrent.TimeUnit
+
+import org.openjdk.jmh.annotations.Benchmark
+import org.openjdk.jmh.annotations.Level
+import org.openjdk.jmh.annotations.OutputTimeUnit
+import org.openjdk.jmh.annotations.Param
+import org.openjdk.jmh.annotations.Scope
+import org.openjdk.jmh.annotations.Setup
+import org.openjdk.jmh.annotations.State
+import org.openjdk.jmh.annotations.TearDown
+
+import x.github.module.treesitter.TSLanguage
+import x.github.module.treesitter.TSParser
+
+/**
+ * The cost of parsing from a string and from a callback, the callback
+ * parse calls back to the JVM for every chunk like TreeSitter.parse of the app.
+ */
+@State(Scope.Benchmark)
+@OutputTimeUnit(TimeUnit.MICROSECONDS)
+open class ParseBenchmark {
+
+    @Param("kotlin", "c", "json")
+    lateinit var language: String
+
+    @Param("1024", "16384")
+    var chunkSize: Int = 0
+
+    private lateinit var parser: TSParser
+    private lateinit var text: String
+
+    @Setup(Level.Trial)
+    fun setup() {
+        parser = TSParser(TSLanguage("tree_sitter_$language"))
+        text = Corpus.text(language)
+    }
+
+    @TearDown(Level.Trial)
+    fun tearDown() {
+        parser.close()
+    }
+
+    @Benchmark
+    fun parseString() = parser.parse(null, text).close()
+
+    @Benchmark
+    fun parseCallback() = parser.parse(null) { byte, _ ->
+        // for UTF-16 encoding requires byte / 2
+        val start = (byte / 2U).toInt()
+        if (start < text.length) {
+            text.substring(start, minOf(start + chunkSize, text.length)).toByteArray(Charsets.UTF_16LE)
+        } else {
+            ByteArray(0)
+        }
+    }.close()
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package x.github.module.treesitter.benchmark
+
+import java.util.concurrent.TimeUnit
+
+import org.openjdk.jmh.annotations.Benchmark
+import org.openjdk.jmh.annotations.Level
+import org.openjdk.jmh.annotations.OutputTimeUnit
+import org.openjdk.jmh.annotations.Param
+import org.openjdk.jmh.annotations.Scope
+import org.openjdk.jmh.annotations.Setup
+import org.openjdk.jmh.annotations.State
+import org.openjdk.jmh.annotations.TearDown
+import org.openjdk.jmh.infra.Blackhole
+
+import x.github.module.treesitter.TSLanguage
+import x.github.module.treesitter.TSParser
+import x.github.module.treesitter.TSQuery
+import x.github.module.treesitter.TSTree
+
+/**
+ * The cost of iterating the highlight query matches and captures,
+ * every match is marshaled to a TSQueryMatch with an ArrayList of captures.
+ */
+@State(Scope.Benchmark)
+@OutputTimeUnit(TimeUnit.MICROSECONDS)
+open class QueryBenchmark {
+
+    @Param("kotlin", "c", "json")
+    lateinit var language: String
+
+    private lateinit var parser: TSParser
+    private lateinit var query: TSQuery
+    private lateinit var tree: TSTree
+
+    @Setup(Level.Trial)
+    fun setup() {
+        val tsLanguage = TSLanguage("tree_sitter_$language")
+        parser = TSParser(tsLanguage)
+        query = TSQuery(tsLanguage, Corpus.highlights(language))
+        tree = parser.parse(null, Corpus.text(language))
+    }
+
+    @TearDown(Level.Trial)
+    fun tearDown() {
+        tree.close()
+        query.close()
+        parser.close()
+    }
+
+    @Benchmark
+    fun matches(blackhole: Blackhole) {
+        query.matches(tree.rootNode).forEach { blackhole.consume(it) }
+    }
+
+    @Benchmark
+    fun captures(blackhole: Blackhole) {
+        query.captures(tree.rootNode).forEach { blackhole.consume(it) }
+    }
+
+    @Benchmark
+    fun capturesInViewport(blackhole: Blackhole) {
+        // the lines drawn on the screen, like HighlightTextView
+        query.byteRange = UIntRange(0U, 4096U)
+        query.captures(tree.rootNode).forEach { blackhole.consume(it) }
+        query.byteRange = UIntRange(0U, UInt.MAX_VALUE)
+    }
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package android.os;
+
+/**
+ * Host stub of the android Build class, only the fields
+ * used by the treesitter module are provided.
+ */
+public final class Build {
+
+    private Build() {}
+
+    public static final class VERSION {
+        /** A desktop JVM always has java.lang.ref.Cleaner. */
+        public static final int SDK_INT = VERSION_CODES.TIRAMISU;
+
+        private VERSION() {}
+    }
+
+    public static final class VERSION_CODES {
+        public static final int TIRAMISU = 33;
+
+        private VERSION_CODES() {}
+    }
+}
@@ -678,6 +678,9 @@ open class EditorView @JvmOverloads constructor(
     // the scroll delta
     open val View.SCROLL_DELTA: Int get() = 30f.dp
     
+    // the fling velocity in pixels per second, see isFastScrolling
+    open val FAST_SCROLL_VELOCITY: Int get() = 2000f.dp
+    
     // whitespace character width
     val spacingWidth: Int
         get() = measureText("\t") // here \t equals spacing
@@ -1136,6 +1139,22 @@ open class EditorView @JvmOverloads constructor(
         textPaint.color = defaultPaintColor
     }
     
+    /**
+     * Called before the visible lines are drawn, so that the lines can be prepared
+     * in one batch, like querying the syntax highlight of the whole viewport
+     *
+     * @startLine the first visible line number
+     * @endLine the last visible line number
+     */
+    protected open fun onPrepareDraw(startLine: Int, endLine: Int) {}
+    
+    // the last visible line number of the measured lines
+    protected fun getVisibleEndLine() = (scrollY + getHeight()) / getLineHeight() + 1
+    
+    // the editor is flinging faster than FAST_SCROLL_VELOCITY
+    // the expensive decorations of the lines can be deferred until it settles
+    fun isFastScrolling() = !scroller.isFinished && scroller.currVelocity > FAST_SCROLL_VELOCITY
+    
     // override this method to implement your own logic
     // draw text for unwrap mode
     protected open fun drawText(
@@ -1177,6 +1196,7 @@ open class EditorView @JvmOverloads constructor(
         // visible start line number        
         var line = scrollY / getLineHeight() + 1
         var result = textLayout.getLineResult(line)
+        onPrepareDraw(result.line, textLayout.getReallyLine(getVisibleEndLine()))
         
         while (
             result.line <= getLineCount() &&
@@ -1209,6 +1229,9 @@ open class EditorView @JvmOverloads constructor(
     open fun onWordwrapHardwareDraw(canvas: Canvas) {        
         // visible start line number        
         var line = scrollY / getLineHeight() + 1              
+        if (line <= textLayout.count()) {
+            onPrepareDraw(textLayout.getReallyLine(line), textLayout.getReallyLine(getVisibleEndLine()))
+        }
         
         val paintX = getStartSpacing().toFloat()
         val paintY = getBaseLine(1).toFloat()
@@ -1262,6 +1285,7 @@ open class EditorView @JvmOverloads constructor(
         val spacing = getStartSpacing()
         // visible start line number        
         var line = scrollY / getLineHeight() + 1
+        onPrepareDraw(line, Math.min(getLineCount(), getVisibleEndLine()))
         
         // draw the text content of the visible lines
         while (
@@ -1302,6 +1326,7 @@ open class EditorView @JvmOverloads constructor(
         val paintX = spacing.toFloat()
         // note here the line number must be 1 for render node
         val paintY = getBaseLine(1).toFloat()            
+        onPrepareDraw(line, Math.min(getLineCount(), getVisibleEndLine()))
             
         // draw the text content of the visible lines
         while (
@@ -27,6 +27,7 @@ rootProject.name = "xedit-app"
 include(
     ":app",
     ":alerter",
+    ":benchmark",
     ":bypass",
     ":crash", 
     ":editor", 
@@ -0,0 +1,165 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __BENCH_UTILS_H__
+#define __BENCH_UTILS_H__
+
+#include <errno.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <tree_sitter/api.h>
+
+namespace bench {
+
+namespace fs = std::filesystem;
+
+using clock = std::chrono::steady_clock;
+
+// the elapsed microseconds since the start time point
+static inline double elapsed_micros(clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(clock::now() - start).count();
+}
+
+// the value at the given percentile (0..100) of the samples
+static inline double percentile(std::vector<double> samples, double p) {
+    if (samples.empty()) return 0.0;
+    std::sort(samples.begin(), samples.end());
+    size_t index = static_cast<size_t>(p / 100.0 * (samples.size() - 1) + 0.5);
+    return samples[std::min(index, samples.size() - 1)];
+}
+
+// read the whole file, empty if the file does not exist
+static inline std::string read_file(const fs::path &path) {
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream) return std::string();
+    std::ostringstream buffer;
+    buffer << stream.rdbuf();
+    return buffer.str();
+}
+
+// get the query source of the grammar like `queries/c/highlights.scm`
+// the `; inherits: c,cpp` modeline of nvim-treesitter is resolved recursively
+static inline std::string read_query(const fs::path &dir, const std::string &name,
+                                     const std::string &kind, int depth = 0) {
+    std::string source = read_file(dir / name / (kind + ".scm"));
+    if (source.empty() || depth > 4) return source;
+
+    const std::string modeline = "; inherits:";
+    if (source.compare(0, modeline.size(), modeline) != 0) return source;
+
+    std::string supers = source.substr(modeline.size(), source.find('\n') - modeline.size());
+    std::string pattern;
+    std::stringstream stream(supers);
+    for (std::string super; std::getline(stream, super, ',');) {
+        super.erase(0, super.find_first_not_of(" \t("));
+        super.erase(super.find_last_not_of(" \t\r)") + 1);
+        if (!super.empty()) pattern += read_query(dir, super, kind, depth + 1);
+    }
+    return pattern + source;
+}
+
+// memory accounting of the tree-sitter allocator, single threaded only
+struct MemoryCounter {
+    size_t live_bytes = 0;
+    size_t peak_bytes = 0;
+    // reset the peak to the current live bytes
+    size_t reset() { return peak_bytes = live_bytes; }
+};
+
+static MemoryCounter memory;
+
+static inline void *track(void *ptr) {
+    if (ptr != nullptr) {
+        memory.live_bytes += malloc_usable_size(ptr);
+        memory.peak_bytes = std::max(memory.peak_bytes, memory.live_bytes);
+    }
+    return ptr;
+}
+
+static inline void install_counting_allocator() {
+    ts_set_allocator(
+        [](size_t size) { return track(malloc(size)); },
+        [](size_t count, size_t size) { return track(calloc(count, size)); },
+        [](void *ptr, size_t size) {
+            size_t old_size = ptr ? malloc_usable_size(ptr) : 0;
+            void *result = realloc(ptr, size);
+            // realloc failure keeps the old block alive
+            if (result == nullptr && size != 0) return result;
+            memory.live_bytes -= old_size;
+            return track(result);
+        },
+        [](void *ptr) {
+            if (ptr == nullptr) return;
+            memory.live_bytes -= malloc_usable_size(ptr);
+            free(ptr);
+        }
+    );
+}
+
+// get the row and column of the byte offset
+static inline TSPoint point_at(const std::string &text, uint32_t offset) {
+    TSPoint point = {0, 0};
+    size_t line_start = 0;
+    for (size_t i = 0; i < offset && i < text.size(); ++i) {
+        if (text[i] == '\n') {
+            point.row += 1;
+            line_start = i + 1;
+        }
+    }
+    point.column = offset - static_cast<uint32_t>(line_start);
+    return point;
+}
+
+// advance the point over the text
+static inline TSPoint point_after(TSPoint point, const char *text, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        if (text[i] == '\n') {
+            point.row += 1;
+            point.column = 0;
+        } else {
+            point.column += 1;
+        }
+    }
+    return point;
+}
+
+// count the captures of the query over the whole tree
+static inline uint64_t count_captures(TSQueryCursor *cursor, const TSQuery *query, TSTree *tree) {
+    uint64_t count = 0;
+    uint32_t capture_index;
+    TSQueryMatch match;
+    ts_query_cursor_exec(cursor, query, ts_tree_root_node(tree));
+    while (ts_query_cursor_next_capture(cursor, &match, &capture_index)) {
+        count += 1;
+    }
+    return count;
+}
+
+} // namespace bench
+
+#endif // __BENCH_UTILS_H__
@@ -0,0 +1,62 @@
+#!/usr/bin/env bash
+#
+# build and package the release artifacts
+
+set -euo pipefail
+
+readonly ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+readonly BUILD_DIR="${BUILD_DIR:-$ROOT_DIR/build}"
+VERBOSE=0
+JOBS=$(nproc 2>/dev/null || echo 4)
+
+usage() {
+    cat <<USAGE
+Usage: $(basename "$0") [-v] [-j jobs] [target...]
+  -v        verbose output
+  -j jobs   number of parallel jobs (default: $JOBS)
+USAGE
+}
+
+log() {
+    if [[ $VERBOSE -eq 1 ]]; then
+        echo "[$(date +%H:%M:%S)] $*" >&2
+    fi
+}
+
+while getopts ":vj:h" opt; do
+    case "$opt" in
+        v) VERBOSE=1 ;;
+        j) JOBS="$OPTARG" ;;
+        h) usage; exit 0 ;;
+        \?) echo "unknown option -$OPTARG" >&2; usage; exit 1 ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+targets=("$@")
+if [[ ${#targets[@]} -eq 0 ]]; then
+    targets=(app treesitter piecetable)
+fi
+
+mkdir -p "$BUILD_DIR"
+trap 'echo "build failed at line $LINENO" >&2' ERR
+
+for target in "${targets[@]}"; do
+    log "building $target with $JOBS jobs"
+    if [[ -f "$ROOT_DIR/$target/CMakeLists.txt" ]]; then
+        cmake -S "$ROOT_DIR/$target" -B "$BUILD_DIR/$target" -DCMAKE_BUILD_TYPE=Release
+        cmake --build "$BUILD_DIR/$target" -j "$JOBS"
+    else
+        (cd "$ROOT_DIR" && ./gradlew ":$target:assembleRelease")
+    fi
+done
+
+count=0
+for file in "$BUILD_DIR"/**/*.{so,apk}; do
+    [[ -e "$file" ]] || continue
+    size=$(stat -c %s "$file")
+    printf '%-60s %10d\n' "${file#$BUILD_DIR/}" "$size"
+    count=$((count + 1))
+done
+
+echo "packaged $count artifacts"
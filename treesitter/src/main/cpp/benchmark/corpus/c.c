@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_CAPACITY 16
+
+typedef struct {
+    char *key;
+    int value;
+} Entry;
+
+typedef struct {
+    Entry *entries;
+    size_t size;
+    size_t capacity;
+} Table;
+
+static unsigned long hash(const char *str) {
+    unsigned long h = 5381;
+    int c;
+    while ((c = *str++) != 0)
+        h = ((h << 5) + h) + c;
+    return h;
+}
+
+Table *table_new(void) {
+    Table *table = malloc(sizeof(Table));
+    if (table == NULL) return NULL;
+    table->size = 0;
+    table->capacity = INITIAL_CAPACITY;
+    table->entries = calloc(table->capacity, sizeof(Entry));
+    return table;
+}
+
+void table_free(Table *table) {
+    for (size_t i = 0; i < table->capacity; i++)
+        free(table->entries[i].key);
+    free(table->entries);
+    free(table);
+}
+
+static int table_grow(Table *table);
+
+int table_put(Table *table, const char *key, int value) {
+    if (table->size * 2 >= table->capacity && table_grow(table) != 0)
+        return -1;
+    size_t index = hash(key) & (table->capacity - 1);
+    while (table->entries[index].key != NULL) {
+        if (strcmp(table->entries[index].key, key) == 0) {
+            table->entries[index].value = value;
+            return 0;
+        }
+        index = (index + 1) & (table->capacity - 1);
+    }
+    table->entries[index].key = strdup(key);
+    table->entries[index].value = value;
+    table->size++;
+    return 0;
+}
+
+int *table_get(Table *table, const char *key) {
+    size_t index = hash(key) & (table->capacity - 1);
+    while (table->entries[index].key != NULL) {
+        if (strcmp(table->entries[index].key, key) == 0)
+            return &table->entries[index].value;
+        index = (index + 1) & (table->capacity - 1);
+    }
+    return NULL;
+}
+
+static int table_grow(Table *table) {
+    Entry *old = table->entries;
+    size_t old_capacity = table->capacity;
+    table->capacity *= 2;
+    table->entries = calloc(table->capacity, sizeof(Entry));
+    if (table->entries == NULL) {
+        table->entries = old;
+        table->capacity = old_capacity;
+        return -1;
+    }
+    table->size = 0;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old[i].key != NULL) {
+            table_put(table, old[i].key, old[i].value);
+            free(old[i].key);
+        }
+    }
+    free(old);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    Table *table = table_new();
+    char line[256];
+    while (fgets(line, sizeof line, stdin) != NULL) {
+        char *word = strtok(line, " \t\r\n");
+        while (word != NULL) {
+            int *count = table_get(table, word);
+            table_put(table, word, count ? *count + 1 : 1);
+            word = strtok(NULL, " \t\r\n");
+        }
+    }
+    for (size_t i = 0; i < table->capacity; i++) {
+        if (table->entries[i].key != NULL)
+            printf("%-20s %d\n", table->entries[i].key, table->entries[i].value);
+    }
+    table_free(table);
+    return 0;
+}
@@ -0,0 +1,87 @@
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Threading.Tasks;
+
+namespace Editor.Core
+{
+    public enum TokenKind { Keyword, Identifier, Number, String, Comment, Operator }
+
+    public readonly record struct Token(TokenKind Kind, int Start, int Length);
+
+    public interface ITokenizer
+    {
+        IEnumerable<Token> Tokenize(string text);
+    }
+
+    public sealed class SimpleTokenizer : ITokenizer
+    {
+        private static readonly HashSet<string> Keywords = new() { "if", "else", "for", "while", "return" };
+
+        public IEnumerable<Token> Tokenize(string text)
+        {
+            int i = 0;
+            while (i < text.Length)
+            {
+                char c = text[i];
+                if (char.IsWhiteSpace(c))
+                {
+                    i++;
+                }
+                else if (char.IsLetter(c) || c == '_')
+                {
+                    int start = i;
+                    while (i < text.Length && (char.IsLetterOrDigit(text[i]) || text[i] == '_')) i++;
+                    var word = text.Substring(start, i - start);
+                    yield return new Token(Keywords.Contains(word) ? TokenKind.Keyword : TokenKind.Identifier, start, i - start);
+                }
+                else if (char.IsDigit(c))
+                {
+                    int start = i;
+                    while (i < text.Length && char.IsDigit(text[i])) i++;
+                    yield return new Token(TokenKind.Number, start, i - start);
+                }
+                else if (c == '"')
+                {
+                    int start = i++;
+                    while (i < text.Length && text[i] != '"') i++;
+                    yield return new Token(TokenKind.String, start, Math.Min(i + 1, text.Length) - start);
+                    i++;
+                }
+                else
+                {
+                    yield return new Token(TokenKind.Operator, i++, 1);
+                }
+            }
+        }
+    }
+
+    public class Highlighter<T> where T : ITokenizer, new()
+    {
+        private readonly T _tokenizer = new();
+        public event EventHandler<int>? Highlighted;
+
+        public async Task<Dictionary<TokenKind, int>> CountAsync(string text)
+        {
+            var counts = await Task.Run(() => _tokenizer.Tokenize(text)
+                .GroupBy(token => token.Kind)
+                .ToDictionary(group => group.Key, group => group.Count()));
+            Highlighted?.Invoke(this, counts.Values.Sum());
+            return counts;
+        }
+    }
+
+    public static class Program
+    {
+        public static async Task Main(string[] args)
+        {
+            var highlighter = new Highlighter<SimpleTokenizer>();
+            highlighter.Highlighted += (_, total) => Console.WriteLine($"{total} tokens");
+            var counts = await highlighter.CountAsync("if (x > 10) { return \"big\"; } else return 0;");
+            foreach (var (kind, count) in counts)
+            {
+                Console.WriteLine($"{kind,-12}{count}");
+            }
+        }
+    }
+}
@@ -0,0 +1,62 @@
+cmake_minimum_required(VERSION 3.14)
+
+project(texteditor VERSION 1.2.0 LANGUAGES C CXX)
+
+set(CMAKE_CXX_STANDARD 17)
+set(CMAKE_CXX_STANDARD_REQUIRED ON)
+
+option(TEXTEDITOR_BUILD_TESTS "Build the unit tests" ON)
+option(TEXTEDITOR_USE_SANITIZERS "Enable address sanitizer" OFF)
+
+if(NOT CMAKE_BUILD_TYPE)
+    set(CMAKE_BUILD_TYPE Release CACHE STRING "Build type" FORCE)
+endif()
+
+set(SOURCES
+    src/buffer.cpp
+    src/document.cpp
+    src/highlighter.cpp
+    src/main.cpp
+    )
+
+add_library(texteditor-core STATIC ${SOURCES})
+
+target_include_directories(texteditor-core
+    PUBLIC ${CMAKE_CURRENT_SOURCE_DIR}/include
+    PRIVATE ${CMAKE_CURRENT_SOURCE_DIR}/src
+    )
+
+if(CMAKE_CXX_COMPILER_ID MATCHES "Clang|GNU")
+    target_compile_options(texteditor-core PRIVATE -Wall -Wextra -Wpedantic)
+endif()
+
+if(TEXTEDITOR_USE_SANITIZERS)
+    target_compile_options(texteditor-core PUBLIC -fsanitize=address)
+    target_link_options(texteditor-core PUBLIC -fsanitize=address)
+endif()
+
+find_package(Threads REQUIRED)
+target_link_libraries(texteditor-core PUBLIC Threads::Threads)
+
+add_executable(texteditor src/main.cpp)
+target_link_libraries(texteditor PRIVATE texteditor-core)
+
+function(add_editor_test name)
+    add_executable(${name} tests/${name}.cpp)
+    target_link_libraries(${name} PRIVATE texteditor-core)
+    add_test(NAME ${name} COMMAND ${name})
+endfunction()
+
+if(TEXTEDITOR_BUILD_TESTS)
+    enable_testing()
+    foreach(test buffer_test document_test highlighter_test)
+        add_editor_test(${test})
+    endforeach()
+endif()
+
+install(TARGETS texteditor texteditor-core
+    RUNTIME DESTINATION bin
+    ARCHIVE DESTINATION lib
+    )
+
+message(STATUS "texteditor ${PROJECT_VERSION} (${CMAKE_BUILD_TYPE})")
@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace editor {
+
+template <typename T>
+class RingBuffer {
+public:
+    explicit RingBuffer(size_t capacity) : data_(capacity), head_(0), size_(0) {}
+
+    void push(const T &value) {
+        data_[(head_ + size_) % data_.size()] = value;
+        if (size_ < data_.size()) {
+            ++size_;
+        } else {
+            head_ = (head_ + 1) % data_.size();
+        }
+    }
+
+    std::optional<T> pop() {
+        if (size_ == 0) return std::nullopt;
+        --size_;
+        return data_[(head_ + size_) % data_.size()];
+    }
+
+    [[nodiscard]] size_t size() const noexcept { return size_; }
+
+private:
+    std::vector<T> data_;
+    size_t head_;
+    size_t size_;
+};
+
+struct Change {
+    size_t offset;
+    std::string removed;
+    std::string inserted;
+};
+
+class Document {
+public:
+    explicit Document(std::string text) : text_(std::move(text)), undo_(128) {}
+
+    void replace(size_t offset, size_t length, const std::string &text) {
+        Change change{offset, text_.substr(offset, length), text};
+        text_.replace(offset, length, text);
+        undo_.push(change);
+    }
+
+    bool undo() {
+        auto change = undo_.pop();
+        if (!change) return false;
+        text_.replace(change->offset, change->inserted.size(), change->removed);
+        return true;
+    }
+
+    const std::string &text() const { return text_; }
+
+    std::vector<size_t> lineStarts() const {
+        std::vector<size_t> starts{0};
+        for (size_t i = 0; i < text_.size(); ++i) {
+            if (text_[i] == '\n') starts.push_back(i + 1);
+        }
+        return starts;
+    }
+
+private:
+    std::string text_;
+    RingBuffer<Change> undo_;
+};
+
+class Registry {
+public:
+    using Factory = std::function<std::unique_ptr<Document>(const std::string &)>;
+
+    void add(const std::string &name, Factory factory) {
+        factories_.emplace(name, std::move(factory));
+    }
+
+    std::unique_ptr<Document> create(const std::string &name, const std::string &text) const {
+        auto it = factories_.find(name);
+        return it != factories_.end() ? it->second(text) : nullptr;
+    }
+
+private:
+    std::unordered_map<std::string, Factory> factories_;
+};
+
+} // namespace editor
+
+int main() {
+    editor::Document document("hello\nworld\n");
+    document.replace(0, 5, "goodbye");
+    auto starts = document.lineStarts();
+    std::for_each(starts.begin(), starts.end(), [](size_t start) {
+        std::cout << start << ' ';
+    });
+    std::cout << '\n' << document.text();
+    while (document.undo()) {}
+    std::cout << document.text() << std::endl;
+    return 0;
+}
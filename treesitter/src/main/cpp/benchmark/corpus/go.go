@@ -0,0 +1,105 @@
+package main
+
+import (
+	"bufio"
+	"errors"
+	"fmt"
+	"os"
+	"sort"
+	"strings"
+	"sync"
+)
+
+// Index maps every word to the lines it appears on.
+type Index struct {
+	mu    sync.RWMutex
+	words map[string][]int
+}
+
+var ErrNotFound = errors.New("word not found")
+
+func NewIndex() *Index {
+	return &Index{words: make(map[string][]int)}
+}
+
+func (idx *Index) Add(line int, text string) {
+	idx.mu.Lock()
+	defer idx.mu.Unlock()
+	for _, word := range strings.Fields(text) {
+		word = strings.ToLower(strings.Trim(word, ".,;:!?\"'()"))
+		if word == "" {
+			continue
+		}
+		idx.words[word] = append(idx.words[word], line)
+	}
+}
+
+func (idx *Index) Lookup(word string) ([]int, error) {
+	idx.mu.RLock()
+	defer idx.mu.RUnlock()
+	lines, ok := idx.words[strings.ToLower(word)]
+	if !ok {
+		return nil, fmt.Errorf("lookup %q: %w", word, ErrNotFound)
+	}
+	return lines, nil
+}
+
+type entry struct {
+	word  string
+	count int
+}
+
+func (idx *Index) Top(n int) []entry {
+	idx.mu.RLock()
+	entries := make([]entry, 0, len(idx.words))
+	for word, lines := range idx.words {
+		entries = append(entries, entry{word, len(lines)})
+	}
+	idx.mu.RUnlock()
+	sort.Slice(entries, func(i, j int) bool {
+		if entries[i].count == entries[j].count {
+			return entries[i].word < entries[j].word
+		}
+		return entries[i].count > entries[j].count
+	})
+	if len(entries) > n {
+		entries = entries[:n]
+	}
+	return entries
+}
+
+func main() {
+	idx := NewIndex()
+	scanner := bufio.NewScanner(os.Stdin)
+	lines := make(chan struct {
+		n    int
+		text string
+	}, 64)
+
+	var wg sync.WaitGroup
+	for w := 0; w < 4; w++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for l := range lines {
+				idx.Add(l.n, l.text)
+			}
+		}()
+	}
+
+	for n := 1; scanner.Scan(); n++ {
+		lines <- struct {
+			n    int
+			text string
+		}{n, scanner.Text()}
+	}
+	close(lines)
+	wg.Wait()
+
+	for _, e := range idx.Top(10) {
+		fmt.Printf("%-20s %5d\n", e.word, e.count)
+	}
+	if _, err := idx.Lookup("xyzzy"); errors.Is(err, ErrNotFound) {
+		fmt.Println(err)
+	}
+}
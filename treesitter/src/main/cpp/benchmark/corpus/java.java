@@ -0,0 +1,104 @@
+package x.code.sample;
+
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.HashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.Objects;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.function.Function;
+
+/**
+ * A small least recently used cache with statistics.
+ */
+public final class LruCache<K, V> {
+    private static final int DEFAULT_CAPACITY = 64;
+
+    private final int capacity;
+    private final Map<K, Node<K, V>> map = new HashMap<>();
+    private final Node<K, V> head = new Node<>(null, null);
+    private int hits;
+    private int misses;
+
+    private static final class Node<K, V> {
+        final K key;
+        V value;
+        Node<K, V> prev = this;
+        Node<K, V> next = this;
+
+        Node(K key, V value) {
+            this.key = key;
+            this.value = value;
+        }
+    }
+
+    public LruCache() {
+        this(DEFAULT_CAPACITY);
+    }
+
+    public LruCache(int capacity) {
+        if (capacity <= 0) {
+            throw new IllegalArgumentException("capacity must be positive: " + capacity);
+        }
+        this.capacity = capacity;
+    }
+
+    public synchronized V get(K key, Function<? super K, ? extends V> loader) {
+        Node<K, V> node = map.get(key);
+        if (node != null) {
+            hits++;
+            unlink(node);
+            linkFirst(node);
+            return node.value;
+        }
+        misses++;
+        V value = Objects.requireNonNull(loader.apply(key));
+        node = new Node<>(key, value);
+        map.put(key, node);
+        linkFirst(node);
+        if (map.size() > capacity) {
+            Node<K, V> eldest = head.prev;
+            unlink(eldest);
+            map.remove(eldest.key);
+        }
+        return value;
+    }
+
+    private void unlink(Node<K, V> node) {
+        node.prev.next = node.next;
+        node.next.prev = node.prev;
+    }
+
+    private void linkFirst(Node<K, V> node) {
+        node.next = head.next;
+        node.prev = head;
+        head.next.prev = node;
+        head.next = node;
+    }
+
+    public synchronized List<K> keys() {
+        List<K> keys = new ArrayList<>(map.size());
+        for (Node<K, V> n = head.next; n != head; n = n.next) {
+            keys.add(n.key);
+        }
+        return Collections.unmodifiableList(keys);
+    }
+
+    @Override
+    public String toString() {
+        return String.format("LruCache[size=%d, hits=%d, misses=%d]", map.size(), hits, misses);
+    }
+
+    public static void main(String[] args) {
+        LruCache<Integer, String> cache = new LruCache<>(3);
+        Map<Integer, Integer> loads = new ConcurrentHashMap<>();
+        for (int i : new int[] {1, 2, 3, 1, 4, 2, 5, 1}) {
+            cache.get(i, k -> {
+                loads.merge(k, 1, Integer::sum);
+                return "value-" + k;
+            });
+        }
+        System.out.println(cache + " " + cache.keys() + " " + loads);
+    }
+}
@@ -0,0 +1,68 @@
+'use strict';
+
+const DEFAULT_OPTIONS = Object.freeze({
+  delay: 150,
+  maxItems: 20,
+  caseSensitive: false,
+});
+
+/**
+ * Debounce a function call.
+ */
+function debounce(fn, delay) {
+  let timer = null;
+  return function (...args) {
+    clearTimeout(timer);
+    timer = setTimeout(() => fn.apply(this, args), delay);
+  };
+}
+
+class Autocomplete extends EventTarget {
+  #items = [];
+  #options;
+
+  constructor(input, source, options = {}) {
+    super();
+    this.input = input;
+    this.source = source;
+    this.#options = { ...DEFAULT_OPTIONS, ...options };
+    this.input.addEventListener('input', debounce(() => this.update(), this.#options.delay));
+  }
+
+  get items() {
+    return [...this.#items];
+  }
+
+  async update() {
+    const query = this.#options.caseSensitive ? this.input.value : this.input.value.toLowerCase();
+    if (query.length === 0) {
+      this.#items = [];
+      return;
+    }
+    try {
+      const words = typeof this.source === 'function' ? await this.source(query) : this.source;
+      this.#items = words
+        .filter((word) => (this.#options.caseSensitive ? word : word.toLowerCase()).includes(query))
+        .sort((a, b) => a.length - b.length || a.localeCompare(b))
+        .slice(0, this.#options.maxItems);
+      this.dispatchEvent(new CustomEvent('change', { detail: { query, items: this.items } }));
+    } catch (error) {
+      console.error(`autocomplete failed for "${query}":`, error);
+    }
+  }
+}
+
+async function fetchWords(query) {
+  const response = await fetch(`/api/words?q=${encodeURIComponent(query)}`);
+  if (!response.ok) throw new Error(`HTTP ${response.status}`);
+  const { words = [] } = await response.json();
+  return words;
+}
+
+const pattern = /^[a-z_][\w$]*$/i;
+const counts = new Map();
+for (const word of ['alpha', 'beta', 'gamma', '1delta']) {
+  counts.set(word, pattern.test(word) ? word.length : -1);
+}
+
+module.exports = { Autocomplete, debounce, fetchWords, counts };
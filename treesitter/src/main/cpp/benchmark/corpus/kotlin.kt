@@ -0,0 +1,79 @@
+package x.code.sample
+
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.flow
+import kotlinx.coroutines.flow.flowOn
+import kotlinx.coroutines.runBlocking
+import java.io.File
+
+/** A line of text with its number. */
+data class Line(val number: Int, val text: String)
+
+sealed interface Match {
+    val line: Line
+
+    data class Exact(override val line: Line, val column: Int) : Match
+    data class Fuzzy(override val line: Line, val score: Double) : Match
+}
+
+enum class Mode { EXACT, FUZZY }
+
+class Searcher(private val mode: Mode = Mode.EXACT) {
+
+    private var searched = 0L
+
+    val count: Long
+        get() = searched
+
+    fun search(lines: Sequence<Line>, query: String): Flow<Match> = flow {
+        for (line in lines) {
+            searched++
+            val match = when (mode) {
+                Mode.EXACT -> line.text.indexOf(query).takeIf { it >= 0 }?.let { Match.Exact(line, it) }
+                Mode.FUZZY -> score(line.text, query).takeIf { it > 0.5 }?.let { Match.Fuzzy(line, it) }
+            }
+            match?.let { emit(it) }
+        }
+    }.flowOn(Dispatchers.Default)
+
+    private fun score(text: String, query: String): Double {
+        if (query.isEmpty()) return 0.0
+        var index = 0
+        for (c in text) {
+            if (index < query.length && c.equals(query[index], ignoreCase = true)) index++
+        }
+        return index.toDouble() / query.length
+    }
+
+    companion object {
+        const val MAX_RESULTS = 100
+
+        fun lines(file: File): Sequence<Line> =
+            file.bufferedReader().lineSequence().mapIndexed { i, text -> Line(i + 1, text) }
+    }
+}
+
+inline fun <T> measure(label: String, block: () -> T): T {
+    val start = System.nanoTime()
+    return block().also {
+        println("$label took ${(System.nanoTime() - start) / 1_000_000} ms")
+    }
+}
+
+fun main(args: Array<String>) = runBlocking {
+    val file = File(args.firstOrNull() ?: "README.md")
+    val searcher = Searcher(Mode.FUZZY)
+    measure("search") {
+        var results = 0
+        searcher.search(Searcher.lines(file), "tree").collect { match ->
+            if (results++ < Searcher.MAX_RESULTS) {
+                when (match) {
+                    is Match.Exact -> println("${match.line.number}:${match.column} ${match.line.text}")
+                    is Match.Fuzzy -> println("${match.line.number} (${"%.2f".format(match.score)})")
+                }
+            }
+        }
+    }
+    println("searched ${searcher.count} lines")
+}
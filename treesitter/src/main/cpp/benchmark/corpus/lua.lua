@@ -0,0 +1,65 @@
+-- a tiny event emitter with priority queues
+
+local Emitter = {}
+Emitter.__index = Emitter
+
+local function insert_sorted(list, item)
+  local i = #list
+  while i > 0 and list[i].priority < item.priority do
+    list[i + 1] = list[i]
+    i = i - 1
+  end
+  list[i + 1] = item
+end
+
+function Emitter.new()
+  return setmetatable({ handlers = {}, counts = {} }, Emitter)
+end
+
+function Emitter:on(event, fn, priority)
+  local handlers = self.handlers[event]
+  if not handlers then
+    handlers = {}
+    self.handlers[event] = handlers
+  end
+  insert_sorted(handlers, { fn = fn, priority = priority or 0 })
+  return self
+end
+
+function Emitter:off(event, fn)
+  local handlers = self.handlers[event] or {}
+  for i = #handlers, 1, -1 do
+    if handlers[i].fn == fn then
+      table.remove(handlers, i)
+    end
+  end
+end
+
+function Emitter:emit(event, ...)
+  self.counts[event] = (self.counts[event] or 0) + 1
+  for _, handler in ipairs(self.handlers[event] or {}) do
+    local ok, err = pcall(handler.fn, ...)
+    if not ok then
+      io.stderr:write(string.format("handler for %q failed: %s\n", event, err))
+    end
+  end
+end
+
+local emitter = Emitter.new()
+emitter:on("save", function(name) print("saving " .. name) end, 10)
+emitter:on("save", function(name)
+  if #name == 0 then error("empty name") end
+  print(("saved %s (%d bytes)"):format(name, #name * 42))
+end)
+
+for _, name in ipairs({ "init.lua", "", "plugins.lua" }) do
+  emitter:emit("save", name)
+end
+
+local total = 0
+for event, count in pairs(emitter.counts) do
+  total = total + count
+end
+print([[total events:]], total, 0x1F, 3.5e2)
+
+return Emitter
@@ -0,0 +1,54 @@
+# build the native libraries for the host
+
+CC      ?= cc
+CXX     ?= c++
+CFLAGS  ?= -O2 -g
+CXXFLAGS := $(CFLAGS) -std=c++17 -Wall -Wextra
+PREFIX  ?= /usr/local
+
+SRC_DIR   := src
+BUILD_DIR := build
+SOURCES   := $(wildcard $(SRC_DIR)/*.c) $(wildcard $(SRC_DIR)/*.cpp)
+OBJECTS   := $(patsubst $(SRC_DIR)/%,$(BUILD_DIR)/%.o,$(SOURCES))
+DEPS      := $(OBJECTS:.o=.d)
+
+ifeq ($(shell uname -s),Darwin)
+    SHARED_EXT := dylib
+    LDFLAGS += -dynamiclib
+else
+    SHARED_EXT := so
+    LDFLAGS += -shared -Wl,--no-undefined
+endif
+
+TARGET := $(BUILD_DIR)/libeditor.$(SHARED_EXT)
+
+.PHONY: all clean install test
+
+all: $(TARGET)
+
+$(TARGET): $(OBJECTS)
+	@mkdir -p $(@D)
+	$(CXX) $(LDFLAGS) -o $@ $^ $(LDLIBS)
+
+$(BUILD_DIR)/%.c.o: $(SRC_DIR)/%.c
+	@mkdir -p $(@D)
+	$(CC) $(CFLAGS) -fPIC -MMD -MP -c $< -o $@
+
+$(BUILD_DIR)/%.cpp.o: $(SRC_DIR)/%.cpp
+	@mkdir -p $(@D)
+	$(CXX) $(CXXFLAGS) -fPIC -MMD -MP -c $< -o $@
+
+test: $(TARGET)
+	@for t in tests/*.sh; do \
+	    echo "running $$t"; \
+	    sh $$t || exit 1; \
+	done
+
+install: $(TARGET)
+	install -d $(DESTDIR)$(PREFIX)/lib
+	install -m 644 $(TARGET) $(DESTDIR)$(PREFIX)/lib/
+
+clean:
+	$(RM) -r $(BUILD_DIR)
+
+-include $(DEPS)
@@ -0,0 +1,72 @@
+"""Summarize the benchmark results of several runs."""
+
+from __future__ import annotations
+
+import argparse
+import json
+import statistics
+import sys
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Iterable
+
+
+@dataclass
+class Sample:
+    language: str
+    parse_ms: list[float] = field(default_factory=list)
+    reparse_us: list[float] = field(default_factory=list)
+
+    @property
+    def median_parse(self) -> float:
+        return statistics.median(self.parse_ms) if self.parse_ms else 0.0
+
+    def regression(self, baseline: "Sample", threshold: float = 0.1) -> bool:
+        if not baseline.parse_ms:
+            return False
+        return self.median_parse > baseline.median_parse * (1 + threshold)
+
+
+def load(paths: Iterable[Path]) -> dict[str, Sample]:
+    samples: dict[str, Sample] = {}
+    for path in paths:
+        with path.open(encoding="utf-8") as f:
+            data = json.load(f)
+        for result in data.get("results", []):
+            sample = samples.setdefault(result["language"], Sample(result["language"]))
+            sample.parse_ms.append(result["parse_ms"])
+            sample.reparse_us.append(result.get("reparse_p50_us", 0.0))
+    return samples
+
+
+def main(argv: list[str] | None = None) -> int:
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("runs", nargs="+", type=Path)
+    parser.add_argument("--baseline", type=Path)
+    parser.add_argument("--threshold", type=float, default=0.1)
+    args = parser.parse_args(argv)
+
+    current = load(args.runs)
+    baseline = load([args.baseline]) if args.baseline else {}
+    failed = 0
+
+    print(f"{'language':<12}{'parse ms':>10}{'reparse us':>12}")
+    for name, sample in sorted(current.items()):
+        reparse = statistics.mean(sample.reparse_us) if sample.reparse_us else 0
+        flag = ""
+        if name in baseline and sample.regression(baseline[name], args.threshold):
+            flag = "  <-- regression"
+            failed += 1
+        print(f"{name:<12}{sample.median_parse:>10.3f}{reparse:>12.1f}{flag}")
+
+    squares = {k: v for k, v in ((s.language, s.median_parse ** 2) for s in current.values()) if v}
+    assert all(v >= 0 for v in squares.values())
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    try:
+        sys.exit(main())
+    except (OSError, json.JSONDecodeError) as error:
+        print(f"error: {error}", file=sys.stderr)
+        sys.exit(2)
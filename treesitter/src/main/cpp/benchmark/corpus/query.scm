@@ -0,0 +1,69 @@
+; keywords
+[
+  "break"
+  "case"
+  "continue"
+  "default"
+  "return"
+] @keyword
+
+(function_declaration
+  name: (identifier) @function)
+
+(call_expression
+  function: (identifier) @function.call)
+
+(call_expression
+  function: (member_expression
+    property: (property_identifier) @method.call))
+
+((identifier) @constant
+  (#match? @constant "^[A-Z][A-Z_0-9]*$"))
+
+((identifier) @variable.builtin
+  (#any-of? @variable.builtin "self" "this" "super"))
+
+(parameter
+  name: (identifier) @parameter)
+
+[
+  (string)
+  (template_string)
+] @string
+
+(escape_sequence) @string.escape
+
+(number) @number
+
+[
+  (true)
+  (false)
+] @boolean
+
+(comment) @comment @spell
+
+[
+  "("
+  ")"
+  "["
+  "]"
+  "{"
+  "}"
+] @punctuation.bracket
+
+(binary_expression
+  operator: _ @operator)
+
+(pair
+  key: (property_identifier) @property
+  value: [(arrow_function) (function_expression)] @function)
+
+((comment) @injection.content
+  (#lua-match? @injection.content "^/[*][*][^*].*[*]/$")
+  (#set! injection.language "jsdoc"))
+
+(class_declaration
+  name: (_) @type
+  body: (class_body
+    (method_definition
+      name: (property_identifier) @constructor (#eq? @constructor "constructor"))?))
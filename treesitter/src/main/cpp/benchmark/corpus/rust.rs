@@ -0,0 +1,102 @@
+use std::collections::BTreeMap;
+use std::fmt;
+use std::io::{self, BufRead, Write};
+
+/// A span of bytes in the source text.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, PartialOrd, Ord)]
+pub struct Span {
+    pub start: usize,
+    pub end: usize,
+}
+
+#[derive(Debug)]
+pub enum Error {
+    Io(io::Error),
+    Parse { line: usize, message: String },
+}
+
+impl fmt::Display for Error {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        match self {
+            Error::Io(err) => write!(f, "io error: {err}"),
+            Error::Parse { line, message } => write!(f, "line {line}: {message}"),
+        }
+    }
+}
+
+impl From<io::Error> for Error {
+    fn from(err: io::Error) -> Self {
+        Error::Io(err)
+    }
+}
+
+pub trait Visitor {
+    fn visit(&mut self, key: &str, value: i64, span: Span);
+}
+
+#[derive(Default)]
+struct Totals<'a> {
+    names: BTreeMap<&'a str, i64>,
+}
+
+fn parse_line(line: &str, number: usize) -> Result<(String, i64), Error> {
+    let (key, value) = line
+        .split_once('=')
+        .ok_or_else(|| Error::Parse { line: number, message: "missing '='".into() })?;
+    let value = value.trim().parse::<i64>().map_err(|e| Error::Parse {
+        line: number,
+        message: e.to_string(),
+    })?;
+    Ok((key.trim().to_owned(), value))
+}
+
+struct Printer<W: Write> {
+    out: W,
+    offset: usize,
+}
+
+impl<W: Write> Visitor for Printer<W> {
+    fn visit(&mut self, key: &str, value: i64, span: Span) {
+        let _ = writeln!(self.out, "{:>4}..{:<4} {key} = {value:#x}", span.start, span.end);
+        self.offset = span.end;
+    }
+}
+
+fn main() -> Result<(), Error> {
+    let stdin = io::stdin();
+    let mut printer = Printer { out: io::stdout().lock(), offset: 0 };
+    let mut entries: Vec<(String, i64)> = Vec::new();
+    let mut offset = 0usize;
+
+    for (i, line) in stdin.lock().lines().enumerate() {
+        let line = line?;
+        let len = line.len();
+        if line.starts_with('#') || line.trim().is_empty() {
+            offset += len + 1;
+            continue;
+        }
+        let (key, value) = parse_line(&line, i + 1)?;
+        printer.visit(&key, value, Span { start: offset, end: offset + len });
+        entries.push((key, value));
+        offset += len + 1;
+    }
+
+    let mut totals = Totals::default();
+    for (key, value) in &entries {
+        *totals.names.entry(key.as_str()).or_insert(0) += value;
+    }
+    let max = totals.names.values().copied().max().unwrap_or(0);
+    println!("{} keys, max {max}, last offset {}", totals.names.len(), printer.offset);
+    Ok(())
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn parses_key_value() {
+        assert_eq!(parse_line("a = 42", 1).unwrap(), ("a".to_string(), 42));
+        assert!(matches!(parse_line("a", 2), Err(Error::Parse { line: 2, .. })));
+    }
+}
@@ -0,0 +1,101 @@
+import Foundation
+
+/// A token produced by the lexer.
+struct Token: Equatable, CustomStringConvertible {
+    enum Kind: String {
+        case identifier, number, symbol
+    }
+
+    let kind: Kind
+    let text: Substring
+
+    var description: String { "\(kind.rawValue)(\(text))" }
+}
+
+protocol Lexing {
+    mutating func next() -> Token?
+}
+
+struct Lexer: Lexing, Sequence, IteratorProtocol {
+    private let source: String
+    private var index: String.Index
+
+    init(_ source: String) {
+        self.source = source
+        self.index = source.startIndex
+    }
+
+    mutating func next() -> Token? {
+        while index < source.endIndex, source[index].isWhitespace {
+            index = source.index(after: index)
+        }
+        guard index < source.endIndex else { return nil }
+
+        let start = index
+        let first = source[index]
+        let kind: Token.Kind
+        if first.isLetter || first == "_" {
+            kind = .identifier
+            advance { $0.isLetter || $0.isNumber || $0 == "_" }
+        } else if first.isNumber {
+            kind = .number
+            advance { $0.isNumber || $0 == "." }
+        } else {
+            kind = .symbol
+            index = source.index(after: index)
+        }
+        return Token(kind: kind, text: source[start..<index])
+    }
+
+    private mutating func advance(while predicate: (Character) -> Bool) {
+        while index < source.endIndex && predicate(source[index]) {
+            index = source.index(after: index)
+        }
+    }
+}
+
+enum EvaluationError: Error {
+    case unexpected(Token)
+    case divisionByZero
+}
+
+final class Calculator {
+    private(set) var history: [Double] = []
+
+    func evaluate(_ expression: String) throws -> Double {
+        var tokens = Array(Lexer(expression))
+        var result = try number(from: tokens.removeFirst())
+        while tokens.count >= 2 {
+            let op = tokens.removeFirst()
+            let rhs = try number(from: tokens.removeFirst())
+            switch op.text {
+            case "+": result += rhs
+            case "-": result -= rhs
+            case "*": result *= rhs
+            case "/":
+                guard rhs != 0 else { throw EvaluationError.divisionByZero }
+                result /= rhs
+            default: throw EvaluationError.unexpected(op)
+            }
+        }
+        history.append(result)
+        return result
+    }
+
+    private func number(from token: Token) throws -> Double {
+        guard token.kind == .number, let value = Double(token.text) else {
+            throw EvaluationError.unexpected(token)
+        }
+        return value
+    }
+}
+
+let calculator = Calculator()
+for expression in ["1 + 2 * 3", "10 / 0", "4 % 2"] {
+    do {
+        print("\(expression) = \(try calculator.evaluate(expression))")
+    } catch let error as EvaluationError {
+        print("\(expression): \(error)")
+    }
+}
+print(calculator.history.map { String(format: "%.1f", $0) }.joined(separator: ", "))
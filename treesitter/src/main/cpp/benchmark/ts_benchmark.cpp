@@ -0,0 +1,273 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// host benchmark of the bundled grammars, measures the cold parse,
+// incremental reparse and highlight query throughput of every corpus file
+//
+// usage: ts-benchmark [--corpus dir] [--queries dir] [--iterations n]
+//                     [--edits n] [--language name] [--output file]
+
+#include "bench_utils.h"
+#include "../ts_language.h"
+
+extern struct TSFunction __start_ss;
+extern struct TSFunction __stop_ss;
+
+using namespace bench;
+
+struct Options {
+    fs::path corpus = TS_BENCHMARK_CORPUS;
+    fs::path queries = TS_BENCHMARK_QUERIES;
+    int iterations = 10;
+    int edits = 200;
+    std::string language;
+    std::string output;
+};
+
+struct Result {
+    std::string language;
+    std::string corpus;
+    size_t bytes = 0;
+    double parse_ms = 0;
+    double parse_mb_s = 0;
+    double reparse_p50_us = 0;
+    double reparse_p95_us = 0;
+    double reparse_max_us = 0;
+    uint64_t query_captures = 0;
+    double query_captures_s = 0;
+    std::string query_error;
+    size_t peak_memory_bytes = 0;
+    bool has_error = false;
+};
+
+// find the corpus file of the grammar, like `corpus/rust.rs`
+static fs::path find_corpus(const fs::path &dir, const std::string &name) {
+    std::error_code ec;
+    for (const auto &entry : fs::directory_iterator(dir, ec)) {
+        if (entry.is_regular_file() && entry.path().stem() == name)
+            return entry.path();
+    }
+    return fs::path();
+}
+
+static TSTree *parse(TSParser *parser, TSTree *old_tree, const std::string &text) {
+    return ts_parser_parse_string(
+        parser, old_tree, text.data(), static_cast<uint32_t>(text.size())
+    );
+}
+
+static void bench_parse(Result &result, TSParser *parser, const std::string &text, int iterations) {
+    std::vector<double> samples;
+    for (int i = 0; i < iterations; ++i) {
+        memory.reset();
+        auto start = clock::now();
+        TSTree *tree = parse(parser, nullptr, text);
+        samples.push_back(elapsed_micros(start));
+        result.peak_memory_bytes = std::max(result.peak_memory_bytes, memory.peak_bytes);
+        result.has_error = ts_node_has_error(ts_tree_root_node(tree));
+        ts_tree_delete(tree);
+    }
+    result.parse_ms = percentile(samples, 50) / 1000.0;
+    if (result.parse_ms > 0)
+        result.parse_mb_s = text.size() / (1024.0 * 1024.0) / (result.parse_ms / 1000.0);
+}
+
+// alternately insert and delete a character at the pseudo random offsets,
+// every edit is followed by an incremental reparse of the whole file
+static void bench_reparse(Result &result, TSParser *parser, std::string text, int edits) {
+    TSTree *tree = parse(parser, nullptr, text);
+    std::vector<double> samples;
+    uint32_t seed = 0x2545f491;
+    uint32_t offset = 0;
+
+    for (int i = 0; i < edits && !text.empty(); ++i) {
+        TSInputEdit edit;
+        if (i % 2 == 0) {
+            // a fixed linear congruential generator keeps the runs comparable
+            seed = seed * 1664525u + 1013904223u;
+            offset = seed % static_cast<uint32_t>(text.size());
+            edit.start_byte = offset;
+            edit.old_end_byte = offset;
+            edit.new_end_byte = offset + 1;
+            edit.start_point = point_at(text, offset);
+            edit.old_end_point = edit.start_point;
+            edit.new_end_point = {edit.start_point.row, edit.start_point.column + 1};
+            text.insert(offset, 1, 'x');
+        } else {
+            // delete the character inserted above
+            edit.start_byte = offset;
+            edit.old_end_byte = offset + 1;
+            edit.new_end_byte = offset;
+            edit.start_point = point_at(text, offset);
+            edit.old_end_point = {edit.start_point.row, edit.start_point.column + 1};
+            edit.new_end_point = edit.start_point;
+            text.erase(offset, 1);
+        }
+
+        auto start = clock::now();
+        ts_tree_edit(tree, &edit);
+        TSTree *new_tree = parse(parser, tree, text);
+        samples.push_back(elapsed_micros(start));
+        ts_tree_delete(tree);
+        tree = new_tree;
+    }
+    ts_tree_delete(tree);
+
+    result.reparse_p50_us = percentile(samples, 50);
+    result.reparse_p95_us = percentile(samples, 95);
+    result.reparse_max_us = percentile(samples, 100);
+}
+
+static void bench_query(Result &result, TSParser *parser, const TSLanguage *language,
+                        const std::string &text, const std::string &source, int iterations) {
+    if (source.empty()) {
+        result.query_error = "no highlights.scm";
+        return;
+    }
+
+    uint32_t error_offset;
+    TSQueryError error_type;
+    TSQuery *query = ts_query_new(
+        language, source.data(), static_cast<uint32_t>(source.size()), &error_offset, &error_type
+    );
+    if (query == nullptr) {
+        // the query may be written for a newer grammar than the bundled one
+        result.query_error = "query error " + std::to_string(error_type) +
+            " at offset " + std::to_string(error_offset);
+        return;
+    }
+
+    TSTree *tree = parse(parser, nullptr, text);
+    TSQueryCursor *cursor = ts_query_cursor_new();
+    std::vector<double> samples;
+    for (int i = 0; i < iterations; ++i) {
+        auto start = clock::now();
+        result.query_captures = count_captures(cursor, query, tree);
+        samples.push_back(elapsed_micros(start));
+    }
+    double micros = percentile(samples, 50);
+    if (micros > 0)
+        result.query_captures_s = result.query_captures / (micros / 1000000.0);
+
+    ts_query_cursor_delete(cursor);
+    ts_tree_delete(tree);
+    ts_query_delete(query);
+}
+
+static std::string escape(const std::string &value) {
+    std::string escaped;
+    for (char c : value) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+static void print_json(FILE *out, const Options &options, const std::vector<Result> &results) {
+    fprintf(out, "{\n  \"benchmark\": \"ts-benchmark\",\n");
+    fprintf(out, "  \"iterations\": %d,\n  \"edits\": %d,\n", options.iterations, options.edits);
+    fprintf(out, "  \"results\": [");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result &r = results[i];
+        fprintf(out, "%s\n    {", i == 0 ? "" : ",");
+        fprintf(out, "\"language\": \"%s\", ", escape(r.language).c_str());
+        fprintf(out, "\"corpus\": \"%s\", ", escape(r.corpus).c_str());
+        fprintf(out, "\"bytes\": %zu, ", r.bytes);
+        fprintf(out, "\"parse_ms\": %.3f, ", r.parse_ms);
+        fprintf(out, "\"parse_mb_s\": %.2f, ", r.parse_mb_s);
+        fprintf(out, "\"reparse_p50_us\": %.1f, ", r.reparse_p50_us);
+        fprintf(out, "\"reparse_p95_us\": %.1f, ", r.reparse_p95_us);
+        fprintf(out, "\"reparse_max_us\": %.1f, ", r.reparse_max_us);
+        fprintf(out, "\"query_captures\": %llu, ", static_cast<unsigned long long>(r.query_captures));
+        fprintf(out, "\"query_captures_s\": %.0f, ", r.query_captures_s);
+        if (!r.query_error.empty())
+            fprintf(out, "\"query_error\": \"%s\", ", escape(r.query_error).c_str());
+        fprintf(out, "\"peak_memory_bytes\": %zu, ", r.peak_memory_bytes);
+        fprintf(out, "\"has_error\": %s}", r.has_error ? "true" : "false");
+    }
+    fprintf(out, "\n  ]\n}\n");
+}
+
+static bool parse_options(int argc, char **argv, Options &options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            fprintf(stderr, "missing value of option %s\n", arg.c_str());
+            return false;
+        }
+        const char *value = argv[++i];
+        if (arg == "--corpus") options.corpus = value;
+        else if (arg == "--queries") options.queries = value;
+        else if (arg == "--iterations") options.iterations = std::max(1, atoi(value));
+        else if (arg == "--edits") options.edits = std::max(0, atoi(value));
+        else if (arg == "--language") options.language = value;
+        else if (arg == "--output") options.output = value;
+        else {
+            fprintf(stderr, "unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) return 2;
+
+    install_counting_allocator();
+    std::vector<Result> results;
+
+    for (TSFunction *fn = &__start_ss; fn < &__stop_ss; ++fn) {
+        // strip the `tree_sitter_` prefix
+        std::string name = fn->name + 12;
+        if (!options.language.empty() && options.language != name) continue;
+
+        fs::path path = find_corpus(options.corpus, name);
+        if (path.empty()) {
+            fprintf(stderr, "skip %s: no corpus file\n", name.c_str());
+            continue;
+        }
+
+        Result result;
+        result.language = name;
+        result.corpus = path.filename().string();
+        std::string text = read_file(path);
+        result.bytes = text.size();
+
+        const TSLanguage *language = fn->invoke();
+        TSParser *parser = ts_parser_new();
+        ts_parser_set_language(parser, language);
+
+        bench_parse(result, parser, text, options.iterations);
+        bench_reparse(result, parser, text, options.edits);
+        bench_query(result, parser, language, text,
+                    read_query(options.queries, name, "highlights"), options.iterations);
+
+        ts_parser_delete(parser);
+        results.push_back(result);
+        fprintf(stderr, "%-12s %8zu bytes %9.3f ms %8.1f us\n",
+                name.c_str(), result.bytes, result.parse_ms, result.reparse_p50_us);
+    }
+
+    FILE *out = stdout;
+    if (!options.output.empty() && (out = fopen(options.output.c_str(), "w")) == nullptr) {
+        fprintf(stderr, "cannot open %s: %s\n", options.output.c_str(), strerror(errno));
+        return 1;
+    }
+    print_json(out, options, results);
+    if (out != stdout) fclose(out);
+    return 0;
+}
@@ -0,0 +1,352 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// replay the edit trace recorded by TSEditRecorder, every batch of edits
+// is followed by a reparse and a highlight query of the lines around the edit,
+// which is the latency felt by the user after each keystroke
+//
+// usage: ts-replay [--queries dir] [--viewport lines] [--repeat n]
+//                  [--output file] trace...
+
+#include "bench_utils.h"
+#include "../ts_language.h"
+#include "../ts_offset_index.h"
+
+extern struct TSFunction __start_ss;
+extern struct TSFunction __stop_ss;
+
+using namespace bench;
+
+// the number of jint values of a packed edit, see TSTree.EDIT_STRIDE
+#define EDIT_STRIDE 9
+
+// the offsets and the columns are UTF-16 code units, same as TSOffsetIndex.edit
+struct Edit {
+    int32_t values[EDIT_STRIDE];
+    std::u16string text;
+};
+
+struct Batch {
+    uint32_t delay_micros;
+    std::vector<Edit> edits;
+};
+
+struct Trace {
+    std::string language;
+    std::u16string text;
+    std::vector<Batch> batches;
+};
+
+struct Options {
+    fs::path queries = TS_BENCHMARK_QUERIES;
+    uint32_t viewport = 50;
+    int repeat = 1;
+    std::string output;
+    std::vector<std::string> traces;
+};
+
+struct Result {
+    std::string trace;
+    std::string language;
+    size_t batches = 0;
+    size_t edits = 0;
+    std::vector<double> reparse_us;
+    std::vector<double> query_us;
+    std::vector<double> total_us;
+    std::string query_error;
+    bool has_error = false;
+};
+
+class Reader {
+public:
+    explicit Reader(const std::string &data) : data_(data), offset_(0) {}
+
+    bool done() const { return offset_ >= data_.size(); }
+
+    // the trace is always little endian, same as the android devices
+    uint32_t u32() {
+        uint32_t value = 0;
+        if (offset_ + sizeof value > data_.size())
+            throw std::runtime_error("truncated trace");
+        memcpy(&value, data_.data() + offset_, sizeof value);
+        offset_ += sizeof value;
+        return value;
+    }
+
+    std::string bytes(size_t length) {
+        if (offset_ + length > data_.size())
+            throw std::runtime_error("truncated trace");
+        std::string value = data_.substr(offset_, length);
+        offset_ += length;
+        return value;
+    }
+
+    std::u16string utf16() {
+        std::string value = bytes(static_cast<size_t>(u32()) * 2);
+        std::u16string text(value.size() / 2, u'\0');
+        memcpy(text.data(), value.data(), value.size());
+        return text;
+    }
+
+private:
+    const std::string &data_;
+    size_t offset_;
+};
+
+static Trace read_trace(const fs::path &path) {
+    std::string data = read_file(path);
+    Reader reader(data);
+    if (reader.bytes(4) != "TSTR")
+        throw std::runtime_error("not an edit trace");
+    // the version 1 traces have the offsets and the columns in UTF-16 bytes
+    uint32_t version = reader.u32();
+    if (version != 1 && version != 2)
+        throw std::runtime_error("unsupported trace version " + std::to_string(version));
+
+    Trace trace;
+    trace.language = reader.bytes(reader.u32());
+    trace.text = reader.utf16();
+    while (!reader.done()) {
+        Batch batch;
+        batch.delay_micros = reader.u32();
+        uint32_t count = reader.u32();
+        for (uint32_t i = 0; i < count; ++i) {
+            Edit edit;
+            for (int j = 0; j < EDIT_STRIDE; ++j) {
+                edit.values[j] = static_cast<int32_t>(reader.u32());
+                // the rows are 3, 5 and 7
+                if (version == 1 && j != 3 && j != 5 && j != 7) edit.values[j] /= 2;
+            }
+            edit.text = reader.utf16();
+            batch.edits.push_back(std::move(edit));
+        }
+        trace.batches.push_back(std::move(batch));
+    }
+    return trace;
+}
+
+static const TSLanguage *find_language(const std::string &name) {
+    for (TSFunction *fn = &__start_ss; fn < &__stop_ss; ++fn) {
+        // strip the `tree_sitter_` prefix
+        if (name == fn->name + 12) return fn->invoke();
+    }
+    return nullptr;
+}
+
+// parse the UTF-8 blocks of the offset index, same as TSParser.parse in the app
+static TSTree *parse(TSParser *parser, TSTree *old_tree, const TSOffsetIndex &index) {
+    auto read = [](void *payload, uint32_t byte_index, TSPoint, uint32_t *bytes_read) {
+        return reinterpret_cast<const TSOffsetIndex*>(payload)->segment(byte_index, bytes_read);
+    };
+    return ts_parser_parse(
+        parser, old_tree, {const_cast<TSOffsetIndex*>(&index), read, TSInputEncodingUTF8}
+    );
+}
+
+// apply the UTF-16 edit to the index and translate it to UTF-8 bytes,
+// same as TSOffsetIndex.edit in the app, the columns are translated
+// from the line starts, which are looked up before the text is changed
+static TSInputEdit translate(TSOffsetIndex &index, const Edit &edit) {
+    const int32_t *values = edit.values;
+    uint32_t start16 = static_cast<uint32_t>(values[0]);
+    uint32_t old_end16 = static_cast<uint32_t>(values[1]);
+    uint32_t new_end16 = static_cast<uint32_t>(values[2]);
+    uint32_t start_line8 = index.to_utf8(start16 - std::min<uint32_t>(values[4], start16));
+    uint32_t old_end_line8 = index.to_utf8(old_end16 - std::min<uint32_t>(values[6], old_end16));
+
+    uint32_t start8, old_end8, new_end8;
+    index.edit(start16, old_end16, edit.text.data(), static_cast<uint32_t>(edit.text.size()),
+               &start8, &old_end8, &new_end8);
+    uint32_t new_end_line8 = index.to_utf8(new_end16 - std::min<uint32_t>(values[8], new_end16));
+    return TSInputEdit {
+        .start_byte = start8,
+        .old_end_byte = old_end8,
+        .new_end_byte = new_end8,
+        .start_point = {static_cast<uint32_t>(values[3]), start8 - start_line8},
+        .old_end_point = {static_cast<uint32_t>(values[5]), old_end8 - old_end_line8},
+        .new_end_point = {static_cast<uint32_t>(values[7]), new_end8 - new_end_line8}
+    };
+}
+
+static void replay(Result &result, const Trace &trace, const Options &options) {
+    const TSLanguage *language = find_language(trace.language);
+    if (language == nullptr)
+        throw std::runtime_error("unknown language " + trace.language);
+
+    TSParser *parser = ts_parser_new();
+    ts_parser_set_language(parser, language);
+
+    TSQuery *query = nullptr;
+    std::string source = read_query(options.queries, trace.language, "highlights");
+    if (!source.empty()) {
+        uint32_t error_offset;
+        TSQueryError error_type;
+        query = ts_query_new(
+            language, source.data(), static_cast<uint32_t>(source.size()), &error_offset, &error_type
+        );
+        if (query == nullptr)
+            result.query_error = "query error " + std::to_string(error_type) +
+                " at offset " + std::to_string(error_offset);
+    } else {
+        result.query_error = "no highlights.scm";
+    }
+    TSQueryCursor *cursor = ts_query_cursor_new();
+    std::vector<TSInputEdit> inputs;
+
+    for (int round = 0; round < options.repeat; ++round) {
+        TSOffsetIndex index(trace.text.data(), static_cast<uint32_t>(trace.text.size()));
+        TSTree *tree = parse(parser, nullptr, index);
+
+        for (const Batch &batch : trace.batches) {
+            if (batch.edits.empty()) continue;
+            // the text is edited outside the timed region, the editor
+            // has already applied the changes to the text buffer
+            inputs.clear();
+            for (const Edit &edit : batch.edits) inputs.push_back(translate(index, edit));
+
+            auto start = clock::now();
+            for (const TSInputEdit &input : inputs) {
+                ts_tree_edit(tree, &input);
+            }
+            TSTree *new_tree = parse(parser, tree, index);
+            double reparse = elapsed_micros(start);
+            ts_tree_delete(tree);
+            tree = new_tree;
+
+            double highlight = 0;
+            if (query != nullptr) {
+                // highlight the visible lines around the last edit
+                uint32_t row = inputs.back().new_end_point.row;
+                uint32_t first = row > options.viewport / 2 ? row - options.viewport / 2 : 0;
+                ts_query_cursor_set_point_range(
+                    cursor, TSPoint {first, 0}, TSPoint {first + options.viewport, 0}
+                );
+                start = clock::now();
+                count_captures(cursor, query, tree);
+                highlight = elapsed_micros(start);
+            }
+
+            result.reparse_us.push_back(reparse);
+            result.query_us.push_back(highlight);
+            result.total_us.push_back(reparse + highlight);
+        }
+        result.has_error = ts_node_has_error(ts_tree_root_node(tree));
+        ts_tree_delete(tree);
+    }
+
+    ts_query_cursor_delete(cursor);
+    if (query != nullptr) ts_query_delete(query);
+    ts_parser_delete(parser);
+}
+
+static std::string escape(const std::string &value) {
+    std::string escaped;
+    for (char c : value) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+static void print_latency(FILE *out, const char *name, const std::vector<double> &samples) {
+    fprintf(out, "\"%s\": {\"p50\": %.1f, \"p95\": %.1f, \"p99\": %.1f, \"max\": %.1f}",
+            name, percentile(samples, 50), percentile(samples, 95),
+            percentile(samples, 99), percentile(samples, 100));
+}
+
+static void print_json(FILE *out, const Options &options, const std::vector<Result> &results) {
+    fprintf(out, "{\n  \"benchmark\": \"ts-replay\",\n");
+    fprintf(out, "  \"viewport\": %u,\n  \"repeat\": %d,\n", options.viewport, options.repeat);
+    fprintf(out, "  \"results\": [");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result &r = results[i];
+        fprintf(out, "%s\n    {", i == 0 ? "" : ",");
+        fprintf(out, "\"trace\": \"%s\", ", escape(r.trace).c_str());
+        fprintf(out, "\"language\": \"%s\", ", escape(r.language).c_str());
+        fprintf(out, "\"batches\": %zu, \"edits\": %zu,\n     ", r.batches, r.edits);
+        print_latency(out, "reparse_us", r.reparse_us);
+        fprintf(out, ",\n     ");
+        print_latency(out, "query_us", r.query_us);
+        fprintf(out, ",\n     ");
+        print_latency(out, "total_us", r.total_us);
+        if (!r.query_error.empty())
+            fprintf(out, ",\n     \"query_error\": \"%s\"", escape(r.query_error).c_str());
+        fprintf(out, ",\n     \"has_error\": %s}", r.has_error ? "true" : "false");
+    }
+    fprintf(out, "\n  ]\n}\n");
+}
+
+static bool parse_options(int argc, char **argv, Options &options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0) {
+            options.traces.push_back(arg);
+            continue;
+        }
+        if (i + 1 >= argc) {
+            fprintf(stderr, "missing value of option %s\n", arg.c_str());
+            return false;
+        }
+        const char *value = argv[++i];
+        if (arg == "--queries") options.queries = value;
+        else if (arg == "--viewport") options.viewport = static_cast<uint32_t>(std::max(1, atoi(value)));
+        else if (arg == "--repeat") options.repeat = std::max(1, atoi(value));
+        else if (arg == "--output") options.output = value;
+        else {
+            fprintf(stderr, "unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+    if (options.traces.empty()) {
+        fprintf(stderr, "usage: ts-replay [--queries dir] [--viewport lines] "
+                        "[--repeat n] [--output file] trace...\n");
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) return 2;
+
+    std::vector<Result> results;
+    for (const std::string &path : options.traces) {
+        Result result;
+        result.trace = fs::path(path).filename().string();
+        try {
+            Trace trace = read_trace(path);
+            result.language = trace.language;
+            result.batches = trace.batches.size();
+            for (const Batch &batch : trace.batches) result.edits += batch.edits.size();
+            replay(result, trace, options);
+        } catch (const std::exception &e) {
+            fprintf(stderr, "skip %s: %s\n", path.c_str(), e.what());
+            continue;
+        }
+        fprintf(stderr, "%-32s %6zu batches p50 %8.1f us p99 %8.1f us\n", result.trace.c_str(),
+                result.batches, percentile(result.total_us, 50), percentile(result.total_us, 99));
+        results.push_back(std::move(result));
+    }
+
+    FILE *out = stdout;
+    if (!options.output.empty() && (out = fopen(options.output.c_str(), "w")) == nullptr) {
+        fprintf(stderr, "cannot open %s: %s\n", options.output.c_str(), strerror(errno));
+        return 1;
+    }
+    print_json(out, options, results);
+    if (out != stdout) fclose(out);
+    return 0;
+}
@@ -19,6 +19,7 @@
 #include <pthread.h>
 
 #include "ts_utils.h"
+#include "ts_string_table.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -50,6 +51,26 @@ extern const JNINativeMethod TSLanguage_methods[];
 extern const size_t TSLanguage_methods_size;
 extern const JNINativeMethod TSLookaheadIterator_methods[];
 extern const size_t TSLookaheadIterator_methods_size;
+extern const JNINativeMethod TSStats_methods[];
+extern const size_t TSStats_methods_size;
+extern const JNINativeMethod TSOffsetIndex_methods[];
+extern const size_t TSOffsetIndex_methods_size;
+extern const JNINativeMethod TSQueryCursor_methods[];
+extern const size_t TSQueryCursor_methods_size;
+extern const JNINativeMethod TSTreePublisher_methods[];
+extern const size_t TSTreePublisher_methods_size;
+extern const JNINativeMethod TSStyleTable_methods[];
+extern const size_t TSStyleTable_methods_size;
+extern const JNINativeMethod TSDiagnostics_methods[];
+extern const size_t TSDiagnostics_methods_size;
+extern const JNINativeMethod TSLocals_methods[];
+extern const size_t TSLocals_methods_size;
+extern const JNINativeMethod TSContextStack_methods[];
+extern const JNINativeMethod TSCompletion_methods[];
+extern const JNINativeMethod TSSelection_methods[];
+extern const size_t TSContextStack_methods_size;
+extern const size_t TSCompletion_methods_size;
+extern const size_t TSSelection_methods_size;
 
 #define REGISTER_METHOD(clazz)                  \
     do {                                            \
@@ -66,11 +87,11 @@ extern const size_t TSLookaheadIterator_methods_size;
 #define CACHE_CLASS(package, name)                  \
     do {                                                  \
         jclass local = env->FindClass(package #name);   \
-        if (local == nullptr) {                               \            
+        if (local == nullptr) {                               \
             return JNI_ERR;                                   \
         }                                                       \
         global_class_cache.name = (jclass)env->NewGlobalRef(local); \
-        env->DeleteLocalRef(local);                            \           
+        env->DeleteLocalRef(local);                            \
     } while (0)
 
 #define CACHE_FIELD(clazz, field, jtype)                         \
@@ -141,6 +162,7 @@ JNIEXPORT jint JNI_OnLoad(JavaVM *vm, void *reserved) {
     CACHE_FIELD(TSParser, includedRanges, "Ljava/util/List;");
     CACHE_FIELD(TSParser, language, "L" PACKAGE "TSLanguage;");
     CACHE_FIELD(TSParser, logger, "Lkotlin/jvm/functions/Function2;");
+    CACHE_FIELD(TSParser, logCapacity, "I");
     
     CACHE_CLASS(PACKAGE, TSNode);    
     CACHE_FIELD(TSNode, context, "[I");
@@ -207,9 +229,31 @@ JNIEXPORT jint JNI_OnLoad(JavaVM *vm, void *reserved) {
     CACHE_FIELD(TSQuery, captureNames, "Ljava/util/List;");
     CACHE_FIELD(TSQuery, pattern, "Ljava/lang/String;");
     
+    CACHE_CLASS(PACKAGE, TSQueryCursor);
+    CACHE_FIELD(TSQueryCursor, self, "J");
+    
+    CACHE_CLASS(PACKAGE, TSTreeSnapshot);
+    CACHE_METHOD(TSTreeSnapshot, close, "close", "()V");
+    
+    CACHE_CLASS(PACKAGE, TSTreePublisher);
+    CACHE_FIELD(TSTreePublisher, self, "J");
+    
+    CACHE_CLASS(PACKAGE, TSStyleTable);
+    CACHE_FIELD(TSStyleTable, self, "J");
+    CACHE_CLASS(PACKAGE, TSDiagnostics);
+    CACHE_FIELD(TSDiagnostics, self, "J");
+    CACHE_CLASS(PACKAGE, TSLocals);
+    CACHE_FIELD(TSLocals, self, "J");
+    CACHE_CLASS(PACKAGE, TSContextStack);
+    CACHE_FIELD(TSContextStack, self, "J");
+    CACHE_CLASS(PACKAGE, TSCompletion);
+    CACHE_FIELD(TSCompletion, self, "J");
+    CACHE_CLASS(PACKAGE, TSSelection);
+    CACHE_FIELD(TSSelection, self, "J");
+    
     CACHE_CLASS(PACKAGE, TSQueryCapture);
     CACHE_METHOD(TSQueryCapture, init, "<init>", 
-     "(L" PACKAGE "TSNode;Ljava/lang/String;)V");
+     "(L" PACKAGE "TSNode;Ljava/lang/String;I)V");
 
     CACHE_CLASS(PACKAGE, TSQueryMatch);
     CACHE_METHOD(TSQueryMatch, init, "<init>", "(ILjava/util/List;)V");
@@ -229,6 +273,11 @@ JNIEXPORT jint JNI_OnLoad(JavaVM *vm, void *reserved) {
     CACHE_CLASS(PACKAGE, TSQueryError$Structure);
     CACHE_METHOD(TSQueryError$Structure, init, "<init>", "(II)V");
     
+    CACHE_CLASS(PACKAGE, TSStats);
+
+    CACHE_CLASS(PACKAGE, TSOffsetIndex);
+    CACHE_FIELD(TSOffsetIndex, self, "J");
+    
     CACHE_CLASS("java/util/", List);
     CACHE_METHOD(List, size, "size", "()I");
     CACHE_METHOD(List, get, "get", "(I)Ljava/lang/Object;");
@@ -251,6 +300,7 @@ JNIEXPORT jint JNI_OnLoad(JavaVM *vm, void *reserved) {
     CACHE_CLASS("java/lang/", IllegalStateException);
     CACHE_CLASS("java/lang/", IllegalArgumentException);
     CACHE_CLASS("java/lang/", IndexOutOfBoundsException);
+    CACHE_CLASS("java/io/", IOException);
     
     // register native methods
     REGISTER_METHOD(TSQuery);
@@ -260,6 +310,16 @@ JNIEXPORT jint JNI_OnLoad(JavaVM *vm, void *reserved) {
     REGISTER_METHOD(TSTreeCursor);
     REGISTER_METHOD(TSLanguage);
     REGISTER_METHOD(TSLookaheadIterator);
+    REGISTER_METHOD(TSStats);
+    REGISTER_METHOD(TSOffsetIndex);
+    REGISTER_METHOD(TSQueryCursor);
+    REGISTER_METHOD(TSTreePublisher);
+    REGISTER_METHOD(TSStyleTable);
+    REGISTER_METHOD(TSDiagnostics);
+    REGISTER_METHOD(TSLocals);
+    REGISTER_METHOD(TSContextStack);
+    REGISTER_METHOD(TSCompletion);
+    REGISTER_METHOD(TSSelection);
     
 #ifdef __ANDROID__
     // set tree-sitter allocator
@@ -272,6 +332,7 @@ JNIEXPORT jint JNI_OnLoad(JavaVM *vm, void *reserved) {
 JNIEXPORT void JNI_OnUnload(JavaVM *vm, void *reserved) {
     JNIEnv *env = ::getEnv();
     // note here requires release the global references
+    TSStringTable::clear(env);
     env->DeleteGlobalRef(global_class_cache.UInt);
     env->DeleteGlobalRef(global_class_cache.Pair);
     env->DeleteGlobalRef(global_class_cache.List);
@@ -280,6 +341,7 @@ JNIEXPORT void JNI_OnUnload(JavaVM *vm, void *reserved) {
     env->DeleteGlobalRef(global_class_cache.IllegalArgumentException);
     env->DeleteGlobalRef(global_class_cache.IllegalStateException);
     env->DeleteGlobalRef(global_class_cache.IndexOutOfBoundsException);
+    env->DeleteGlobalRef(global_class_cache.IOException);
     
     env->DeleteGlobalRef(global_class_cache.TSTree);
     env->DeleteGlobalRef(global_class_cache.TSTreeCursor);
@@ -300,6 +362,17 @@ JNIEXPORT void JNI_OnUnload(JavaVM *vm, void *reserved) {
     env->DeleteGlobalRef(global_class_cache.TSQueryError$NodeType);
     env->DeleteGlobalRef(global_class_cache.TSQueryError$Structure);
     env->DeleteGlobalRef(global_class_cache.TSQueryError$Syntax);
+    env->DeleteGlobalRef(global_class_cache.TSStats);
+    env->DeleteGlobalRef(global_class_cache.TSOffsetIndex);
+    env->DeleteGlobalRef(global_class_cache.TSQueryCursor);
+    env->DeleteGlobalRef(global_class_cache.TSTreeSnapshot);
+    env->DeleteGlobalRef(global_class_cache.TSTreePublisher);
+    env->DeleteGlobalRef(global_class_cache.TSStyleTable);
+    env->DeleteGlobalRef(global_class_cache.TSDiagnostics);
+    env->DeleteGlobalRef(global_class_cache.TSLocals);
+    env->DeleteGlobalRef(global_class_cache.TSContextStack);
+    env->DeleteGlobalRef(global_class_cache.TSCompletion);
+    env->DeleteGlobalRef(global_class_cache.TSSelection);
 }
 
 #ifdef __cplusplus
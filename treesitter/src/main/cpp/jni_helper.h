@@ -18,6 +18,7 @@
 #define __JNI_HELPER_H__
 
 #include <jni.h>
+#include <stdio.h>
 #include <string.h>
 
 #ifdef __ANDROID__
@@ -34,26 +35,39 @@ extern "C" {
 
 #define JNI_VERSION JNI_VERSION_1_6
 
+// the parameters of a @CriticalNative method, ART calls it without
+// the JNIEnv and jclass, but a desktop JVM ignores the annotation
+#ifdef __ANDROID__
+#define CRITICAL_ARGS(...) (__VA_ARGS__)
+#else
+#define CRITICAL_ARGS(...) (JNIEnv *, jclass __VA_OPT__(,) __VA_ARGS__)
+#endif
+
 // get the base name of pathname
 #define FILE_NAME(x) (strrchr(x, '/') ? strrchr(x, '/') + 1 : x)
 
 #ifdef __ANDROID__
 // android log print
 // log.i
-#define LOGI(fmt, ...) \ 
+#define LOGI(fmt, ...) \
     __android_log_print(ANDROID_LOG_INFO, \
     TAG, "[%s:%s:%u] " fmt, \
     FILE_NAME(__FILE__), __PRETTY_FUNCTION__, __LINE__, ##__VA_ARGS__)
 
 // log.e
-#define LOGE(fmt, ...) \ 
+#define LOGE(fmt, ...) \
     __android_log_print(ANDROID_LOG_ERROR, \
     TAG, "[%s:%s:%u] " fmt, \
     FILE_NAME(__FILE__), __PRETTY_FUNCTION__, __LINE__, ##__VA_ARGS__)
-#elif
+#else
 // C-Style log print
-#define LOGI(...) fprintf(stdout, __VA_ARGS__)
-#define LOGE(...) fprintf(stderr, __VA_ARGS__)
+#define LOGI(fmt, ...) \
+    fprintf(stdout, "I/" TAG " [%s:%s:%u] " fmt, \
+    FILE_NAME(__FILE__), __PRETTY_FUNCTION__, __LINE__, ##__VA_ARGS__)
+
+#define LOGE(fmt, ...) \
+    fprintf(stderr, "E/" TAG " [%s:%s:%u] " fmt, \
+    FILE_NAME(__FILE__), __PRETTY_FUNCTION__, __LINE__, ##__VA_ARGS__)
 #endif // end __ANDROID__
 
 // the global JNIEnv
@@ -0,0 +1,122 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __TEST_DOCUMENT_H__
+#define __TEST_DOCUMENT_H__
+
+#include <string>
+
+#include <tree_sitter/api.h>
+
+#include "../ts_offset_index.h"
+
+extern "C" TSLanguage *tree_sitter_c();
+
+namespace test {
+
+// a document parsed from an offset index like TreeSitter.parse, the edits are applied
+// to the index and the tree, the edited tree is kept until the next edit as the old tree
+class Document {
+public:
+    Document(const TSLanguage *language, const std::u16string &text)
+        : index_(text.data(), static_cast<uint32_t>(text.size())), parser_(ts_parser_new()) {
+        ts_parser_set_language(parser_, language);
+        tree_ = parse(nullptr);
+    }
+
+    Document(const Document &) = delete;
+
+    Document &operator=(const Document &) = delete;
+
+    ~Document() {
+        if (old_tree_ != nullptr) ts_tree_delete(old_tree_);
+        ts_tree_delete(tree_);
+        ts_parser_delete(parser_);
+    }
+
+    const TSOffsetIndex *index() const { return &index_; }
+
+    const TSTree *tree() const { return tree_; }
+
+    // the edited tree of the last edit, or null before any edit
+    const TSTree *old_tree() const { return old_tree_; }
+
+    std::string text() const {
+        std::string out;
+        for (uint32_t offset = 0, length; offset < index_.utf8_length(); offset += length) {
+            out.append(index_.segment(offset, &length), length);
+        }
+        return out;
+    }
+
+    // the UTF-8 offset of the n-th occurrence of the UTF-8 word
+    uint32_t find(const std::string &word, int n = 0) const {
+        std::string source = text();
+        size_t offset = source.find(word);
+        while (n-- > 0 && offset != std::string::npos) offset = source.find(word, offset + 1);
+        return static_cast<uint32_t>(offset);
+    }
+
+    // replace the UTF-16 range [start16, end16) with the text and reparse
+    void edit(uint32_t start16, uint32_t end16, const std::u16string &text) {
+        uint32_t start8, end8, new_end8;
+        std::string before = this->text();
+        index_.edit(start16, end16, text.data(), static_cast<uint32_t>(text.size()), &start8, &end8, &new_end8);
+        std::string after = this->text();
+        TSInputEdit edit {
+            start8, end8, new_end8, point_of(before, start8), point_of(before, end8), point_of(after, new_end8)
+        };
+        if (old_tree_ != nullptr) ts_tree_delete(old_tree_);
+        old_tree_ = tree_;
+        ts_tree_edit(old_tree_, &edit);
+        tree_ = parse(old_tree_);
+    }
+
+    // replace the UTF-8 range of an ASCII document, the offsets are the same in UTF-16
+    void replace(uint32_t start, uint32_t end, const std::string &text) {
+        edit(start, end, std::u16string(text.begin(), text.end()));
+    }
+
+private:
+    TSTree *parse(const TSTree *old_tree) {
+        auto read = [](void *payload, uint32_t byte_index, TSPoint point, uint32_t *bytes_read) {
+            return reinterpret_cast<TSOffsetIndex*>(payload)->segment(byte_index, bytes_read);
+        };
+        return ts_parser_parse(parser_, old_tree, {&index_, read, TSInputEncodingUTF8});
+    }
+
+    static TSPoint point_of(const std::string &text, uint32_t offset) {
+        TSPoint point {0, 0};
+        for (uint32_t i = 0; i < offset && i < text.size(); ++i) {
+            if (text[i] == '\n') {
+                point.row += 1;
+                point.column = 0;
+            } else {
+                point.column += 1;
+            }
+        }
+        return point;
+    }
+
+    TSOffsetIndex index_;
+    TSParser *parser_;
+    TSTree *tree_;
+    TSTree *old_tree_ = nullptr;
+};
+
+} // namespace test
+
+#endif // __TEST_DOCUMENT_H__
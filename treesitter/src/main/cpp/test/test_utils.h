@@ -0,0 +1,94 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __TEST_UTILS_H__
+#define __TEST_UTILS_H__
+
+#include <stdio.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// a minimal test runner of the host tests, a test case is a function registered
+// by TS_TEST, a failed check is reported and the case goes on with the next check
+namespace test {
+
+struct Case {
+    const char *name;
+    std::function<void()> run;
+};
+
+static inline std::vector<Case> &cases() {
+    static std::vector<Case> instance;
+    return instance;
+}
+
+static inline int &failures() {
+    static int count = 0;
+    return count;
+}
+
+struct Register {
+    Register(const char *name, std::function<void()> run) { cases().push_back({name, std::move(run)}); }
+};
+
+// run the cases whose name contains the filter, the exit code is the number of the failed cases
+static inline int run(int argc, char **argv) {
+    std::string filter = argc > 1 ? argv[1] : "";
+    int failed = 0;
+    for (const Case &c : cases()) {
+        if (!filter.empty() && std::string(c.name).find(filter) == std::string::npos) continue;
+        int before = failures();
+        c.run();
+        bool ok = failures() == before;
+        failed += ok ? 0 : 1;
+        printf("[%s] %s\n", ok ? "  OK  " : "FAILED", c.name);
+    }
+    printf("%d failed\n", failed);
+    return failed;
+}
+
+} // namespace test
+
+#define TS_TEST(name)                                          \
+    static void name();                                        \
+    static test::Register name##_register(#name, name);        \
+    static void name()
+
+#define TS_CHECK(condition)                                                          \
+    do {                                                                             \
+        if (!(condition)) {                                                          \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++test::failures();                                                      \
+        }                                                                            \
+    } while (0)
+
+#define TS_CHECK_EQ(actual, expected)                                                \
+    do {                                                                             \
+        long long actual_ = static_cast<long long>(actual);                          \
+        long long expected_ = static_cast<long long>(expected);                      \
+        if (actual_ != expected_) {                                                  \
+            fprintf(stderr, "%s:%d: check failed: %s == %s (%lld != %lld)\n",         \
+                    __FILE__, __LINE__, #actual, #expected, actual_, expected_);     \
+            ++test::failures();                                                      \
+        }                                                                            \
+    } while (0)
+
+#define TS_TEST_MAIN()                                                               \
+    int main(int argc, char **argv) { return test::run(argc, argv); }
+
+#endif // __TEST_UTILS_H__
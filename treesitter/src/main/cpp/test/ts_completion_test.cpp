@@ -0,0 +1,107 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// the incremental harvest of TSCompletion by the C grammar, the identifiers of the children
+// edited since the last update are harvested again, and the trie is rebuilt from the live words
+//
+// usage: ts-completion-test [filter]
+
+#include <string.h>
+
+#include "test_utils.h"
+#include "test_document.h"
+#include "../ts_completion.h"
+
+static const char16_t *SOURCE =
+    u"int alpha;\n"
+    u"int beta;\n"
+    u"int f(void) {\n"
+    u"  return al + zz;\n"
+    u"}\n";
+
+static std::vector<uint16_t> identifiers() {
+    return {ts_language_symbol_for_name(tree_sitter_c(), "identifier", 10, true)};
+}
+
+// the completion of the document, updated after every edit
+struct Fixture {
+    test::Document document {tree_sitter_c(), SOURCE};
+    TSCompletion completion {identifiers()};
+
+    Fixture() { completion.update(document.tree(), nullptr, document.index()); }
+
+    void replace(uint32_t start, uint32_t end, const std::string &text) {
+        document.replace(start, end, text);
+        completion.update(document.tree(), document.old_tree(), document.index());
+    }
+
+    // the identifiers completing the word which ends before the text
+    std::vector<std::string> complete(const std::string &text) const {
+        std::vector<TSCompletion::Item> items;
+        completion.complete(document.tree(), document.index(), document.find(text), 100, items);
+        std::vector<std::string> words;
+        for (const TSCompletion::Item &item : items) {
+            if (item.kind == TS_COMPLETION_IDENTIFIER) words.push_back(item.text);
+        }
+        return words;
+    }
+};
+
+static bool contains(const std::vector<std::string> &words, const std::string &word) {
+    return std::find(words.begin(), words.end(), word) != words.end();
+}
+
+TS_TEST(complete_identifiers) {
+    Fixture f;
+    std::vector<std::string> words = f.complete(" + zz;");
+    TS_CHECK_EQ(words.size(), 1);
+    TS_CHECK(contains(words, "alpha"));
+}
+
+// renaming a token to one of the same length changes no syntax, so the changed
+// ranges are empty, the edited child must be harvested again anyway
+TS_TEST(same_length_rename) {
+    Fixture f;
+    uint32_t start = f.document.find("alpha");
+    f.replace(start, start + 5, "alias");
+    std::vector<std::string> words = f.complete(" + zz;");
+    TS_CHECK(contains(words, "alias"));
+    TS_CHECK(!contains(words, "alpha"));
+}
+
+// the renamed words are dead nodes of the trie, which is rebuilt before they pile up
+TS_TEST(compact_dead_words) {
+    Fixture f;
+    uint32_t start = f.document.find("alpha");
+    std::string name = "alpha";
+    for (int i = 0; i < 5000; ++i) {
+        std::string next = {'z', 'z', static_cast<char>('a' + i % 26), static_cast<char>('a' + i / 26 % 26),
+                            static_cast<char>('a' + i / 676)};
+        f.replace(start, start + 5, next);
+        name = next;
+    }
+    // a new name adds one to three nodes, so without the rebuilds there are more than 5000 nodes,
+    // the trie is rebuilt at 1024 dead words, when it has less than 3 * 1024 nodes plus the live words
+    TS_CHECK(f.completion.node_count() < 4 * TS_COMPLETION_DEAD_WORDS);
+    // the live words are kept by the rebuilds, and the dead ones are gone
+    std::vector<std::string> words = f.complete(";\n}");
+    TS_CHECK_EQ(words.size(), 1);
+    TS_CHECK(contains(words, name));
+    words = f.complete(" + zz;");
+    TS_CHECK(!contains(words, "alpha"));
+}
+
+TS_TEST_MAIN()
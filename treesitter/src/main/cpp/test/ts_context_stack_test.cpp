@@ -0,0 +1,128 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// the cached chain of TSContextStack by the C grammar, scrolled forward and backward
+// across the nested scopes, checked against a new stack at every byte
+//
+// usage: ts-context-stack-test [filter]
+
+#include <string.h>
+
+#include <random>
+
+#include "test_utils.h"
+#include "test_document.h"
+#include "../ts_context_stack.h"
+
+static const char16_t *SOURCE =
+    u"struct point {\n"
+    u"  int x;\n"
+    u"  int y;\n"
+    u"};\n"
+    u"\n"
+    u"int sum(int *values, int count) {\n"
+    u"  int total = 0;\n"
+    u"  for (int i = 0; i < count; i++) {\n"
+    u"    if (values[i] > 0) {\n"
+    u"      total += values[i];\n"
+    u"    }\n"
+    u"  }\n"
+    u"  return total;\n"
+    u"}\n"
+    u"\n"
+    u"int main(void) {\n"
+    u"  struct line { struct point a, b; } l;\n"
+    u"  while (l.a.x < 10) {\n"
+    u"    l.a.x++;\n"
+    u"  }\n"
+    u"  return 0;\n"
+    u"}\n";
+
+static std::vector<uint16_t> scopes() {
+    std::vector<uint16_t> symbols;
+    for (const char *name : {"struct_specifier", "function_definition", "for_statement",
+                             "if_statement", "while_statement"}) {
+        TSSymbol symbol = ts_language_symbol_for_name(tree_sitter_c(), name, static_cast<uint32_t>(strlen(name)), true);
+        TS_CHECK(symbol != 0);
+        symbols.push_back(symbol);
+    }
+    return symbols;
+}
+
+// the chain of the cached stack is the same as walked from the root
+static void check_at(TSContextStack &stack, const TSTree *tree, uint32_t byte) {
+    TSContextStack fresh(scopes());
+    std::vector<TSContextStack::Level> expected = fresh.at(tree, byte);
+    const std::vector<TSContextStack::Level> &levels = stack.at(tree, byte);
+    TS_CHECK_EQ(levels.size(), expected.size());
+    for (size_t i = 0; i < std::min(levels.size(), expected.size()); ++i) {
+        TS_CHECK(levels[i].node.id == expected[i].node.id);
+        TS_CHECK_EQ(levels[i].start_byte, expected[i].start_byte);
+        TS_CHECK_EQ(levels[i].end_byte, expected[i].end_byte);
+        TS_CHECK_EQ(levels[i].name_start, expected[i].name_start);
+        TS_CHECK_EQ(levels[i].name_end, expected[i].name_end);
+        TS_CHECK(levels[i].start_byte <= byte && byte < levels[i].end_byte);
+    }
+}
+
+TS_TEST(nested_scopes) {
+    test::Document document(tree_sitter_c(), SOURCE);
+    TSContextStack stack(scopes());
+    // the function, the for and the if
+    uint32_t byte = document.find("total += ");
+    const std::vector<TSContextStack::Level> &levels = stack.at(document.tree(), byte);
+    TS_CHECK_EQ(levels.size(), 3);
+    if (!levels.empty()) {
+        TS_CHECK_EQ(levels[0].name_start, document.find("sum"));
+        TS_CHECK_EQ(levels[0].name_end, document.find("sum") + 3);
+    }
+    TS_CHECK(stack.at(document.tree(), document.find("int y")).size() == 1);
+    TS_CHECK(stack.at(document.tree(), document.find("\n\nint sum")).empty());
+}
+
+TS_TEST(scroll_forward_and_backward) {
+    test::Document document(tree_sitter_c(), SOURCE);
+    TSContextStack stack(scopes());
+    uint32_t length = static_cast<uint32_t>(document.text().size());
+    for (uint32_t byte = 0; byte <= length; ++byte) check_at(stack, document.tree(), byte);
+    for (uint32_t byte = length + 1; byte-- > 0;) check_at(stack, document.tree(), byte);
+
+    // jump back and forth by a few lines, like scrolling by a fling
+    std::mt19937 random(1);
+    uint32_t byte = 0;
+    for (int i = 0; i < 2000; ++i) {
+        int32_t delta = static_cast<int32_t>(random() % 121) - 60;
+        byte = static_cast<uint32_t>(std::clamp<int64_t>(static_cast<int64_t>(byte) + delta, 0, length));
+        check_at(stack, document.tree(), byte);
+    }
+}
+
+// the edit changes the tree in place, the stack is reset like TreeSitter.edit
+TS_TEST(reset_after_edit) {
+    test::Document document(tree_sitter_c(), SOURCE);
+    TSContextStack stack(scopes());
+    uint32_t byte = document.find("l.a.x++");
+    check_at(stack, document.tree(), byte);
+
+    document.replace(0, 0, "int g(void) {\n  if (1) {\n");
+    stack.reset();
+    uint32_t length = static_cast<uint32_t>(document.text().size());
+    for (uint32_t offset = 0; offset <= length; offset += 7) check_at(stack, document.tree(), offset);
+    for (uint32_t offset = length + 1; offset-- > 0;) check_at(stack, document.tree(), offset);
+}
+
+TS_TEST_MAIN()
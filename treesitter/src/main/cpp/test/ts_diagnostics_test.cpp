@@ -0,0 +1,157 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// the incremental update of TSDiagnostics by the C grammar, checked against
+// a full scan of the same tree after every edit
+//
+// usage: ts-diagnostics-test [filter]
+
+#include <random>
+
+#include "test_utils.h"
+#include "test_document.h"
+#include "../ts_diagnostics.h"
+
+static const char16_t *SOURCE =
+    u"int f(int a) {\n"
+    u"  return a;\n"
+    u"}\n"
+    u"\n"
+    u"int g(int b) {\n"
+    u"  int c = b * 2;\n"
+    u"  return c;\n"
+    u"}\n"
+    u"\n"
+    u"int h(void) {\n"
+    u"  return f(1) + g(2);\n"
+    u"}\n";
+
+// the diagnostics of the document, updated from the old tree after every edit
+struct Fixture {
+    test::Document document {tree_sitter_c(), SOURCE};
+    TSDiagnostics diagnostics;
+
+    Fixture() { diagnostics.update(document.tree(), nullptr); }
+
+    void replace(uint32_t start, uint32_t end, const std::string &text) {
+        document.replace(start, end, text);
+        diagnostics.update(document.tree(), document.old_tree());
+        check_full_scan();
+    }
+
+    // the incremental update finds the same nodes as a full scan
+    void check_full_scan() const {
+        TSDiagnostics full;
+        full.update(document.tree(), nullptr);
+        const std::vector<TSDiagnostic> &a = diagnostics.diagnostics(), &b = full.diagnostics();
+        TS_CHECK_EQ(a.size(), b.size());
+        for (size_t i = 0; i < std::min(a.size(), b.size()); ++i) {
+            TS_CHECK(a[i].id == b[i].id);
+            TS_CHECK_EQ(a[i].start_byte, b[i].start_byte);
+            TS_CHECK_EQ(a[i].end_byte, b[i].end_byte);
+            TS_CHECK_EQ(a[i].start_point.row, b[i].start_point.row);
+            TS_CHECK_EQ(a[i].end_point.row, b[i].end_point.row);
+            TS_CHECK_EQ(a[i].kind, b[i].kind);
+            TS_CHECK_EQ(a[i].symbol, b[i].symbol);
+            TS_CHECK_EQ(a[i].state, b[i].state);
+        }
+        TS_CHECK(diagnostics.lines() == full.lines());
+    }
+
+    // the rows of the bitmap
+    std::vector<uint32_t> rows() const {
+        std::vector<uint32_t> out;
+        for (uint32_t row = 0; row < diagnostics.lines().size() * 64; ++row) {
+            if (diagnostics.has_error(row)) out.push_back(row);
+        }
+        return out;
+    }
+};
+
+TS_TEST(clean_document) {
+    Fixture f;
+    TS_CHECK(f.diagnostics.diagnostics().empty());
+    TS_CHECK(f.rows().empty());
+}
+
+TS_TEST(insert_and_fix_error) {
+    Fixture f;
+    // int c = ;
+    uint32_t value = f.document.find("b * 2");
+    f.replace(value, value + 5, "");
+    TS_CHECK(!f.diagnostics.diagnostics().empty());
+    TS_CHECK(f.rows() == std::vector<uint32_t> {5});
+
+    f.replace(value, value, "b * 3");
+    TS_CHECK(f.diagnostics.diagnostics().empty());
+    TS_CHECK(f.rows().empty());
+}
+
+TS_TEST(missing_semicolon) {
+    Fixture f;
+    // return c}
+    uint32_t semicolon = f.document.find(";", 2);
+    f.replace(semicolon, semicolon + 1, "");
+    TS_CHECK_EQ(f.diagnostics.diagnostics().size(), 1);
+    if (!f.diagnostics.diagnostics().empty()) {
+        TS_CHECK_EQ(f.diagnostics.diagnostics()[0].kind, TS_DIAGNOSTIC_MISSING);
+    }
+    TS_CHECK(f.rows() == std::vector<uint32_t> {6});
+}
+
+// the diagnostic far from the edits is moved to the new tree, and its rows follow the edits
+TS_TEST(edit_far_from_error) {
+    Fixture f;
+    uint32_t value = f.document.find("b * 2");
+    f.replace(value, value + 5, "");
+    TS_CHECK(f.rows() == std::vector<uint32_t> {5});
+
+    // rename in another function
+    uint32_t name = f.document.find("f(1)");
+    f.replace(name, name + 1, "k");
+    TS_CHECK(f.rows() == std::vector<uint32_t> {5});
+
+    // insert the lines before the error
+    f.replace(0, 0, "int x = 1;\n\n");
+    TS_CHECK(f.rows() == std::vector<uint32_t> {7});
+
+    // and delete them again
+    f.replace(0, 12, "");
+    TS_CHECK(f.rows() == std::vector<uint32_t> {5});
+}
+
+// the random edits of the punctuations, which add and remove the errors everywhere
+TS_TEST(random_edits) {
+    static const char *samples[] = {";", "{", "}", "(", ")", " x", "=", "\n", ""};
+    std::mt19937 random(1);
+    Fixture f;
+    for (int i = 0; i < 500; ++i) {
+        uint32_t length = static_cast<uint32_t>(f.document.text().size());
+        uint32_t start = static_cast<uint32_t>(random() % (length + 1));
+        uint32_t end = std::min(start + static_cast<uint32_t>(random() % 3), length);
+        f.replace(start, end, samples[random() % (sizeof samples / sizeof samples[0])]);
+        // restore the source now and then, so the errors are fixed too
+        if (i % 50 == 49) {
+            std::string source = f.document.text();
+            std::u16string original = SOURCE;
+            f.replace(0, static_cast<uint32_t>(source.size()), std::string(original.begin(), original.end()));
+            TS_CHECK(f.diagnostics.diagnostics().empty());
+        }
+    }
+}
+
+TS_TEST_MAIN()
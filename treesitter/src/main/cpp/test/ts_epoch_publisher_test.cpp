@@ -0,0 +1,147 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// the epoch reclamation of TSEpochPublisher, the freed values are poisoned and kept
+// until the end of the test, so that a reader seeing a freed value fails the check,
+// build it with -fsanitize=thread to check the memory ordering as well
+//
+// usage: ts-epoch-publisher-test [filter]
+
+#include <thread>
+
+#include "test_utils.h"
+#include "../ts_epoch_publisher.h"
+
+// the generation of a freed value
+#define POISONED -1
+
+typedef TSEpochPublisher<int64_t> Publisher;
+
+// the freed values, the publisher frees them under its lock
+struct Graveyard {
+    std::vector<TSPublished<int64_t>*> entries;
+
+    void operator()(TSPublished<int64_t> *entry) {
+        entry->generation = POISONED;
+        entries.push_back(entry);
+    }
+
+    ~Graveyard() {
+        for (auto *entry : entries) delete entry;
+    }
+};
+
+static TSPublished<int64_t> *entry_of(int64_t generation) {
+    return new TSPublished<int64_t> {generation * 2, generation};
+}
+
+TS_TEST(pinned_reader_delays_reclaim) {
+    Graveyard graveyard;
+    auto free = [&graveyard](TSPublished<int64_t> *entry) { graveyard(entry); };
+    Publisher publisher;
+    publisher.publish(entry_of(1), free);
+
+    int slot = publisher.pin();
+    TS_CHECK(slot >= 0);
+    const TSPublished<int64_t> *seen = publisher.current();
+    for (int64_t generation = 2; generation <= 100; ++generation) {
+        publisher.publish(entry_of(generation), free);
+    }
+    TS_CHECK_EQ(seen->generation, 1);
+    TS_CHECK_EQ(seen->value, 2);
+    TS_CHECK_EQ(publisher.retired_count(), 99);
+    TS_CHECK(graveyard.entries.empty());
+
+    publisher.unpin(slot);
+    publisher.try_reclaim(free);
+    TS_CHECK_EQ(publisher.retired_count(), 0);
+    TS_CHECK_EQ(graveyard.entries.size(), 99);
+    TS_CHECK_EQ(publisher.current()->generation, 100);
+
+    publisher.clear(free);
+    TS_CHECK(publisher.current() == nullptr);
+    TS_CHECK_EQ(graveyard.entries.size(), 100);
+}
+
+TS_TEST(all_slots_taken) {
+    Publisher publisher;
+    std::vector<int> slots;
+    for (int i = 0; i < TS_PUBLISHER_SLOTS; ++i) slots.push_back(publisher.pin());
+    for (int i = 0; i < TS_PUBLISHER_SLOTS; ++i) TS_CHECK_EQ(slots[i], i);
+    TS_CHECK_EQ(publisher.pin(), -1);
+    publisher.unpin(slots[7]);
+    TS_CHECK_EQ(publisher.pin(), 7);
+    for (int slot : slots) publisher.unpin(slot);
+}
+
+// the readers pin, read the current value and unpin in a loop while one writer publishes,
+// a reader must never see a freed value, and the generations it sees never go back
+TS_TEST(readers_against_publishes) {
+    const int readers = 4;
+    const int64_t publishes = 200000;
+
+    Graveyard graveyard;
+    auto free = [&graveyard](TSPublished<int64_t> *entry) { graveyard(entry); };
+    Publisher publisher;
+    publisher.publish(entry_of(0), free);
+
+    std::atomic<bool> done(false);
+    std::atomic<int> failures(0);
+    std::atomic<int64_t> reads(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < readers; ++i) {
+        threads.emplace_back([&]() {
+            int64_t last = 0;
+            int64_t count = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                int slot = publisher.pin();
+                if (slot < 0) {
+                    failures.fetch_add(1);
+                    return;
+                }
+                const TSPublished<int64_t> *entry = publisher.current();
+                if (entry->generation < last || entry->value != entry->generation * 2) {
+                    failures.fetch_add(1);
+                }
+                last = entry->generation;
+                publisher.unpin(slot);
+                publisher.try_reclaim(free);
+                ++count;
+            }
+            reads.fetch_add(count);
+        });
+    }
+
+    for (int64_t generation = 1; generation <= publishes; ++generation) {
+        publisher.publish(entry_of(generation), free);
+    }
+    done.store(true);
+    for (auto &thread : threads) thread.join();
+
+    TS_CHECK_EQ(failures.load(), 0);
+    TS_CHECK(reads.load() > 0);
+    TS_CHECK_EQ(publisher.current()->generation, publishes);
+
+    // nothing is pinned, the next publish frees everything replaced so far
+    publisher.publish(entry_of(publishes + 1), free);
+    TS_CHECK_EQ(publisher.retired_count(), 0);
+    TS_CHECK_EQ(graveyard.entries.size(), publishes + 1);
+
+    publisher.clear(free);
+    TS_CHECK_EQ(graveyard.entries.size(), publishes + 2);
+}
+
+TS_TEST_MAIN()
@@ -0,0 +1,161 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// the incremental update of TSLocals by the C grammar, the children of the root
+// edited since the last update are queried again, the others are moved
+//
+// usage: ts-locals-test [filter]
+
+#include <string.h>
+
+#include "test_utils.h"
+#include "test_document.h"
+#include "../ts_locals.h"
+
+static const char *LOCALS =
+    "(function_definition) @local.scope\n"
+    "(parameter_declaration declarator: (identifier) @local.definition.parameter)\n"
+    "(init_declarator declarator: (identifier) @local.definition.var)\n"
+    "(identifier) @local.reference\n";
+
+static const char *HIGHLIGHTS =
+    "(identifier) @variable\n"
+    "(identifier) @variable.parameter\n";
+
+static const char16_t *SOURCE =
+    u"int f(int aa) {\n"
+    u"  return aa;\n"
+    u"}\n"
+    u"int g(int bb) {\n"
+    u"  return bb;\n"
+    u"}\n";
+
+static TSQuery *query_of(const char *source) {
+    uint32_t error_offset;
+    TSQueryError error;
+    TSQuery *query = ts_query_new(tree_sitter_c(), source, static_cast<uint32_t>(strlen(source)), &error_offset, &error);
+    TS_CHECK(query != nullptr);
+    return query;
+}
+
+// the locals of the document, updated after every edit
+struct Fixture {
+    TSQuery *locals_query = query_of(LOCALS);
+    TSQuery *highlights = query_of(HIGHLIGHTS);
+    test::Document document {tree_sitter_c(), SOURCE};
+    TSLocals locals {locals_query, highlights};
+
+    Fixture() {
+        std::vector<int32_t> rows;
+        locals.update(document.tree(), nullptr, document.index(), rows);
+    }
+
+    ~Fixture() {
+        ts_query_delete(locals_query);
+        ts_query_delete(highlights);
+    }
+
+    // the rows of the children queried again
+    std::vector<int32_t> replace(uint32_t start, uint32_t end, const std::string &text) {
+        document.replace(start, end, text);
+        std::vector<int32_t> rows;
+        locals.update(document.tree(), document.old_tree(), document.index(), rows);
+        return rows;
+    }
+
+    std::vector<int32_t> occurrences(uint32_t byte) const {
+        std::vector<int32_t> out;
+        locals.occurrences(byte, out);
+        return out;
+    }
+
+    std::vector<int32_t> definitions(const std::string &name) const {
+        std::vector<int32_t> out;
+        locals.definitions(name, out);
+        return out;
+    }
+};
+
+TS_TEST(resolve_parameters) {
+    Fixture f;
+    uint32_t definition = f.document.find("aa"), reference = f.document.find("aa", 1);
+    std::vector<int32_t> ranges = f.occurrences(reference);
+    TS_CHECK_EQ(ranges.size(), 4);
+    if (ranges.size() == 4) {
+        TS_CHECK_EQ(ranges[0], definition);
+        TS_CHECK_EQ(ranges[2], reference);
+    }
+    TS_CHECK_EQ(f.occurrences(f.document.find("bb")).size(), 4);
+}
+
+// renaming a token to one of the same length changes no syntax, so the changed ranges are empty,
+// the edited child must be queried again anyway, and the child after it is moved
+TS_TEST(same_length_rename) {
+    Fixture f;
+    uint32_t definition = f.document.find("aa");
+    std::vector<int32_t> rows = f.replace(definition, definition + 2, "cc");
+    TS_CHECK_EQ(rows.size(), 2);
+    if (rows.size() == 2) {
+        TS_CHECK_EQ(rows[0], 0);
+        TS_CHECK_EQ(rows[1], 2);
+    }
+    // the reference to aa has no definition now
+    TS_CHECK_EQ(f.occurrences(definition).size(), 2);
+    TS_CHECK_EQ(f.occurrences(f.document.find("aa")).size(), 2);
+    TS_CHECK(f.definitions("aa").empty());
+    TS_CHECK_EQ(f.definitions("cc").size(), 2);
+    TS_CHECK_EQ(f.occurrences(f.document.find("bb")).size(), 4);
+
+    // rename the reference too, the symbol is resolved again
+    uint32_t reference = f.document.find("aa");
+    f.replace(reference, reference + 2, "cc");
+    TS_CHECK_EQ(f.occurrences(reference).size(), 4);
+}
+
+// the moved children keep their entries, relative to the new start
+TS_TEST(move_unchanged_children) {
+    Fixture f;
+    f.replace(0, 0, "int x = 1;\n\n");
+    uint32_t definition = f.document.find("bb"), reference = f.document.find("bb", 1);
+    std::vector<int32_t> ranges = f.occurrences(reference);
+    TS_CHECK_EQ(ranges.size(), 4);
+    if (ranges.size() == 4) {
+        TS_CHECK_EQ(ranges[0], definition);
+        TS_CHECK_EQ(ranges[1], definition + 2);
+        TS_CHECK_EQ(ranges[2], reference);
+    }
+    TS_CHECK_EQ(f.definitions("x").size(), 2);
+}
+
+// the names no entry refers to are dropped, so renaming over and over doesn't grow the names
+TS_TEST(release_names) {
+    Fixture f;
+    // f, g, aa, bb
+    TS_CHECK_EQ(f.locals.name_count(), 4);
+    uint32_t definition = f.document.find("aa");
+    for (int i = 0; i < 200; ++i) {
+        std::string name = {static_cast<char>('a' + i % 26), static_cast<char>('a' + i / 26)};
+        // the old name, the other parameter and a keyword
+        if (name == "aa" || name == "bb" || name == "if") continue;
+        f.replace(definition, definition + 2, name);
+        // the new parameter and the unresolved reference to aa
+        TS_CHECK_EQ(f.locals.name_count(), 5);
+    }
+    f.locals.reset();
+    TS_CHECK_EQ(f.locals.name_count(), 0);
+}
+
+TS_TEST_MAIN()
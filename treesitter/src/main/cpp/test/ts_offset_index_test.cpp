@@ -0,0 +1,325 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// the UTF-16 to UTF-8 translation of TSOffsetIndex across the edits, checked
+// against a UTF-16 copy of the document, and the distance of the checkpoints
+//
+// usage: ts-offset-index-test [filter]
+
+#include <random>
+#include <thread>
+
+#include "test_utils.h"
+#include "../ts_offset_index.h"
+
+// the UTF-8 bytes of the UTF-16 text
+static std::string to_utf8(const std::u16string &text) {
+    std::string out;
+    for (size_t i = 0; i < text.size(); ++i) {
+        uint32_t c = text[i];
+        if (c >= 0xd800 && c < 0xdc00 && i + 1 < text.size() && text[i + 1] >= 0xdc00 && text[i + 1] < 0xe000) {
+            c = 0x10000 + ((c - 0xd800) << 10) + (text[++i] - 0xdc00);
+        }
+        if (c < 0x80) {
+            out += static_cast<char>(c);
+        } else if (c < 0x800) {
+            out += static_cast<char>(0xc0 | (c >> 6));
+            out += static_cast<char>(0x80 | (c & 0x3f));
+        } else if (c < 0x10000) {
+            out += static_cast<char>(0xe0 | (c >> 12));
+            out += static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+            out += static_cast<char>(0x80 | (c & 0x3f));
+        } else {
+            out += static_cast<char>(0xf0 | (c >> 18));
+            out += static_cast<char>(0x80 | ((c >> 12) & 0x3f));
+            out += static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+            out += static_cast<char>(0x80 | (c & 0x3f));
+        }
+    }
+    return out;
+}
+
+// the whole UTF-8 document read by the segments, like the TSInput of the parser
+static std::string text_of(const TSOffsetIndex &index) {
+    std::string out;
+    uint32_t offset = 0;
+    while (offset < index.utf8_length()) {
+        uint32_t length;
+        const char *p = index.segment(offset, &length);
+        if (length == 0) break;
+        out.append(p, length);
+        offset += length;
+    }
+    return out;
+}
+
+static bool is_low_surrogate(char16_t c) { return c >= 0xdc00 && c < 0xe000; }
+
+// a random text of ASCII, 2 and 3 bytes characters, and surrogate pairs
+static std::u16string random_text(std::mt19937 &random, size_t length) {
+    static const char16_t samples[] = {u'a', u'b', u' ', u'\n', u'é', u'ж', u'中', u'語'};
+    std::u16string text;
+    while (text.size() < length) {
+        uint32_t kind = random() % 10;
+        if (kind < 6) {
+            text += static_cast<char16_t>('a' + random() % 26);
+        } else if (kind < 9) {
+            text += samples[random() % (sizeof samples / sizeof samples[0])];
+        } else {
+            // U+1F600 and the following emojis
+            uint32_t c = 0x1f600 + random() % 64 - 0x10000;
+            text += static_cast<char16_t>(0xd800 + (c >> 10));
+            text += static_cast<char16_t>(0xdc00 + (c & 0x3ff));
+        }
+    }
+    return text;
+}
+
+// a random offset which is not in the middle of a surrogate pair
+static uint32_t random_offset(std::mt19937 &random, const std::u16string &text) {
+    uint32_t offset = text.empty() ? 0 : static_cast<uint32_t>(random() % (text.size() + 1));
+    if (offset > 0 && offset < text.size() && is_low_surrogate(text[offset])) offset -= 1;
+    return offset;
+}
+
+// decode the document segment by segment to UTF-16 like the lexer, which never joins
+// two segments, so a character cut by a segment end is decoded to U+FFFD
+static std::u16string decode_segments(const TSOffsetIndex &index) {
+    std::u16string out;
+    uint32_t offset = 0;
+    while (offset < index.utf8_length()) {
+        uint32_t length;
+        const uint8_t *p = reinterpret_cast<const uint8_t*>(index.segment(offset, &length));
+        if (length == 0) break;
+        for (uint32_t i = 0; i < length;) {
+            uint32_t size = p[i] < 0x80 ? 1 : p[i] >= 0xf0 ? 4 : p[i] >= 0xe0 ? 3 : p[i] >= 0xc0 ? 2 : 0;
+            if (size == 0 || i + size > length) {
+                out += u'\xfffd';
+                i += 1;
+                continue;
+            }
+            uint32_t c = size == 1 ? p[i] : p[i] & (0x7f >> size);
+            for (uint32_t j = 1; j < size; ++j) c = (c << 6) | (p[i + j] & 0x3f);
+            if (c >= 0x10000) {
+                out += static_cast<char16_t>(0xd800 + ((c - 0x10000) >> 10));
+                out += static_cast<char16_t>(0xdc00 + ((c - 0x10000) & 0x3ff));
+            } else {
+                out += static_cast<char16_t>(c);
+            }
+            i += size;
+        }
+        offset += length;
+    }
+    return out;
+}
+
+// check every offset of the document against the UTF-16 copy
+static void check_translation(const TSOffsetIndex &index, const std::u16string &text) {
+    std::string utf8 = to_utf8(text);
+    TS_CHECK_EQ(index.utf16_length(), text.size());
+    TS_CHECK_EQ(index.utf8_length(), utf8.size());
+    TS_CHECK(text_of(index) == utf8);
+    TS_CHECK(decode_segments(index) == text);
+    uint32_t offset8 = 0;
+    for (uint32_t i = 0; i <= text.size(); ++i) {
+        if (i < text.size() && is_low_surrogate(text[i])) {
+            // the middle of a surrogate pair is moved after the pair
+            TS_CHECK_EQ(index.to_utf8(i), offset8);
+            continue;
+        }
+        TS_CHECK_EQ(index.to_utf8(i), offset8);
+        TS_CHECK_EQ(index.to_utf16(offset8), i);
+        if (i == text.size()) break;
+        uint32_t units = text[i] >= 0xd800 && text[i] < 0xdc00 ? 2 : 1;
+        uint32_t bytes = units == 2 ? 4 : text[i] < 0x80 ? 1 : text[i] < 0x800 ? 2 : 3;
+        // the middle of a character is moved to the character start
+        for (uint32_t j = 1; j < bytes; ++j) TS_CHECK_EQ(index.to_utf16(offset8 + j), i);
+        offset8 += bytes;
+    }
+}
+
+// the longest distance between two checkpoints, the start and the end of the document included
+static uint32_t max_gap(const TSOffsetIndex &index) {
+    uint32_t gap = 0, last = 0;
+    for (const TSOffsetIndex::Checkpoint &c : index.checkpoints()) {
+        gap = std::max(gap, c.utf16 - last);
+        last = c.utf16;
+    }
+    return std::max(gap, index.utf16_length() - last);
+}
+
+TS_TEST(translate_initial_text) {
+    std::mt19937 random(1);
+    for (size_t length : {0, 1, 15, 1023, 1024, 1025, 5000}) {
+        std::u16string text = random_text(random, length);
+        TSOffsetIndex index(text.data(), static_cast<uint32_t>(text.size()));
+        check_translation(index, text);
+        TS_CHECK(max_gap(index) <= TS_OFFSET_INDEX_INTERVAL);
+    }
+}
+
+TS_TEST(translate_across_random_edits) {
+    std::mt19937 random(2);
+    std::u16string text = random_text(random, 20000);
+    TSOffsetIndex index(text.data(), static_cast<uint32_t>(text.size()));
+    for (int i = 0; i < 300; ++i) {
+        uint32_t start = random_offset(random, text);
+        uint32_t end = random() % 4 == 0 ? start : random_offset(random, text);
+        if (end < start) std::swap(start, end);
+        std::u16string inserted = random_text(random, random() % 3 == 0 ? random() % 3000 : random() % 8);
+        uint32_t start8, end8, new_end8;
+        std::string before = to_utf8(text.substr(0, start));
+        std::string removed = to_utf8(text.substr(start, end - start));
+        index.edit(start, end, inserted.data(), static_cast<uint32_t>(inserted.size()), &start8, &end8, &new_end8);
+        text.replace(start, end - start, inserted);
+
+        TS_CHECK_EQ(start8, before.size());
+        TS_CHECK_EQ(end8, before.size() + removed.size());
+        TS_CHECK_EQ(new_end8, before.size() + to_utf8(inserted).size());
+        TS_CHECK(max_gap(index) <= TS_OFFSET_INDEX_INTERVAL);
+        if (i % 10 == 0) check_translation(index, text);
+    }
+    check_translation(index, text);
+}
+
+TS_TEST(translate_surrogate_pairs) {
+    // a😀b, the pair is the code units 1 and 2, and the bytes 1 until 5
+    std::u16string text = u"a\U0001F600b";
+    TSOffsetIndex index(text.data(), static_cast<uint32_t>(text.size()));
+    TS_CHECK_EQ(index.to_utf8(1), 1);
+    TS_CHECK_EQ(index.to_utf8(2), 5);
+    TS_CHECK_EQ(index.to_utf8(3), 5);
+    TS_CHECK_EQ(index.to_utf16(3), 1);
+    TS_CHECK_EQ(index.to_utf16(5), 3);
+
+    // insert another pair before the first one
+    std::u16string pair = u"\U0001F680";
+    uint32_t start8, end8, new_end8;
+    index.edit(1, 1, pair.data(), static_cast<uint32_t>(pair.size()), &start8, &end8, &new_end8);
+    text.insert(1, pair);
+    TS_CHECK_EQ(start8, 1);
+    TS_CHECK_EQ(new_end8, 5);
+    check_translation(index, text);
+
+    // an unpaired surrogate is kept as U+FFFD, one code unit of 3 bytes
+    std::u16string lone = u"\xd800";
+    index.edit(0, 0, lone.data(), 1, &start8, &end8, &new_end8);
+    TS_CHECK_EQ(new_end8, 3);
+    TS_CHECK_EQ(index.to_utf8(1), 3);
+    TS_CHECK_EQ(index.to_utf16(3), 1);
+}
+
+TS_TEST(checkpoints_bounded_when_typing) {
+    std::mt19937 random(3);
+    std::u16string text = random_text(random, 4000);
+    TSOffsetIndex index(text.data(), static_cast<uint32_t>(text.size()));
+    uint32_t cursor = random_offset(random, text);
+    // type one character at a time, which never inserts a checkpoint by itself
+    for (int i = 0; i < 10000; ++i) {
+        std::u16string c = random_text(random, 1);
+        uint32_t start8, end8, new_end8;
+        index.edit(cursor, cursor, c.data(), static_cast<uint32_t>(c.size()), &start8, &end8, &new_end8);
+        text.insert(cursor, c);
+        cursor += static_cast<uint32_t>(c.size());
+        TS_CHECK(max_gap(index) <= TS_OFFSET_INDEX_INTERVAL);
+    }
+    check_translation(index, text);
+
+    // delete it back one character at a time from the end
+    while (text.size() > 100) {
+        uint32_t end = static_cast<uint32_t>(text.size());
+        uint32_t start = end - (is_low_surrogate(text[end - 1]) ? 2 : 1);
+        uint32_t start8, end8, new_end8;
+        index.edit(start, end, nullptr, 0, &start8, &end8, &new_end8);
+        text.erase(start);
+        TS_CHECK(max_gap(index) <= TS_OFFSET_INDEX_INTERVAL);
+    }
+    check_translation(index, text);
+}
+
+TS_TEST(copies_are_independent) {
+    std::mt19937 random(4);
+    std::u16string text = random_text(random, 30000);
+    TSOffsetIndex index(text.data(), static_cast<uint32_t>(text.size()));
+    TSOffsetIndex copy(index);
+    std::u16string copied = text;
+
+    // a worker reads the copy while the original is edited, the blocks are shared but never changed
+    std::thread worker([&] {
+        for (int i = 0; i < 20; ++i) check_translation(copy, copied);
+    });
+    for (int i = 0; i < 500; ++i) {
+        uint32_t start = random_offset(random, text);
+        std::u16string inserted = random_text(random, random() % 4);
+        uint32_t end = std::min<uint32_t>(start + random() % 3, static_cast<uint32_t>(text.size()));
+        if (end < text.size() && is_low_surrogate(text[end])) end += 1;
+        uint32_t start8, end8, new_end8;
+        index.edit(start, end, inserted.data(), static_cast<uint32_t>(inserted.size()), &start8, &end8, &new_end8);
+        text.replace(start, end - start, inserted);
+    }
+    worker.join();
+    check_translation(index, text);
+    check_translation(copy, copied);
+
+    // and the copy is edited without changing the original
+    std::u16string inserted = u"copy";
+    uint32_t start8, end8, new_end8;
+    copy.edit(0, 10, inserted.data(), static_cast<uint32_t>(inserted.size()), &start8, &end8, &new_end8);
+    copied.replace(0, 10, inserted);
+    check_translation(copy, copied);
+    check_translation(index, text);
+}
+
+TS_TEST(blocks_split_at_characters) {
+    // 3 bytes characters only, the middle of the document is in the middle of a character
+    std::u16string text(3001, u'中');
+    TSOffsetIndex index(text.data(), static_cast<uint32_t>(text.size()));
+    check_translation(index, text);
+
+    // shift the characters by one byte around the block ends, with the 2 and 4 bytes ones too
+    std::mt19937 random(5);
+    for (int i = 0; i < 200; ++i) {
+        static const std::u16string samples[] = {u"a", u"é", u"中", u"\U0001F600"};
+        const std::u16string &inserted = samples[random() % 4];
+        uint32_t start = random_offset(random, text);
+        uint32_t start8, end8, new_end8;
+        index.edit(start, start, inserted.data(), static_cast<uint32_t>(inserted.size()), &start8, &end8, &new_end8);
+        text.insert(start, inserted);
+        TS_CHECK(decode_segments(index) == text);
+    }
+    check_translation(index, text);
+
+    // a block is merged with its neighbor and split again
+    uint32_t end = static_cast<uint32_t>(text.size()) - 100;
+    if (is_low_surrogate(text[end])) end += 1;
+    uint32_t start8, end8, new_end8;
+    index.edit(100, end, nullptr, 0, &start8, &end8, &new_end8);
+    text.erase(100, end - 100);
+    check_translation(index, text);
+}
+
+TS_TEST(delete_everything) {
+    std::u16string text = u"int main() { return 0; }";
+    TSOffsetIndex index(text.data(), static_cast<uint32_t>(text.size()));
+    uint32_t start8, end8, new_end8;
+    index.edit(0, static_cast<uint32_t>(text.size()), nullptr, 0, &start8, &end8, &new_end8);
+    check_translation(index, u"");
+    std::u16string inserted = u"😀x";
+    index.edit(0, 0, inserted.data(), static_cast<uint32_t>(inserted.size()), &start8, &end8, &new_end8);
+    check_translation(index, inserted);
+}
+
+TS_TEST_MAIN()
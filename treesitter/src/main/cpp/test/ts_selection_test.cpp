@@ -0,0 +1,214 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// the structural selection and the text objects of TSSelection by the C grammar,
+// the textobjects query has the text predicates and #make-range!
+//
+// usage: ts-selection-test [filter]
+
+#include <string.h>
+
+#include "test_utils.h"
+#include "test_document.h"
+#include "../ts_selection.h"
+
+static const char *TEXTOBJECTS =
+    "(function_definition) @function.outer\n"
+    "((function_definition declarator: (function_declarator declarator: (identifier) @_name)) @function.main\n"
+    "  (#eq? @_name \"main\"))\n"
+    "((call_expression function: (identifier) @_function) @call.print\n"
+    "  (#match? @_function \"^print\"))\n"
+    "((identifier) @constant (#match? @constant \"^[A-Z][A-Z_]*$\"))\n"
+    "((primitive_type) @type.long (#any-of? @type.long \"long\" \"short\"))\n"
+    "((identifier) @variable (#not-eq? @variable \"MAX_SIZE\"))\n"
+    "(function_definition declarator: (_) @_start body: (_) @_end\n"
+    "  (#make-range! \"function.tail\" @_start @_end))\n";
+
+static const char16_t *SOURCE =
+    u"int add(int a, int b) {\n"
+    u"  return a + b;\n"
+    u"}\n"
+    u"\n"
+    u"long main(void) {\n"
+    u"  int MAX_SIZE = 10;\n"
+    u"  printf(\"%d\", add(1, MAX_SIZE));\n"
+    u"  puts(\"done\");\n"
+    u"  return 0;\n"
+    u"}\n";
+
+using Range = TSSelection::Range;
+
+static TSQuery *query_of(const char *source) {
+    uint32_t error_offset;
+    TSQueryError error;
+    TSQuery *query = ts_query_new(tree_sitter_c(), source, static_cast<uint32_t>(strlen(source)), &error_offset, &error);
+    TS_CHECK(query != nullptr);
+    return query;
+}
+
+struct Fixture {
+    TSQuery *textobjects = query_of(TEXTOBJECTS);
+    test::Document document {tree_sitter_c(), SOURCE};
+    TSSelection selection {textobjects};
+
+    ~Fixture() { ts_query_delete(textobjects); }
+
+    // the range of the n-th occurrence of the word
+    Range word(const std::string &value, int n = 0) const {
+        uint32_t start = document.find(value, n);
+        return {start, start + static_cast<uint32_t>(value.size())};
+    }
+
+    // the range of a function, from its type until the closing brace
+    Range function(const std::string &type, const std::string &end) const {
+        return {document.find(type), document.find(end) + static_cast<uint32_t>(end.size())};
+    }
+
+    std::string text(Range range) const { return document.text().substr(range.start, range.end - range.start); }
+
+    std::string expand(Range range) {
+        Range out;
+        return selection.expand(document.tree(), range, out) ? text(out) : "";
+    }
+
+    std::string shrink(Range range) {
+        Range out;
+        return selection.shrink(document.tree(), range, out) ? text(out) : "";
+    }
+
+    std::string select(const std::string &capture, Range range) {
+        Range out;
+        return selection.select(document.tree(), document.index(), capture, range, out) ? text(out) : "";
+    }
+
+    std::string move(const std::string &capture, uint32_t byte, bool forward) {
+        Range out;
+        return selection.move(document.tree(), document.index(), capture, byte, forward, out) ? text(out) : "";
+    }
+};
+
+static Range caret(uint32_t byte) { return {byte, byte}; }
+
+TS_TEST(expand_and_shrink) {
+    Fixture f;
+    Range range = caret(f.document.find("MAX_SIZE") + 2);
+    Range out;
+    const char *levels[] = {"MAX_SIZE", "MAX_SIZE = 10", "int MAX_SIZE = 10;"};
+    for (const char *level : levels) {
+        TS_CHECK(f.selection.expand(f.document.tree(), range, out));
+        TS_CHECK(f.text(out) == level);
+        range = out;
+    }
+    // the body, then the function
+    TS_CHECK(f.selection.expand(f.document.tree(), range, out));
+    TS_CHECK_EQ(out.start, f.document.find("{", 1));
+    TS_CHECK(f.selection.expand(f.document.tree(), out, out));
+    TS_CHECK(f.text(out) == f.text(f.function("long main", "return 0;\n}")));
+    range = out;
+
+    // back down the cached chain to the caret
+    TS_CHECK(f.shrink(range) == f.text({f.document.find("{", 1), range.end}));
+    TS_CHECK(f.selection.shrink(f.document.tree(), {f.document.find("{", 1), range.end}, out));
+    TS_CHECK(f.text(out) == "int MAX_SIZE = 10;");
+    TS_CHECK(f.shrink(out) == "MAX_SIZE = 10");
+    TS_CHECK(f.shrink(f.word("MAX_SIZE = 10")) == "MAX_SIZE");
+    TS_CHECK(f.selection.shrink(f.document.tree(), f.word("MAX_SIZE"), out));
+    TS_CHECK_EQ(out.start, out.end);
+    TS_CHECK(!f.selection.shrink(f.document.tree(), out, out));
+}
+
+// a selection not made by expand shrinks to the largest node at its start
+TS_TEST(shrink_other_selection) {
+    Fixture f;
+    TS_CHECK(f.shrink(f.function("int add", "a + b;\n}")) == "int");
+    TS_CHECK(f.shrink(f.word("a + b")) == "a");
+}
+
+TS_TEST(sibling_statements) {
+    Fixture f;
+    Range range = caret(f.document.find("printf") + 1);
+    Range out;
+    for (int i = 0; i < 3; ++i) {
+        TS_CHECK(f.selection.expand(f.document.tree(), range, out));
+        range = out;
+    }
+    TS_CHECK(f.text(range) == "printf(\"%d\", add(1, MAX_SIZE));");
+    TS_CHECK(f.selection.sibling(f.document.tree(), range, true, out));
+    TS_CHECK(f.text(out) == "puts(\"done\");");
+    TS_CHECK(f.selection.sibling(f.document.tree(), out, true, out));
+    TS_CHECK(f.text(out) == "return 0;");
+    TS_CHECK(!f.selection.sibling(f.document.tree(), out, true, out));
+    TS_CHECK(f.selection.sibling(f.document.tree(), out, false, out));
+    TS_CHECK(f.text(out) == "puts(\"done\");");
+    // the sibling keeps the ancestors, so it's expanded to the body
+    TS_CHECK(f.selection.expand(f.document.tree(), out, out));
+    TS_CHECK_EQ(out.start, f.document.find("{", 1));
+}
+
+TS_TEST(select_text_objects) {
+    Fixture f;
+    std::string add = f.text(f.function("int add", "a + b;\n}"));
+    std::string main = f.text(f.function("long main", "return 0;\n}"));
+    TS_CHECK(f.select("function.outer", caret(f.document.find("a + b"))) == add);
+    TS_CHECK(f.select("function.outer", caret(f.document.find("MAX_SIZE"))) == main);
+    // the enclosing object only, so selecting it again finds nothing
+    TS_CHECK(f.select("function.outer", f.function("int add", "a + b;\n}")).empty());
+    TS_CHECK(f.select("class.outer", caret(0)).empty());
+}
+
+TS_TEST(text_predicates) {
+    Fixture f;
+    // #eq? of a helper capture
+    TS_CHECK(f.select("function.main", caret(f.document.find("MAX_SIZE"))) == f.text(f.function("long main", "return 0;\n}")));
+    TS_CHECK(f.select("function.main", caret(f.document.find("a + b"))).empty());
+    // #match?, the call of puts doesn't match
+    TS_CHECK(f.move("call.print", 0, true) == "printf(\"%d\", add(1, MAX_SIZE))");
+    TS_CHECK(f.move("call.print", f.document.find("printf"), true).empty());
+    TS_CHECK(f.move("constant", 0, true) == "MAX_SIZE");
+    TS_CHECK(f.move("constant", f.document.find("MAX_SIZE"), true) == "MAX_SIZE");
+    TS_CHECK(f.move("constant", f.document.find("MAX_SIZE", 1), true).empty());
+    // #any-of?, the int types don't match
+    TS_CHECK(f.move("type.long", 0, true) == "long");
+    TS_CHECK(f.move("type.long", f.document.find("long"), true).empty());
+    // #not-eq?, the identifiers but MAX_SIZE
+    uint32_t byte = f.document.find("MAX_SIZE = 10") - 1;
+    TS_CHECK(f.move("variable", byte, true) == "printf");
+    TS_CHECK(f.move("variable", f.document.find("printf"), false) == "main");
+}
+
+TS_TEST(make_range) {
+    Fixture f;
+    // from the declarator to the end of the body, without the return type
+    TS_CHECK(f.select("function.tail", caret(f.document.find("a + b"))) == f.text(f.function("add(int a", "a + b;\n}")));
+    TS_CHECK(f.move("function.tail", f.document.find("add"), true) == f.text(f.function("main(void)", "return 0;\n}")));
+    // the helper captures are never objects
+    TS_CHECK(f.select("_start", caret(f.document.find("a + b"))).empty());
+    TS_CHECK(f.move("_name", 0, true).empty());
+    TS_CHECK(f.move("_function", 0, true).empty());
+}
+
+// the objects are collected again for the edited tree after a reset
+TS_TEST(reset_after_edit) {
+    Fixture f;
+    TS_CHECK(f.move("call.print", 0, true) == "printf(\"%d\", add(1, MAX_SIZE))");
+    uint32_t puts = f.document.find("puts");
+    f.document.replace(puts, puts + 4, "print");
+    f.selection.reset();
+    TS_CHECK(f.move("call.print", f.document.find("printf"), true) == "print(\"done\")");
+}
+
+TS_TEST_MAIN()
@@ -0,0 +1,90 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// the style runs resolved over the capture bounds, checked against
+// painting the captures column by column
+//
+// usage: ts-style-table-test [filter]
+
+#include <random>
+
+#include "test_utils.h"
+#include "../ts_style_table.h"
+
+// every third id has no style, and the different ids may share a style
+static uint64_t style_of(int32_t id) { return id % 3 == 0 ? TS_STYLE_NONE : id % 5; }
+
+// paint the captures in order over every column, then merge the same styles
+static std::vector<int32_t> paint_columns(const std::vector<int32_t> &captures, int32_t start, int32_t end) {
+    std::vector<int32_t> runs;
+    if (end <= start) return runs;
+    std::vector<int32_t> owners(end - start, -1);
+    for (size_t i = 0; i < captures.size(); i += TS_STYLE_RUN_STRIDE) {
+        int32_t id = captures[i + 2];
+        if (style_of(id) == TS_STYLE_NONE) continue;
+        int32_t from = std::max(captures[i], start), to = std::min(captures[i + 1], end);
+        for (int32_t column = from; column < to; ++column) owners[column - start] = id;
+    }
+    for (size_t i = 0, j; i < owners.size(); i = j) {
+        uint64_t style = owners[i] < 0 ? TS_STYLE_NONE : style_of(owners[i]);
+        for (j = i + 1; j < owners.size(); ++j) {
+            if ((owners[j] < 0 ? TS_STYLE_NONE : style_of(owners[j])) != style) break;
+        }
+        runs.push_back(start + static_cast<int32_t>(i));
+        runs.push_back(start + static_cast<int32_t>(j));
+        runs.push_back(owners[i]);
+    }
+    return runs;
+}
+
+static std::vector<int32_t> resolve(const std::vector<int32_t> &captures, int32_t start, int32_t end) {
+    return ts_style_resolve_runs(captures.data(), captures.size() / TS_STYLE_RUN_STRIDE, start, end, style_of);
+}
+
+TS_TEST(nested_captures) {
+    // the inner captures are after the outer ones, the id 3 has no style and is skipped
+    std::vector<int32_t> captures {0, 20, 1, 4, 10, 2, 5, 9, 4, 12, 14, 3};
+    std::vector<int32_t> runs = resolve(captures, 0, 20);
+    TS_CHECK(runs == (std::vector<int32_t> {0, 4, 1, 4, 5, 2, 5, 9, 4, 9, 10, 2, 10, 20, 1}));
+    TS_CHECK(runs == paint_columns(captures, 0, 20));
+}
+
+TS_TEST(clipped_to_range) {
+    std::vector<int32_t> captures {0, 8, 1, 6, 30, 2};
+    TS_CHECK(resolve(captures, 4, 12) == (std::vector<int32_t> {4, 6, 1, 6, 12, 2}));
+    TS_CHECK(resolve(captures, 12, 12).empty());
+    TS_CHECK(resolve({}, 0, 3) == (std::vector<int32_t> {0, 3, -1}));
+}
+
+TS_TEST(same_as_columns) {
+    std::mt19937 random(1);
+    for (int round = 0; round < 20000; ++round) {
+        std::vector<int32_t> captures;
+        uint32_t count = random() % 8;
+        for (uint32_t i = 0; i < count; ++i) {
+            int32_t from = static_cast<int32_t>(random() % 60);
+            captures.push_back(from);
+            captures.push_back(from + static_cast<int32_t>(random() % 30));
+            captures.push_back(static_cast<int32_t>(random() % 20));
+        }
+        int32_t start = static_cast<int32_t>(random() % 40);
+        int32_t end = start + static_cast<int32_t>(random() % 40);
+        TS_CHECK(resolve(captures, start, end) == paint_columns(captures, start, end));
+    }
+}
+
+TS_TEST_MAIN()
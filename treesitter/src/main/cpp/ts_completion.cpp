@@ -0,0 +1,122 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ts_utils.h"
+#include "ts_completion.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// decode a UTF-8 word, NewStringUTF takes the modified UTF-8 which differs for the supplementary characters
+static jstring new_string(JNIEnv *env, const std::string &word) {
+    std::u16string text;
+    text.reserve(word.size());
+    uint32_t code = 0, remaining = 0;
+    for (char byte : word) {
+        uint8_t c = static_cast<uint8_t>(byte);
+        if (remaining > 0) {
+            code = (code << 6) | (c & 0x3f);
+            if (--remaining > 0) continue;
+        } else if (c < 0x80) {
+            code = c;
+        } else {
+            remaining = c >= 0xf0 ? 3 : c >= 0xe0 ? 2 : 1;
+            code = c & (0x3f >> remaining);
+            continue;
+        }
+        if (code >= 0x10000) {
+            text += static_cast<char16_t>(0xd800 + ((code - 0x10000) >> 10));
+            text += static_cast<char16_t>(0xdc00 + ((code - 0x10000) & 0x3ff));
+        } else {
+            text += static_cast<char16_t>(code);
+        }
+    }
+    return env->NewString(reinterpret_cast<const jchar*>(text.data()), static_cast<jsize>(text.size()));
+}
+
+jlong JNICALL completion_init(JNIEnv *env, jclass clazz, jshortArray identifiers) {
+    jsize count = env->GetArrayLength(identifiers);
+    std::vector<uint16_t> symbols(count);
+    env->GetShortArrayRegion(identifiers, 0, count, reinterpret_cast<jshort*>(symbols.data()));
+    return reinterpret_cast<jlong>(new TSCompletion(symbols));
+}
+
+void JNICALL completion_delete CRITICAL_ARGS(jlong completion) {
+    delete reinterpret_cast<TSCompletion*>(completion);
+}
+
+void JNICALL completion_native_update(JNIEnv *env, jobject thiz, jobject tree, jobject old_tree, jobject index) {
+    TSCompletion *self = GET_POINTER(TSCompletion, thiz);
+    TSTree *tree_ptr = GET_POINTER(TSTree, tree);
+    TSTree *old_tree_ptr = old_tree ? GET_POINTER(TSTree, old_tree) : nullptr;
+    TSOffsetIndex *index_ptr = GET_POINTER(TSOffsetIndex, index);
+    self->update(tree_ptr, old_tree_ptr, index_ptr);
+}
+
+void JNICALL completion_reset(JNIEnv *env, jobject thiz) {
+    TSCompletion *self = GET_POINTER(TSCompletion, thiz);
+    self->reset();
+}
+
+// the words are returned, the kinds of the words are written to the info array
+// followed by the start byte of the word being typed, the info has max_results + 1 slots
+jobjectArray JNICALL completion_native_complete(
+    JNIEnv *env, jobject thiz, jobject tree, jobject index, jint byte, jintArray info
+) {
+    TSCompletion *self = GET_POINTER(TSCompletion, thiz);
+    TSTree *tree_ptr = GET_POINTER(TSTree, tree);
+    TSOffsetIndex *index_ptr = GET_POINTER(TSOffsetIndex, index);
+    jsize max_results = env->GetArrayLength(info) - 1;
+    if (max_results < 0) {
+        THROW(IllegalArgumentException, "The info array must have at least one slot");
+        return nullptr;
+    }
+
+    std::vector<TSCompletion::Item> items;
+    uint32_t start = self->complete(
+        tree_ptr, index_ptr, static_cast<uint32_t>(std::max(byte, 0)), static_cast<size_t>(max_results), items
+    );
+    jsize size = static_cast<jsize>(items.size());
+    std::vector<jint> values(size + 1);
+    jclass string_class = env->FindClass("java/lang/String");
+    jobjectArray words = env->NewObjectArray(size, string_class, nullptr);
+    for (jsize i = 0; i < size; ++i) {
+        jstring word = new_string(env, items[i].text);
+        env->SetObjectArrayElement(words, i, word);
+        env->DeleteLocalRef(word);
+        values[i] = static_cast<jint>(items[i].kind);
+    }
+    values[size] = static_cast<jint>(start);
+    env->SetIntArrayRegion(info, 0, size, values.data());
+    env->SetIntArrayRegion(info, max_results, 1, values.data() + size);
+    env->DeleteLocalRef(string_class);
+    return words;
+}
+
+extern const JNINativeMethod TSCompletion_methods[] = {
+    {"init", "([S)J", (void *)&completion_init},
+    {"delete", "(J)V", (void *)&completion_delete},
+    {"nativeUpdate", "(L" PACKAGE "TSTree;L" PACKAGE "TSTree;L" PACKAGE "TSOffsetIndex;)V", (void *)&completion_native_update},
+    {"reset", "()V", (void *)&completion_reset},
+    {"nativeComplete", "(L" PACKAGE "TSTree;L" PACKAGE "TSOffsetIndex;I[I)[Ljava/lang/String;", (void *)&completion_native_complete},
+};
+
+extern const size_t TSCompletion_methods_size = sizeof TSCompletion_methods / sizeof(JNINativeMethod);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
@@ -0,0 +1,323 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __TS_COMPLETION_H__
+#define __TS_COMPLETION_H__
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <tree_sitter/api.h>
+
+#include "ts_offset_index.h"
+#include "ts_partitions.h"
+
+// the kinds of a completion, keep the same values as TSCompletion.kt
+#define TS_COMPLETION_KEYWORD 0
+#define TS_COMPLETION_IDENTIFIER 1
+
+// the score of a keyword valid in the parse state, an identifier scores its occurrences
+#define TS_COMPLETION_KEYWORD_SCORE 3
+
+// the trie is rebuilt once this many words were removed, and they are a quarter of the nodes
+#define TS_COMPLETION_DEAD_WORDS 1024
+
+// the completions at a byte, the keywords which are valid in the parse state before the
+// word being typed, merged with the identifiers of the document which start with the word.
+// The identifiers are kept in a byte trie with the number of their occurrences, split by
+// the children of the root like TSLocals, after a reparse only the words of the changed
+// children are removed from the trie and harvested again, the removed words keep their
+// nodes until enough of them pile up, then the trie is rebuilt from the live words
+class TSCompletion {
+public:
+    struct Item {
+        std::string text;
+        uint32_t kind;
+        uint32_t score;
+    };
+
+    explicit TSCompletion(const std::vector<uint16_t> &identifiers) {
+        for (uint16_t symbol : identifiers) {
+            if (symbol / 64U >= bitmap_.size()) bitmap_.resize(symbol / 64U + 1, 0);
+            bitmap_[symbol / 64U] |= 1ULL << (symbol % 64U);
+        }
+        nodes_.emplace_back();
+    }
+
+    // harvest the identifiers of the tree, the old tree is the edited tree of the last update,
+    // the whole tree is harvested if there is no old tree or it's not the tree of the last update
+    void update(const TSTree *tree, const TSTree *old_tree, const TSOffsetIndex *index) {
+        std::vector<Partition> old = std::move(partitions_);
+        partitions_.clear();
+        std::vector<bool> kept = ts_split_partitions(
+            tree, old_tree == tree_ ? old_tree : nullptr, old,
+            [&](Partition &partition, TSNode child) { partitions_.push_back(std::move(partition)); },
+            [&](TSNode child) { partitions_.push_back(harvest(child, index)); }
+        );
+        // the words of the children harvested again are counted twice until removed here
+        for (size_t i = 0; i < old.size(); ++i) {
+            if (kept[i]) continue;
+            for (uint32_t node : old[i].words) {
+                if (--nodes_[node].count == 0) ++dead_;
+            }
+        }
+        if (dead_ >= TS_COMPLETION_DEAD_WORDS && dead_ * 4 >= nodes_.size()) compact();
+        tree_ = tree;
+    }
+
+    // forget the identifiers, so the next update harvests the whole tree
+    void reset() {
+        partitions_.clear();
+        nodes_.clear();
+        nodes_.emplace_back();
+        dead_ = 0;
+        tree_ = nullptr;
+    }
+
+    // the number of the trie nodes, the removed words included until the trie is rebuilt
+    size_t node_count() const { return nodes_.size(); }
+
+    // the completions of the word before the byte, ranked by the score, then the length,
+    // the start byte of the word is returned, the word itself is not completed
+    uint32_t complete(const TSTree *tree, const TSOffsetIndex *index, uint32_t byte, size_t max_results,
+                      std::vector<Item> &out) const {
+        uint32_t start = word_start(index, byte);
+        std::string prefix = text(index, start, byte);
+        std::vector<Item> items;
+
+        // the state after the last token before the word, the state 0 is unknown
+        const TSLanguage *language = ts_tree_language(tree);
+        TSStateId state = 1;
+        uint32_t previous = start;
+        while (previous > 0 && is_space(byte_at(index, previous - 1))) --previous;
+        if (previous > 0) {
+            TSNode leaf = ts_node_descendant_for_byte_range(ts_tree_root_node(tree), previous - 1, previous);
+            state = ts_node_is_null(leaf) ? 0 : ts_node_next_parse_state(leaf);
+        }
+        bool accepts_identifier = state == 0;
+        if (state != 0) {
+            TSLookaheadIterator *iterator = ts_lookahead_iterator_new(language, state);
+            while (iterator != nullptr && ts_lookahead_iterator_next(iterator)) {
+                TSSymbol symbol = ts_lookahead_iterator_current_symbol(iterator);
+                if (is_identifier(symbol)) {
+                    accepts_identifier = true;
+                    continue;
+                }
+                if (ts_language_symbol_type(language, symbol) != TSSymbolTypeAnonymous) continue;
+                std::string name = ts_language_symbol_name(language, symbol);
+                if (is_keyword(name) && name.size() > prefix.size() && name.compare(0, prefix.size(), prefix) == 0) {
+                    items.push_back({std::move(name), TS_COMPLETION_KEYWORD, TS_COMPLETION_KEYWORD_SCORE});
+                }
+            }
+            if (iterator != nullptr) ts_lookahead_iterator_delete(iterator);
+        }
+
+        if (accepts_identifier && !prefix.empty()) {
+            uint32_t node = find(prefix);
+            if (node != UINT32_MAX) {
+                std::string word = prefix;
+                collect(node, word, items);
+            }
+            // the word being typed is an identifier of the tree too
+            items.erase(std::remove_if(items.begin(), items.end(), [&](const Item &item) {
+                return item.kind == TS_COMPLETION_IDENTIFIER && item.text == prefix;
+            }), items.end());
+        }
+
+        // a keyword like `if` may be an identifier of the tree too, keep the keyword
+        std::sort(items.begin(), items.end(), [](const Item &a, const Item &b) {
+            return a.text < b.text || (a.text == b.text && a.kind < b.kind);
+        });
+        items.erase(std::unique(items.begin(), items.end(), [](const Item &a, const Item &b) {
+            return a.text == b.text;
+        }), items.end());
+        size_t count = std::min(max_results, items.size());
+        std::partial_sort(items.begin(), items.begin() + count, items.end(), [](const Item &a, const Item &b) {
+            if (a.score != b.score) return a.score > b.score;
+            if (a.text.size() != b.text.size()) return a.text.size() < b.text.size();
+            return a.text < b.text;
+        });
+        items.resize(count);
+        out = std::move(items);
+        return start;
+    }
+
+private:
+    // a node of the byte trie, the count is the number of the occurrences of its word
+    struct Node {
+        std::vector<std::pair<uint8_t, uint32_t>> children;
+        uint32_t count = 0;
+    };
+
+    // the words of a child of the root, the trie nodes of every occurrence
+    struct Partition {
+        uint32_t length;
+        std::vector<uint32_t> words;
+    };
+
+    static bool is_space(uint8_t c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+    // the bytes of an identifier, the non-ASCII bytes are letters of most grammars
+    static bool is_word(uint8_t c) {
+        return c >= 0x80 || c == '_' || c == '$' || (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z');
+    }
+
+    // the anonymous symbols like `if` and `return`, not the operators
+    static bool is_keyword(const std::string &name) {
+        if (name.empty() || !(name[0] == '_' || ((name[0] | 0x20) >= 'a' && (name[0] | 0x20) <= 'z'))) return false;
+        return std::all_of(name.begin(), name.end(), [](char c) { return is_word(static_cast<uint8_t>(c)); });
+    }
+
+    bool is_identifier(TSSymbol symbol) const {
+        return symbol / 64U < bitmap_.size() && (bitmap_[symbol / 64U] >> (symbol % 64U) & 1U);
+    }
+
+    static uint8_t byte_at(const TSOffsetIndex *index, uint32_t offset) {
+        uint32_t length;
+        return static_cast<uint8_t>(*index->segment(offset, &length));
+    }
+
+    static uint32_t word_start(const TSOffsetIndex *index, uint32_t byte) {
+        byte = std::min(byte, index->utf8_length());
+        while (byte > 0 && is_word(byte_at(index, byte - 1))) --byte;
+        return byte;
+    }
+
+    static std::string text(const TSOffsetIndex *index, uint32_t start, uint32_t end) {
+        std::string result;
+        result.reserve(end - start);
+        while (start < end) {
+            uint32_t length;
+            const char *p = index->segment(start, &length);
+            if (length == 0) break;
+            length = std::min(length, end - start);
+            result.append(p, length);
+            start += length;
+        }
+        return result;
+    }
+
+    // the trie node of the word, created if absent
+    uint32_t insert(const std::string &word) {
+        uint32_t node = 0;
+        for (char c : word) {
+            uint8_t byte = static_cast<uint8_t>(c);
+            auto &children = nodes_[node].children;
+            auto it = std::lower_bound(
+                children.begin(), children.end(), byte,
+                [](const std::pair<uint8_t, uint32_t> &child, uint8_t value) { return child.first < value; }
+            );
+            if (it != children.end() && it->first == byte) {
+                node = it->second;
+            } else {
+                uint32_t next = static_cast<uint32_t>(nodes_.size());
+                children.insert(it, {byte, next});
+                // the reference is invalidated by the growth of the nodes
+                nodes_.emplace_back();
+                node = next;
+            }
+        }
+        return node;
+    }
+
+    uint32_t find(const std::string &word) const {
+        uint32_t node = 0;
+        for (char c : word) {
+            uint8_t byte = static_cast<uint8_t>(c);
+            const auto &children = nodes_[node].children;
+            auto it = std::lower_bound(
+                children.begin(), children.end(), byte,
+                [](const std::pair<uint8_t, uint32_t> &child, uint8_t value) { return child.first < value; }
+            );
+            if (it == children.end() || it->first != byte) return UINT32_MAX;
+            node = it->second;
+        }
+        return node;
+    }
+
+    // the words of the subtree, the removed words keep their nodes with the count 0
+    void collect(uint32_t node, std::string &word, std::vector<Item> &out) const {
+        if (nodes_[node].count > 0) out.push_back({word, TS_COMPLETION_IDENTIFIER, nodes_[node].count});
+        for (const auto &[byte, child] : nodes_[node].children) {
+            word.push_back(static_cast<char>(byte));
+            collect(child, word, out);
+            word.pop_back();
+        }
+    }
+
+    // rebuild the trie from the words with a count, and map the words of the partitions to it
+    void compact() {
+        std::vector<Node> old = std::move(nodes_);
+        nodes_.clear();
+        nodes_.emplace_back();
+        std::vector<uint32_t> remap(old.size(), UINT32_MAX);
+        std::string word;
+        copy(old, 0, word, remap);
+        for (Partition &partition : partitions_) {
+            for (uint32_t &node : partition.words) node = remap[node];
+        }
+        dead_ = 0;
+    }
+
+    void copy(const std::vector<Node> &old, uint32_t node, std::string &word, std::vector<uint32_t> &remap) {
+        if (old[node].count > 0) {
+            remap[node] = insert(word);
+            nodes_[remap[node]].count = old[node].count;
+        }
+        for (const auto &[byte, child] : old[node].children) {
+            word.push_back(static_cast<char>(byte));
+            copy(old, child, word, remap);
+            word.pop_back();
+        }
+    }
+
+    // count the identifiers of the child, the subtrees of an identifier are not visited
+    Partition harvest(TSNode child, const TSOffsetIndex *index) {
+        Partition partition {ts_node_end_byte(child) - ts_node_start_byte(child), {}};
+        TSTreeCursor cursor = ts_tree_cursor_new(child);
+        bool ok = true;
+        while (ok) {
+            TSNode node = ts_tree_cursor_current_node(&cursor);
+            if (is_identifier(ts_node_symbol(node))) {
+                uint32_t word = insert(text(index, ts_node_start_byte(node), ts_node_end_byte(node)));
+                ++nodes_[word].count;
+                partition.words.push_back(word);
+            } else if (ts_tree_cursor_goto_first_child(&cursor)) {
+                continue;
+            }
+            while (!(ok = ts_tree_cursor_goto_next_sibling(&cursor))) {
+                if (!ts_tree_cursor_goto_parent(&cursor)) break;
+            }
+        }
+        ts_tree_cursor_delete(&cursor);
+        return partition;
+    }
+
+    std::vector<uint64_t> bitmap_;
+    std::vector<Node> nodes_;
+    std::vector<Partition> partitions_;
+    // the words removed since the trie was built, some may be harvested again
+    size_t dead_ = 0;
+    // only compared with the old tree of the next update, never dereferenced
+    const TSTree *tree_ = nullptr;
+};
+
+#endif // __TS_COMPLETION_H__
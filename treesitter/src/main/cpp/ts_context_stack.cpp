@@ -0,0 +1,77 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ts_utils.h"
+#include "ts_context_stack.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+jlong JNICALL context_stack_init(JNIEnv *env, jclass clazz, jshortArray types) {
+    jsize count = env->GetArrayLength(types);
+    std::vector<uint16_t> symbols(count);
+    env->GetShortArrayRegion(types, 0, count, reinterpret_cast<jshort*>(symbols.data()));
+    return reinterpret_cast<jlong>(new TSContextStack(symbols));
+}
+
+void JNICALL context_stack_delete CRITICAL_ARGS(jlong stack) {
+    delete reinterpret_cast<TSContextStack*>(stack);
+}
+
+// the levels packed as TS_CONTEXT_STRIDE values, outermost first, at most max_depth
+// of the innermost levels, a level without a name has the name range -1
+jintArray JNICALL context_stack_native_at(JNIEnv *env, jobject thiz, jobject tree, jint byte, jint max_depth) {
+    TSContextStack *self = GET_POINTER(TSContextStack, thiz);
+    TSTree *tree_ptr = GET_POINTER(TSTree, tree);
+    const std::vector<TSContextStack::Level> &levels = self->at(tree_ptr, static_cast<uint32_t>(std::max(byte, 0)));
+    size_t depth = std::min(levels.size(), static_cast<size_t>(std::max(max_depth, 0)));
+
+    std::vector<jint> values;
+    values.reserve(depth * TS_CONTEXT_STRIDE);
+    for (size_t i = levels.size() - depth; i < levels.size(); ++i) {
+        const TSContextStack::Level &level = levels[i];
+        values.insert(values.end(), {
+            static_cast<jint>(ts_node_symbol(level.node)),
+            static_cast<jint>(ts_node_start_point(level.node).row),
+            static_cast<jint>(level.start_byte),
+            static_cast<jint>(level.end_byte),
+            static_cast<jint>(level.name_start),
+            static_cast<jint>(level.name_end)
+        });
+    }
+    jintArray result = env->NewIntArray(static_cast<jsize>(values.size()));
+    env->SetIntArrayRegion(result, 0, static_cast<jsize>(values.size()), values.data());
+    return result;
+}
+
+void JNICALL context_stack_reset(JNIEnv *env, jobject thiz) {
+    TSContextStack *self = GET_POINTER(TSContextStack, thiz);
+    self->reset();
+}
+
+extern const JNINativeMethod TSContextStack_methods[] = {
+    {"init", "([S)J", (void *)&context_stack_init},
+    {"delete", "(J)V", (void *)&context_stack_delete},
+    {"nativeAt", "(L" PACKAGE "TSTree;II)[I", (void *)&context_stack_native_at},
+    {"reset", "()V", (void *)&context_stack_reset},
+};
+
+extern const size_t TSContextStack_methods_size = sizeof TSContextStack_methods / sizeof(JNINativeMethod);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
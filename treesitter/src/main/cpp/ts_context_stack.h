@@ -0,0 +1,115 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __TS_CONTEXT_STACK_H__
+#define __TS_CONTEXT_STACK_H__
+
+#include <stdint.h>
+
+#include <vector>
+
+#include <tree_sitter/api.h>
+
+// the number of jint values of a context level
+// [symbol, startRow, startByte, endByte, nameStartByte, nameEndByte]
+#define TS_CONTEXT_STRIDE 6
+
+// the chain of the enclosing scope nodes at a byte, like the class and the function of
+// the first visible line. The chain of the last byte is kept, the next byte only pops the
+// levels which don't contain it and descends from the innermost level which does, so
+// scrolling by a few lines doesn't walk from the root again
+class TSContextStack {
+public:
+    struct Level {
+        TSNode node;
+        uint32_t start_byte;
+        uint32_t end_byte;
+        uint32_t name_start;
+        uint32_t name_end;
+    };
+
+    explicit TSContextStack(const std::vector<uint16_t> &symbols) {
+        for (uint16_t symbol : symbols) {
+            if (symbol / 64U >= bitmap_.size()) bitmap_.resize(symbol / 64U + 1, 0);
+            bitmap_[symbol / 64U] |= 1ULL << (symbol % 64U);
+        }
+    }
+
+    // the levels enclosing the byte, outermost first, the nodes are only valid until the
+    // tree is edited or deleted. ts_tree_edit changes the tree in place, the root id and
+    // the tree are the same after it, so the owner must reset the stack on every edit
+    const std::vector<Level> &at(const TSTree *tree, uint32_t byte) {
+        TSNode root = ts_tree_root_node(tree);
+        if (tree != tree_) {
+            levels_.clear();
+            tree_ = tree;
+            const TSLanguage *language = ts_tree_language(tree);
+            name_field_ = ts_language_field_id_for_name(language, "name", 4);
+            declarator_field_ = ts_language_field_id_for_name(language, "declarator", 10);
+        }
+        while (!levels_.empty() && (byte < levels_.back().start_byte || byte >= levels_.back().end_byte)) {
+            levels_.pop_back();
+        }
+
+        TSTreeCursor cursor = ts_tree_cursor_new(levels_.empty() ? root : levels_.back().node);
+        while (ts_tree_cursor_goto_first_child_for_byte(&cursor, byte) >= 0) {
+            TSNode node = ts_tree_cursor_current_node(&cursor);
+            // the first child ending after the byte may start after it too
+            if (ts_node_start_byte(node) > byte) break;
+            TSSymbol symbol = ts_node_symbol(node);
+            if (symbol / 64U < bitmap_.size() && (bitmap_[symbol / 64U] >> (symbol % 64U) & 1U)) {
+                TSNode name = name_of(node);
+                levels_.push_back({
+                    node, ts_node_start_byte(node), ts_node_end_byte(node),
+                    ts_node_is_null(name) ? UINT32_MAX : ts_node_start_byte(name),
+                    ts_node_is_null(name) ? UINT32_MAX : ts_node_end_byte(name)
+                });
+            }
+        }
+        ts_tree_cursor_delete(&cursor);
+        return levels_;
+    }
+
+    void reset() {
+        levels_.clear();
+        tree_ = nullptr;
+    }
+
+private:
+    // the name field, or the innermost declarator like the C function declarator
+    TSNode name_of(TSNode node) const {
+        if (name_field_ != 0) {
+            TSNode name = ts_node_child_by_field_id(node, name_field_);
+            if (!ts_node_is_null(name)) return name;
+        }
+        if (declarator_field_ == 0) return TSNode {};
+        TSNode declarator = ts_node_child_by_field_id(node, declarator_field_);
+        while (!ts_node_is_null(declarator)) {
+            TSNode next = ts_node_child_by_field_id(declarator, declarator_field_);
+            if (ts_node_is_null(next)) break;
+            declarator = next;
+        }
+        return declarator;
+    }
+
+    std::vector<uint64_t> bitmap_;
+    std::vector<Level> levels_;
+    const TSTree *tree_ = nullptr;
+    TSFieldId name_field_ = 0;
+    TSFieldId declarator_field_ = 0;
+};
+
+#endif // __TS_CONTEXT_STACK_H__
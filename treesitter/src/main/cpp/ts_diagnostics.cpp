@@ -0,0 +1,131 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ts_utils.h"
+#include "ts_diagnostics.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+jlong JNICALL diagnostics_init CRITICAL_ARGS() {
+    return reinterpret_cast<jlong>(new TSDiagnostics());
+}
+
+void JNICALL diagnostics_delete CRITICAL_ARGS(jlong diagnostics) {
+    delete reinterpret_cast<TSDiagnostics*>(diagnostics);
+}
+
+void JNICALL diagnostics_native_update(JNIEnv *env, jobject thiz, jobject tree, jobject old_tree) {
+    TSDiagnostics *self = GET_POINTER(TSDiagnostics, thiz);
+    TSTree *tree_ptr = GET_POINTER(TSTree, tree);
+    TSTree *old_tree_ptr = old_tree ? GET_POINTER(TSTree, old_tree) : nullptr;
+    self->update(tree_ptr, old_tree_ptr);
+}
+
+void JNICALL diagnostics_reset(JNIEnv *env, jobject thiz) {
+    TSDiagnostics *self = GET_POINTER(TSDiagnostics, thiz);
+    self->reset();
+}
+
+jint JNICALL diagnostics_get_size(JNIEnv *env, jobject thiz) {
+    TSDiagnostics *self = GET_POINTER(TSDiagnostics, thiz);
+    return static_cast<jint>(self->diagnostics().size());
+}
+
+// the diagnostics packed as TS_DIAGNOSTIC_STRIDE values in the order of the start byte
+jintArray JNICALL diagnostics_get_diagnostics(JNIEnv *env, jobject thiz) {
+    TSDiagnostics *self = GET_POINTER(TSDiagnostics, thiz);
+    std::vector<jint> values;
+    values.reserve(self->diagnostics().size() * TS_DIAGNOSTIC_STRIDE);
+    for (const TSDiagnostic &diagnostic : self->diagnostics()) {
+        values.insert(values.end(), {
+            static_cast<jint>(diagnostic.start_byte),
+            static_cast<jint>(diagnostic.end_byte),
+            static_cast<jint>(diagnostic.start_point.row),
+            static_cast<jint>(diagnostic.start_point.column),
+            static_cast<jint>(diagnostic.end_point.row),
+            static_cast<jint>(diagnostic.end_point.column),
+            static_cast<jint>(diagnostic.kind),
+            static_cast<jint>(diagnostic.symbol),
+            static_cast<jint>(diagnostic.state)
+        });
+    }
+    jintArray result = env->NewIntArray(static_cast<jsize>(values.size()));
+    env->SetIntArrayRegion(result, 0, static_cast<jsize>(values.size()), values.data());
+    return result;
+}
+
+jlongArray JNICALL diagnostics_get_line_bitmap(JNIEnv *env, jobject thiz) {
+    TSDiagnostics *self = GET_POINTER(TSDiagnostics, thiz);
+    const std::vector<uint64_t> &lines = self->lines();
+    jlongArray result = env->NewLongArray(static_cast<jsize>(lines.size()));
+    env->SetLongArrayRegion(
+        result, 0, static_cast<jsize>(lines.size()), reinterpret_cast<const jlong*>(lines.data())
+    );
+    return result;
+}
+
+jboolean JNICALL diagnostics_has_error(JNIEnv *env, jobject thiz, jint row) {
+    TSDiagnostics *self = GET_POINTER(TSDiagnostics, thiz);
+    return static_cast<jboolean>(row >= 0 && self->has_error(static_cast<uint32_t>(row)));
+}
+
+// the visible symbols which are valid at the error, computed on demand by the lookahead
+// iterator, so the symbols are only collected for the diagnostics shown to the user
+jshortArray JNICALL diagnostics_native_expected_symbols(JNIEnv *env, jobject thiz, jint index, jint max_count) {
+    TSDiagnostics *self = GET_POINTER(TSDiagnostics, thiz);
+    if (index < 0 || static_cast<size_t>(index) >= self->diagnostics().size()) {
+        THROW(IndexOutOfBoundsException, "The diagnostic index is out of bounds");
+        return nullptr;
+    }
+    const TSDiagnostic &diagnostic = self->diagnostics()[index];
+    std::vector<jshort> symbols;
+    if (diagnostic.kind == TS_DIAGNOSTIC_MISSING) {
+        symbols.push_back(static_cast<jshort>(diagnostic.symbol));
+    } else if (TSLookaheadIterator *iterator = ts_lookahead_iterator_new(self->language(), diagnostic.state)) {
+        while (static_cast<jint>(symbols.size()) < max_count && ts_lookahead_iterator_next(iterator)) {
+            TSSymbol symbol = ts_lookahead_iterator_current_symbol(iterator);
+            TSSymbolType type = ts_language_symbol_type(self->language(), symbol);
+            // skip the end of input and the hidden symbols
+            if (symbol != 0 && type <= TSSymbolTypeAnonymous) {
+                symbols.push_back(static_cast<jshort>(symbol));
+            }
+        }
+        ts_lookahead_iterator_delete(iterator);
+    }
+    jshortArray result = env->NewShortArray(static_cast<jsize>(symbols.size()));
+    env->SetShortArrayRegion(result, 0, static_cast<jsize>(symbols.size()), symbols.data());
+    return result;
+}
+
+extern const JNINativeMethod TSDiagnostics_methods[] = {
+    {"init", "()J", (void *)&diagnostics_init},
+    {"delete", "(J)V", (void *)&diagnostics_delete},
+    {"nativeUpdate", "(L" PACKAGE "TSTree;L" PACKAGE "TSTree;)V", (void *)&diagnostics_native_update},
+    {"reset", "()V", (void *)&diagnostics_reset},
+    {"getSize", "()I", (void *)&diagnostics_get_size},
+    {"getDiagnostics", "()[I", (void *)&diagnostics_get_diagnostics},
+    {"getLineBitmap", "()[J", (void *)&diagnostics_get_line_bitmap},
+    {"hasError", "(I)Z", (void *)&diagnostics_has_error},
+    {"nativeExpectedSymbols", "(II)[S", (void *)&diagnostics_native_expected_symbols},
+};
+
+extern const size_t TSDiagnostics_methods_size = sizeof TSDiagnostics_methods / sizeof(JNINativeMethod);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
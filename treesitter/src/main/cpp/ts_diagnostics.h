@@ -0,0 +1,230 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __TS_DIAGNOSTICS_H__
+#define __TS_DIAGNOSTICS_H__
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <tree_sitter/api.h>
+
+#include "ts_partitions.h"
+
+// the kinds of a diagnostic, keep the same values as TSDiagnostics.kt
+#define TS_DIAGNOSTIC_ERROR 0
+#define TS_DIAGNOSTIC_MISSING 1
+
+// the number of jint values of a packed diagnostic
+// [startByte, endByte, startRow, startColumn, endRow, endColumn, kind, symbol, state]
+#define TS_DIAGNOSTIC_STRIDE 9
+
+struct TSDiagnostic {
+    uint32_t start_byte;
+    uint32_t end_byte;
+    TSPoint start_point;
+    TSPoint end_point;
+    uint16_t kind;
+    // the missing symbol, or the ERROR symbol
+    TSSymbol symbol;
+    // the parse state before the error, for the expected symbols
+    TSStateId state;
+    // locate the node again in the edited tree, see TSDiagnostics::update
+    uint32_t descendant_index;
+    const void *id;
+};
+
+// the ERROR and MISSING nodes of a syntax tree, sorted by the start byte, the clean
+// subtrees are pruned by ts_node_has_error, and after a reparse only the changed
+// ranges are scanned again, the other diagnostics are moved to the new tree
+class TSDiagnostics {
+public:
+    // collect the diagnostics of the tree, the old tree is the edited tree of the last update,
+    // the whole tree is scanned if there is no old tree or it's not the tree of the last update
+    void update(const TSTree *tree, const TSTree *old_tree) {
+        if (old_tree == nullptr || old_tree != tree_) {
+            diagnostics_.clear();
+            scan(tree, {{0, UINT32_MAX}}, diagnostics_);
+            tree_ = tree;
+            language_ = ts_tree_language(tree);
+            build_lines();
+            return;
+        }
+
+        TSByteRanges ranges = ts_changed_byte_ranges(old_tree, tree);
+
+        // move the diagnostics outside the changed ranges to the new tree, the old tree
+        // was edited, so its nodes are at the new positions and the ids are reused
+        std::vector<TSDiagnostic> result;
+        TSTreeCursor old_cursor = ts_tree_cursor_new(ts_tree_root_node(old_tree));
+        TSTreeCursor cursor = ts_tree_cursor_new(ts_tree_root_node(tree));
+        for (const TSDiagnostic &diagnostic : diagnostics_) {
+            ts_tree_cursor_goto_descendant(&old_cursor, diagnostic.descendant_index);
+            TSNode node = ts_tree_cursor_current_node(&old_cursor);
+            if (node.id != diagnostic.id) {
+                // never happens unless the old tree isn't the tree of the last update
+                ranges.emplace_back(0, UINT32_MAX);
+                break;
+            }
+            uint32_t start = ts_node_start_byte(node), end = ts_node_end_byte(node);
+            if (ts_overlaps(ranges, start, end)) continue;
+            ts_tree_cursor_reset(&cursor, ts_tree_root_node(tree));
+            if (find(&cursor, start, diagnostic.id)) {
+                result.push_back(make(&cursor, diagnostic.kind));
+            } else {
+                ranges.emplace_back(start, end);
+            }
+        }
+        ts_tree_cursor_delete(&cursor);
+        ts_tree_cursor_delete(&old_cursor);
+
+        // scan the changed ranges, the diagnostics moved above don't overlap them
+        std::sort(ranges.begin(), ranges.end());
+        TSByteRanges merged;
+        for (const auto &range : ranges) {
+            if (!merged.empty() && range.first <= merged.back().second) {
+                merged.back().second = std::max(merged.back().second, range.second);
+            } else {
+                merged.push_back(range);
+            }
+        }
+        if (!merged.empty() && merged.front().first == 0 && merged.front().second == UINT32_MAX) {
+            result.clear();
+        }
+        scan(tree, merged, result);
+        std::sort(result.begin(), result.end(), [](const TSDiagnostic &a, const TSDiagnostic &b) {
+            return a.start_byte < b.start_byte || (a.start_byte == b.start_byte && a.end_byte < b.end_byte);
+        });
+        // a node overlapping two ranges is found twice
+        result.erase(std::unique(result.begin(), result.end(), [](const TSDiagnostic &a, const TSDiagnostic &b) {
+            return a.id == b.id && a.start_byte == b.start_byte;
+        }), result.end());
+        diagnostics_ = std::move(result);
+        tree_ = tree;
+        build_lines();
+    }
+
+    // forget the tree, so the next update scans the whole tree
+    void reset() {
+        diagnostics_.clear();
+        lines_.clear();
+        tree_ = nullptr;
+    }
+
+    const std::vector<TSDiagnostic> &diagnostics() const { return diagnostics_; }
+
+    // the bitmap of the rows covered by a diagnostic, bit (row % 64) of word (row / 64)
+    const std::vector<uint64_t> &lines() const { return lines_; }
+
+    bool has_error(uint32_t row) const {
+        return row / 64U < lines_.size() && (lines_[row / 64U] >> (row % 64U) & 1U);
+    }
+
+    // the language of the last tree, the languages are never freed
+    const TSLanguage *language() const { return language_; }
+
+private:
+    // collect the diagnostics overlapping the sorted ranges in preorder,
+    // the subtrees without an error are skipped, the nested errors of
+    // an ERROR node are reported by the outermost one
+    static void scan(
+        const TSTree *tree, const TSByteRanges &ranges,
+        std::vector<TSDiagnostic> &out
+    ) {
+        if (ranges.empty()) return;
+        TSNode root = ts_tree_root_node(tree);
+        if (!ts_node_has_error(root)) return;
+        TSTreeCursor cursor = ts_tree_cursor_new(root);
+        bool ok = true;
+        while (ok) {
+            TSNode node = ts_tree_cursor_current_node(&cursor);
+            bool descend = false;
+            if (ts_node_has_error(node) && ts_overlaps(ranges, ts_node_start_byte(node), ts_node_end_byte(node))) {
+                if (ts_node_is_error(node)) {
+                    out.push_back(make(&cursor, TS_DIAGNOSTIC_ERROR));
+                } else if (ts_node_is_missing(node)) {
+                    out.push_back(make(&cursor, TS_DIAGNOSTIC_MISSING));
+                } else {
+                    descend = true;
+                }
+            }
+            if (descend && ts_tree_cursor_goto_first_child(&cursor)) continue;
+            while (!(ok = ts_tree_cursor_goto_next_sibling(&cursor))) {
+                if (!ts_tree_cursor_goto_parent(&cursor)) break;
+            }
+        }
+        ts_tree_cursor_delete(&cursor);
+    }
+
+    // move the cursor to the node of the id, which starts at the byte
+    static bool find(TSTreeCursor *cursor, uint32_t start, const void *id) {
+        while (true) {
+            TSNode node = ts_tree_cursor_current_node(cursor);
+            if (node.id == id) return true;
+            if (!ts_node_has_error(node) || !ts_tree_cursor_goto_first_child(cursor)) return false;
+            // the first child containing the byte, the empty nodes end at the byte
+            while (ts_node_end_byte(ts_tree_cursor_current_node(cursor)) < start ||
+                   (ts_node_end_byte(ts_tree_cursor_current_node(cursor)) == start &&
+                    ts_node_start_byte(ts_tree_cursor_current_node(cursor)) < start)) {
+                if (!ts_tree_cursor_goto_next_sibling(cursor)) return false;
+            }
+            if (ts_node_start_byte(ts_tree_cursor_current_node(cursor)) > start) return false;
+        }
+    }
+
+    void build_lines() {
+        lines_.clear();
+        for (const TSDiagnostic &diagnostic : diagnostics_) {
+            uint32_t last = diagnostic.end_point.row;
+            if (last / 64U >= lines_.size()) lines_.resize(last / 64U + 1, 0);
+            for (uint32_t row = diagnostic.start_point.row; row <= last; ++row) {
+                lines_[row / 64U] |= 1ULL << (row % 64U);
+            }
+        }
+    }
+
+    static TSDiagnostic make(TSTreeCursor *cursor, uint16_t kind) {
+        TSNode node = ts_tree_cursor_current_node(cursor);
+        // the expected symbols of an error are the lookaheads after the previous node
+        TSStateId state = ts_node_parse_state(node);
+        if (kind == TS_DIAGNOSTIC_ERROR) {
+            TSNode previous = ts_node_prev_sibling(node);
+            if (!ts_node_is_null(previous)) state = ts_node_next_parse_state(previous);
+        }
+        return TSDiagnostic {
+            .start_byte = ts_node_start_byte(node),
+            .end_byte = ts_node_end_byte(node),
+            .start_point = ts_node_start_point(node),
+            .end_point = ts_node_end_point(node),
+            .kind = kind,
+            .symbol = ts_node_symbol(node),
+            .state = state,
+            .descendant_index = ts_tree_cursor_current_descendant_index(cursor),
+            .id = node.id
+        };
+    }
+
+    std::vector<TSDiagnostic> diagnostics_;
+    std::vector<uint64_t> lines_;
+    // only compared with the old tree of the next update, never dereferenced
+    const TSTree *tree_ = nullptr;
+    const TSLanguage *language_ = nullptr;
+};
+
+#endif // __TS_DIAGNOSTICS_H__
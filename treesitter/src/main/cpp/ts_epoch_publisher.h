@@ -0,0 +1,135 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __TS_EPOCH_PUBLISHER_H__
+#define __TS_EPOCH_PUBLISHER_H__
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// the number of the readers that can pin an epoch at the same time
+#define TS_PUBLISHER_SLOTS 64
+// the epoch of an idle reader slot
+#define TS_EPOCH_IDLE UINT64_MAX
+
+// a published value, the value is owned by the publisher
+template <typename T>
+struct TSPublished {
+    T value;
+    int64_t generation;
+};
+
+// publish the latest value by an atomic pointer swap, and free the replaced values
+// by the epoch-based reclamation, a reader pins the current epoch before loading the
+// value, a value replaced at epoch e is freed once every pinned epoch is after e
+//
+// the readers never take a lock, the writers serialize on the retired list only
+template <typename T>
+class TSEpochPublisher {
+public:
+    TSEpochPublisher() : current_(nullptr), epoch_(1), retired_count_(0) {
+        for (auto &slot : slots_) slot.store(TS_EPOCH_IDLE, std::memory_order_relaxed);
+    }
+
+    TSEpochPublisher(const TSEpochPublisher&) = delete;
+    TSEpochPublisher &operator=(const TSEpochPublisher&) = delete;
+
+    // pin the current epoch, the returned slot must be passed to unpin, or -1 if
+    // all the slots are taken, a stale epoch only delays the reclamation
+    int pin() {
+        uint64_t epoch = epoch_.load();
+        for (int i = 0; i < TS_PUBLISHER_SLOTS; ++i) {
+            uint64_t expected = TS_EPOCH_IDLE;
+            if (slots_[i].compare_exchange_strong(expected, epoch)) return i;
+        }
+        return -1;
+    }
+
+    void unpin(int slot) { slots_[slot].store(TS_EPOCH_IDLE); }
+
+    // the value stays valid until the slot is unpinned
+    const TSPublished<T> *current() const { return current_.load(); }
+
+    size_t retired_count() const { return retired_count_.load(std::memory_order_relaxed); }
+
+    // replace the current value, the replaced one is retired at the epoch before the swap
+    template <typename F>
+    void publish(TSPublished<T> *entry, F &&free) {
+        TSPublished<T> *old = current_.exchange(entry);
+        uint64_t epoch = epoch_.fetch_add(1);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (old != nullptr) {
+            retired_.push_back({old, epoch});
+            retired_count_.store(retired_.size(), std::memory_order_relaxed);
+        }
+        reclaim_locked(free);
+    }
+
+    // free the retired values that no reader can see, the reader
+    // only tries the lock, so that it never waits for a writer
+    template <typename F>
+    void try_reclaim(F &&free) {
+        if (retired_count() == 0) return;
+        std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+        if (lock.owns_lock()) reclaim_locked(free);
+    }
+
+    // free all the values, no reader can be pinned
+    template <typename F>
+    void clear(F &&free) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &retired : retired_) free(retired.entry);
+        retired_.clear();
+        retired_count_.store(0, std::memory_order_relaxed);
+        TSPublished<T> *old = current_.exchange(nullptr);
+        if (old != nullptr) free(old);
+    }
+
+private:
+    struct Retired {
+        TSPublished<T> *entry;
+        uint64_t epoch;
+    };
+
+    template <typename F>
+    void reclaim_locked(F &&free) {
+        uint64_t min_epoch = TS_EPOCH_IDLE;
+        for (auto &slot : slots_) min_epoch = std::min(min_epoch, slot.load());
+        size_t kept = 0;
+        for (auto &retired : retired_) {
+            if (retired.epoch < min_epoch) {
+                free(retired.entry);
+            } else {
+                retired_[kept++] = retired;
+            }
+        }
+        retired_.resize(kept);
+        retired_count_.store(kept, std::memory_order_relaxed);
+    }
+
+    std::atomic<TSPublished<T>*> current_;
+    std::atomic<uint64_t> epoch_;
+    std::atomic<uint64_t> slots_[TS_PUBLISHER_SLOTS];
+    std::atomic<size_t> retired_count_;
+    std::mutex mutex_;
+    std::vector<Retired> retired_;
+};
+
+#endif // __TS_EPOCH_PUBLISHER_H__
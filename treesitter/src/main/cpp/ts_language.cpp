@@ -18,6 +18,7 @@
 
 #include "ts_language.h"
 #include "ts_utils.h"
+#include "ts_string_table.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -43,7 +44,7 @@ jlong JNICALL language_resolve(JNIEnv* env, jclass clazz, jstring name) {
     return reinterpret_cast<jlong>(nullptr);
 }
 
-jlong JNICALL language_copy(jlong language) {
+jlong JNICALL language_copy CRITICAL_ARGS(jlong language) {
     return reinterpret_cast<jlong>(
         ts_language_copy(reinterpret_cast<TSLanguage*>(language))
     );
@@ -71,8 +72,7 @@ jint JNICALL language_get_field_count(JNIEnv* env, jobject thiz) {
 
 jstring JNICALL language_symbol_name(JNIEnv *env, jobject thiz, jshort symbol) {
     TSLanguage *self = GET_POINTER(TSLanguage, thiz);
-    const char *name = ts_language_symbol_name(self, static_cast<uint16_t>(symbol));
-    return env->NewStringUTF(name);
+    return TSStringTable::symbol_name(env, self, static_cast<uint16_t>(symbol));
 }
 
 jshort JNICALL language_symbol_for_name(JNIEnv *env, jobject thiz, jstring name, jboolean isNamed) {
@@ -110,8 +110,7 @@ jboolean JNICALL language_is_supertype(JNIEnv *env, jobject thiz, jshort symbol)
 
 jstring JNICALL language_field_name_for_id(JNIEnv *env, jobject thiz, jshort id) {
     TSLanguage *self = GET_POINTER(TSLanguage, thiz);
-    const char *name = ts_language_field_name_for_id(self, static_cast<uint16_t>(id));
-    return name ? env->NewStringUTF(name) : nullptr;
+    return TSStringTable::field_name(env, self, static_cast<uint16_t>(id));
 }
 
 jint JNICALL language_field_id_for_name(JNIEnv *env, jobject thiz, jstring name) {
@@ -0,0 +1,121 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ts_utils.h"
+#include "ts_locals.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+jlong JNICALL locals_init(JNIEnv *env, jclass clazz, jobject query, jobject highlights) {
+    TSQuery *ts_query = GET_POINTER(TSQuery, query);
+    TSQuery *ts_highlights = GET_POINTER(TSQuery, highlights);
+    return reinterpret_cast<jlong>(new TSLocals(ts_query, ts_highlights));
+}
+
+void JNICALL locals_delete CRITICAL_ARGS(jlong locals) {
+    delete reinterpret_cast<TSLocals*>(locals);
+}
+
+jintArray JNICALL locals_native_update(JNIEnv *env, jobject thiz, jobject tree, jobject old_tree, jobject index) {
+    TSLocals *self = GET_POINTER(TSLocals, thiz);
+    TSTree *tree_ptr = GET_POINTER(TSTree, tree);
+    TSTree *old_tree_ptr = old_tree ? GET_POINTER(TSTree, old_tree) : nullptr;
+    TSOffsetIndex *index_ptr = GET_POINTER(TSOffsetIndex, index);
+    std::vector<int32_t> rows;
+    self->update(tree_ptr, old_tree_ptr, index_ptr, rows);
+    jintArray result = env->NewIntArray(static_cast<jsize>(rows.size()));
+    env->SetIntArrayRegion(result, 0, static_cast<jsize>(rows.size()), rows.data());
+    return result;
+}
+
+void JNICALL locals_reset(JNIEnv *env, jobject thiz) {
+    TSLocals *self = GET_POINTER(TSLocals, thiz);
+    self->reset();
+}
+
+jint JNICALL locals_get_size(JNIEnv *env, jobject thiz) {
+    TSLocals *self = GET_POINTER(TSLocals, thiz);
+    return static_cast<jint>(self->size());
+}
+
+jintArray JNICALL locals_captures(JNIEnv *env, jobject thiz, jint start, jint end) {
+    TSLocals *self = GET_POINTER(TSLocals, thiz);
+    std::vector<int32_t> values;
+    self->captures(static_cast<uint32_t>(std::max(start, 0)), static_cast<uint32_t>(std::max(end, 0)), values);
+    jintArray result = env->NewIntArray(static_cast<jsize>(values.size()));
+    env->SetIntArrayRegion(result, 0, static_cast<jsize>(values.size()), values.data());
+    return result;
+}
+
+jintArray JNICALL locals_occurrences(JNIEnv *env, jobject thiz, jint byte) {
+    TSLocals *self = GET_POINTER(TSLocals, thiz);
+    std::vector<int32_t> values;
+    if (byte >= 0) self->occurrences(static_cast<uint32_t>(byte), values);
+    jintArray result = env->NewIntArray(static_cast<jsize>(values.size()));
+    env->SetIntArrayRegion(result, 0, static_cast<jsize>(values.size()), values.data());
+    return result;
+}
+
+jintArray JNICALL locals_definition(JNIEnv *env, jobject thiz, jint byte) {
+    TSLocals *self = GET_POINTER(TSLocals, thiz);
+    std::vector<int32_t> values;
+    if (byte >= 0) self->definition(static_cast<uint32_t>(byte), values);
+    jintArray result = env->NewIntArray(static_cast<jsize>(values.size()));
+    env->SetIntArrayRegion(result, 0, static_cast<jsize>(values.size()), values.data());
+    return result;
+}
+
+jintArray JNICALL locals_references(JNIEnv *env, jobject thiz, jint byte) {
+    TSLocals *self = GET_POINTER(TSLocals, thiz);
+    std::vector<int32_t> values;
+    if (byte >= 0) self->references(static_cast<uint32_t>(byte), values);
+    jintArray result = env->NewIntArray(static_cast<jsize>(values.size()));
+    env->SetIntArrayRegion(result, 0, static_cast<jsize>(values.size()), values.data());
+    return result;
+}
+
+jintArray JNICALL locals_definitions(JNIEnv *env, jobject thiz, jstring name) {
+    TSLocals *self = GET_POINTER(TSLocals, thiz);
+    const char *chars = env->GetStringUTFChars(name, nullptr);
+    std::string key(chars, env->GetStringUTFLength(name));
+    env->ReleaseStringUTFChars(name, chars);
+    std::vector<int32_t> values;
+    self->definitions(key, values);
+    jintArray result = env->NewIntArray(static_cast<jsize>(values.size()));
+    env->SetIntArrayRegion(result, 0, static_cast<jsize>(values.size()), values.data());
+    return result;
+}
+
+extern const JNINativeMethod TSLocals_methods[] = {
+    {"init", "(L" PACKAGE "TSQuery;L" PACKAGE "TSQuery;)J", (void *)&locals_init},
+    {"delete", "(J)V", (void *)&locals_delete},
+    {"nativeUpdate", "(L" PACKAGE "TSTree;L" PACKAGE "TSTree;L" PACKAGE "TSOffsetIndex;)[I", (void *)&locals_native_update},
+    {"reset", "()V", (void *)&locals_reset},
+    {"getSize", "()I", (void *)&locals_get_size},
+    {"captures", "(II)[I", (void *)&locals_captures},
+    {"occurrences", "(I)[I", (void *)&locals_occurrences},
+    {"definition", "(I)[I", (void *)&locals_definition},
+    {"references", "(I)[I", (void *)&locals_references},
+    {"definitions", "(Ljava/lang/String;)[I", (void *)&locals_definitions},
+};
+
+extern const size_t TSLocals_methods_size = sizeof TSLocals_methods / sizeof(JNINativeMethod);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
@@ -0,0 +1,424 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __TS_LOCALS_H__
+#define __TS_LOCALS_H__
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <tree_sitter/api.h>
+
+#include "ts_offset_index.h"
+#include "ts_partitions.h"
+
+// the number of jint values of a semantic capture, [startByte, endByte, capture id]
+#define TS_LOCAL_CAPTURE_STRIDE 3
+
+// the definitions and references of a locals query, like locals.scm of the grammars,
+// resolved by the @local.scope captures. The index is split by the children of the root,
+// the definitions outside any scope are global and resolved by name across the children,
+// after a reparse only the edited children and the ones overlapping the changed ranges
+// are queried again, the names are interned and counted, so a name no entry refers
+// to any more is dropped and its id is reused
+class TSLocals {
+public:
+    // the highlight query is only read here, the semantic capture ids are its capture ids
+    TSLocals(const TSQuery *query, const TSQuery *highlights) : query_(query) {
+        std::unordered_map<std::string_view, uint32_t> names;
+        for (uint32_t id = 0, count = ts_query_capture_count(highlights); id < count; ++id) {
+            uint32_t length;
+            const char *name = ts_query_capture_name_for_id(highlights, id, &length);
+            if (name != nullptr) names.emplace(std::string_view(name, length), id);
+        }
+        uint32_t count = ts_query_capture_count(query);
+        roles_.resize(count, ROLE_NONE);
+        styles_.resize(count, UINT32_MAX);
+        for (uint32_t id = 0; id < count; ++id) {
+            uint32_t length;
+            const char *chars = ts_query_capture_name_for_id(query, id, &length);
+            std::string_view name(chars != nullptr ? chars : "", chars != nullptr ? length : 0);
+            if (name == "local.scope") {
+                roles_[id] = ROLE_SCOPE;
+            } else if (name == "local.reference") {
+                roles_[id] = ROLE_REFERENCE;
+            } else if (name.substr(0, 16) == "local.definition") {
+                roles_[id] = ROLE_DEFINITION;
+                styles_[id] = style(name.substr(std::min<size_t>(name.size(), 17)), names);
+            }
+        }
+        cursor_ = ts_query_cursor_new();
+    }
+
+    TSLocals(const TSLocals &) = delete;
+
+    TSLocals &operator=(const TSLocals &) = delete;
+
+    ~TSLocals() { ts_query_cursor_delete(cursor_); }
+
+    // index the tree, the old tree is the edited tree of the last update, the whole
+    // tree is queried if there is no old tree or it's not the tree of the last update,
+    // the start and end rows of the children queried again are appended to the rows
+    void update(const TSTree *tree, const TSTree *old_tree, const TSOffsetIndex *index, std::vector<int32_t> &rows) {
+        std::vector<Partition> old = std::move(partitions_);
+        partitions_.clear();
+        std::vector<bool> kept = ts_split_partitions(
+            tree, old_tree == tree_ ? old_tree : nullptr, old,
+            [&](Partition &partition, TSNode child) {
+                // the offsets of the entries are relative, so only the start is moved
+                partitions_.push_back(std::move(partition));
+                partitions_.back().start = ts_node_start_byte(child);
+            },
+            [&](TSNode child) {
+                partitions_.push_back(build(child, index));
+                rows.push_back(static_cast<int32_t>(ts_node_start_point(child).row));
+                rows.push_back(static_cast<int32_t>(ts_node_end_point(child).row));
+            }
+        );
+        // release the names after the new partitions are built, so the names still in use keep their ids
+        for (size_t i = 0; i < old.size(); ++i) {
+            if (!kept[i]) release(old[i]);
+        }
+        tree_ = tree;
+        link();
+    }
+
+    // forget the tree, so the next update queries the whole tree
+    void reset() {
+        partitions_.clear();
+        globals_.clear();
+        definitions_.clear();
+        names_.clear();
+        keys_.clear();
+        counts_.clear();
+        free_names_.clear();
+        tree_ = nullptr;
+    }
+
+    // the number of the definitions and references
+    uint32_t size() const {
+        uint32_t count = 0;
+        for (const Partition &partition : partitions_) count += static_cast<uint32_t>(partition.entries.size());
+        return count;
+    }
+
+    // the number of the interned names, every one is the name of an entry
+    uint32_t name_count() const { return static_cast<uint32_t>(names_.size()); }
+
+    // append the definitions and the resolved references overlapping [start, end)
+    // as [startByte, endByte, capture id] of the highlight query, in the order of the start
+    void captures(uint32_t start, uint32_t end, std::vector<int32_t> &out) const {
+        for (size_t i = find_partition(start); i < partitions_.size(); ++i) {
+            const Partition &partition = partitions_[i];
+            if (partition.start >= end) break;
+            for (const Entry &entry : partition.entries) {
+                uint32_t from = partition.start + entry.start, to = partition.start + entry.end;
+                if (to <= start) continue;
+                if (from >= end) break;
+                uint32_t style = style_of(partition, entry);
+                if (style == UINT32_MAX) continue;
+                out.insert(out.end(), {
+                    static_cast<int32_t>(from), static_cast<int32_t>(to), static_cast<int32_t>(style)
+                });
+            }
+        }
+    }
+
+    // append the [startByte, endByte] of every occurrence of the identifier at the byte,
+    // the definitions and the references of the same symbol, nothing if there is no identifier
+    void occurrences(uint32_t byte, std::vector<int32_t> &out) const {
+        for_each_occurrence(byte, [&](const Partition &partition, const Entry &entry) {
+            append(partition, entry, out);
+        });
+    }
+
+    // append the definitions of the symbol at the byte, the global symbol may have many
+    void definition(uint32_t byte, std::vector<int32_t> &out) const {
+        for_each_occurrence(byte, [&](const Partition &partition, const Entry &entry) {
+            if (entry.role == ROLE_DEFINITION) append(partition, entry, out);
+        });
+    }
+
+    // append the references of the symbol at the byte, without the definitions
+    void references(uint32_t byte, std::vector<int32_t> &out) const {
+        for_each_occurrence(byte, [&](const Partition &partition, const Entry &entry) {
+            if (entry.role == ROLE_REFERENCE) append(partition, entry, out);
+        });
+    }
+
+    // append the definitions of the name in any scope of the file, in the order of the start
+    void definitions(const std::string &name, std::vector<int32_t> &out) const {
+        auto it = names_.find(name);
+        if (it == names_.end()) return;
+        auto found = definitions_.find(it->second);
+        if (found == definitions_.end()) return;
+        for (const auto &[p, j] : found->second) append(partitions_[p], partitions_[p].entries[j], out);
+    }
+
+private:
+    enum Role : uint8_t { ROLE_NONE, ROLE_SCOPE, ROLE_DEFINITION, ROLE_REFERENCE };
+
+    // the group of the global definitions and the unresolved references
+    static constexpr uint32_t GLOBAL = UINT32_MAX;
+
+    struct Scope {
+        uint32_t end;
+        uint32_t parent;
+    };
+
+    // a definition or a reference, the offsets are relative to the partition
+    struct Entry {
+        uint32_t start;
+        uint32_t end;
+        uint32_t name;
+        // the index of the local group in the partition, or GLOBAL
+        uint32_t group;
+        uint16_t capture;
+        Role role;
+    };
+
+    // the entries of a child of the root, sorted by the start
+    struct Partition {
+        uint32_t start;
+        uint32_t length;
+        std::vector<Entry> entries;
+        // the entries of every local definition, the definition first
+        std::vector<std::vector<uint32_t>> groups;
+        // the global entries and the definitions, which are linked by name
+        std::vector<uint32_t> linked;
+    };
+
+    static void append(const Partition &partition, const Entry &entry, std::vector<int32_t> &out) {
+        out.insert(out.end(), {
+            static_cast<int32_t>(partition.start + entry.start),
+            static_cast<int32_t>(partition.start + entry.end)
+        });
+    }
+
+    // visit the entries of the symbol at the byte in the order of the start, the local symbol
+    // is the group of its definition, the global symbol is looked up by the name
+    template <typename F>
+    void for_each_occurrence(uint32_t byte, F visit) const {
+        size_t i = find_partition(byte);
+        if (i >= partitions_.size() || partitions_[i].start > byte) return;
+        const Partition &partition = partitions_[i];
+        uint32_t offset = byte - partition.start;
+        // the last entry starting at or before the byte, the end is inclusive for the caret
+        auto it = std::upper_bound(
+            partition.entries.begin(), partition.entries.end(), offset,
+            [](uint32_t value, const Entry &entry) { return value < entry.start; }
+        );
+        if (it == partition.entries.begin() || (it - 1)->end < offset) return;
+        const Entry &entry = *(it - 1);
+        if (entry.group != GLOBAL) {
+            for (uint32_t j : partition.groups[entry.group]) visit(partition, partition.entries[j]);
+            return;
+        }
+        auto global = globals_.find(entry.name);
+        if (global == globals_.end()) return;
+        for (const auto &[p, j] : global->second) visit(partitions_[p], partitions_[p].entries[j]);
+    }
+
+    // the capture id of the highlight query for the definition kind, like parameter
+    // to variable.parameter, the first candidate in the highlight query is used
+    static uint32_t style(std::string_view kind, const std::unordered_map<std::string_view, uint32_t> &names) {
+        static const std::unordered_map<std::string_view, std::vector<std::string_view>> candidates = {
+            {"parameter", {"variable.parameter", "parameter"}},
+            {"var", {"variable"}},
+            {"variable", {"variable"}},
+            {"field", {"property", "variable.member", "field"}},
+            {"property", {"property", "variable.member"}},
+            {"function", {"function"}},
+            {"method", {"function.method", "method", "function"}},
+            {"type", {"type"}},
+            {"constant", {"constant"}},
+            {"namespace", {"namespace", "module"}},
+            {"import", {"namespace", "module"}},
+        };
+        auto it = candidates.find(kind);
+        if (it != candidates.end()) {
+            for (std::string_view name : it->second) {
+                auto found = names.find(name);
+                if (found != names.end()) return found->second;
+            }
+        }
+        auto found = names.find("variable");
+        return found != names.end() ? found->second : UINT32_MAX;
+    }
+
+    uint32_t intern(const TSOffsetIndex *index, uint32_t start, uint32_t end) {
+        std::string text;
+        text.reserve(end - start);
+        while (start < end) {
+            uint32_t length;
+            const char *p = index->segment(start, &length);
+            if (length == 0) break;
+            length = std::min(length, end - start);
+            text.append(p, length);
+            start += length;
+        }
+        auto it = names_.find(text);
+        if (it != names_.end()) {
+            counts_[it->second] += 1;
+            return it->second;
+        }
+        uint32_t id;
+        if (!free_names_.empty()) {
+            id = free_names_.back();
+            free_names_.pop_back();
+        } else {
+            id = static_cast<uint32_t>(keys_.size());
+            keys_.push_back(nullptr);
+            counts_.push_back(0);
+        }
+        // the keys of an unordered_map are not moved by a rehash
+        keys_[id] = &names_.emplace(std::move(text), id).first->first;
+        counts_[id] = 1;
+        return id;
+    }
+
+    // drop the names of the partition which no other entry refers to
+    void release(const Partition &partition) {
+        for (const Entry &entry : partition.entries) {
+            if (--counts_[entry.name] != 0) continue;
+            std::string key = *keys_[entry.name];
+            names_.erase(key);
+            keys_[entry.name] = nullptr;
+            free_names_.push_back(entry.name);
+        }
+    }
+
+    // query the child, the captures come in the order of the start, so the scopes
+    // are a stack, a reference is resolved to the nearest definition before it
+    Partition build(TSNode child, const TSOffsetIndex *index) {
+        Partition partition {ts_node_start_byte(child), ts_node_end_byte(child) - ts_node_start_byte(child), {}, {}, {}};
+        // the scope 0 is the partition itself, its definitions are global
+        std::vector<Scope> scopes {{partition.length, UINT32_MAX}};
+        std::vector<std::unordered_map<uint32_t, uint32_t>> definitions(1);
+        uint32_t current = 0;
+
+        ts_query_cursor_set_byte_range(cursor_, partition.start, partition.start + partition.length);
+        ts_query_cursor_exec(cursor_, query_, child);
+        TSQueryMatch match;
+        uint32_t capture_index;
+        while (ts_query_cursor_next_capture(cursor_, &match, &capture_index)) {
+            const TSQueryCapture &capture = match.captures[capture_index];
+            Role role = roles_[capture.index];
+            if (role == ROLE_NONE) continue;
+            uint32_t start = ts_node_start_byte(capture.node) - partition.start;
+            uint32_t end = ts_node_end_byte(capture.node) - partition.start;
+            while (current != 0 && start >= scopes[current].end) current = scopes[current].parent;
+            if (role == ROLE_SCOPE) {
+                scopes.push_back({end, current});
+                definitions.emplace_back();
+                current = static_cast<uint32_t>(scopes.size() - 1);
+                continue;
+            }
+            // the node captured by a definition is captured by the reference pattern too
+            if (!partition.entries.empty() && partition.entries.back().start == start &&
+                partition.entries.back().end == end) {
+                continue;
+            }
+            Entry entry {
+                start, end, intern(index, partition.start + start, partition.start + end),
+                GLOBAL, static_cast<uint16_t>(capture.index), role
+            };
+            uint32_t position = static_cast<uint32_t>(partition.entries.size());
+            if (role == ROLE_DEFINITION) {
+                if (current != 0) {
+                    entry.group = static_cast<uint32_t>(partition.groups.size());
+                    partition.groups.push_back({position});
+                    definitions[current][entry.name] = position;
+                }
+            } else {
+                for (uint32_t scope = current; scope != 0; scope = scopes[scope].parent) {
+                    auto it = definitions[scope].find(entry.name);
+                    if (it != definitions[scope].end()) {
+                        entry.group = partition.entries[it->second].group;
+                        partition.groups[entry.group].push_back(position);
+                        break;
+                    }
+                }
+            }
+            if (entry.group == GLOBAL || role == ROLE_DEFINITION) partition.linked.push_back(position);
+            partition.entries.push_back(entry);
+        }
+        return partition;
+    }
+
+    // map the names of the global entries, and the names of all the definitions, to the
+    // entries of all partitions, the local references are resolved already and skipped
+    void link() {
+        globals_.clear();
+        definitions_.clear();
+        for (uint32_t p = 0; p < partitions_.size(); ++p) {
+            const std::vector<Entry> &entries = partitions_[p].entries;
+            for (uint32_t j : partitions_[p].linked) {
+                if (entries[j].group == GLOBAL) globals_[entries[j].name].emplace_back(p, j);
+                if (entries[j].role == ROLE_DEFINITION) definitions_[entries[j].name].emplace_back(p, j);
+            }
+        }
+    }
+
+    // the style of a reference is the style of its definition
+    uint32_t style_of(const Partition &partition, const Entry &entry) const {
+        if (entry.role == ROLE_DEFINITION) return styles_[entry.capture];
+        if (entry.group != GLOBAL) {
+            return styles_[partition.entries[partition.groups[entry.group].front()].capture];
+        }
+        auto it = globals_.find(entry.name);
+        if (it == globals_.end()) return UINT32_MAX;
+        for (const auto &[p, j] : it->second) {
+            const Entry &other = partitions_[p].entries[j];
+            if (other.role == ROLE_DEFINITION) return styles_[other.capture];
+        }
+        return UINT32_MAX;
+    }
+
+    // the first partition ending at or after the byte
+    size_t find_partition(uint32_t byte) const {
+        return std::upper_bound(
+            partitions_.begin(), partitions_.end(), byte,
+            [](uint32_t value, const Partition &partition) { return value <= partition.start + partition.length; }
+        ) - partitions_.begin();
+    }
+
+    const TSQuery *query_;
+    TSQueryCursor *cursor_;
+    std::vector<Role> roles_;
+    // the capture ids of the highlight query for the definition captures
+    std::vector<uint32_t> styles_;
+    std::vector<Partition> partitions_;
+    // the global definitions and the unresolved references by name, (partition, entry)
+    std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> globals_;
+    // the definitions in any scope by name, (partition, entry)
+    std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> definitions_;
+    std::unordered_map<std::string, uint32_t> names_;
+    // the name and the number of the entries of every name id, the free ids are reused
+    std::vector<const std::string*> keys_;
+    std::vector<uint32_t> counts_;
+    std::vector<uint32_t> free_names_;
+    // only compared with the old tree of the next update, never dereferenced
+    const TSTree *tree_ = nullptr;
+};
+
+#endif // __TS_LOCALS_H__
@@ -0,0 +1,227 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __TS_LOG_RING_H__
+#define __TS_LOG_RING_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <tree_sitter/api.h>
+
+// the log event kinds, keep the same order as the TSLogEvent of TreeSitter.kt
+enum TSLogEvent : uint8_t {
+    TS_LOG_OTHER,
+    TS_LOG_NEW_PARSE,
+    TS_LOG_PROCESS,
+    TS_LOG_LEX_EXTERNAL,
+    TS_LOG_LEX_INTERNAL,
+    TS_LOG_LEXED_LOOKAHEAD,
+    TS_LOG_SHIFT,
+    TS_LOG_SHIFT_EXTRA,
+    TS_LOG_REDUCE,
+    TS_LOG_ACCEPT,
+    TS_LOG_DETECT_ERROR,
+    TS_LOG_RECOVER,
+    TS_LOG_SKIP_TOKEN,
+    TS_LOG_REUSE_NODE,
+    TS_LOG_CANT_REUSE_NODE,
+    TS_LOG_BREAKDOWN,
+    TS_LOG_CONDENSE,
+    TS_LOG_RESUME,
+    TS_LOG_DONE,
+    TS_LOG_CONSUME_CHARACTER,
+    TS_LOG_SKIP_CHARACTER,
+    TS_LOG_EVENT_COUNT
+};
+
+// the prefixes of the tree-sitter log messages, indexed by TSLogEvent
+static const char *const ts_log_event_names[TS_LOG_EVENT_COUNT] = {
+    "other", "new_parse", "process", "lex_external", "lex_internal", "lexed_lookahead",
+    "shift", "shift_extra", "reduce", "accept", "detect_error", "recover",
+    "skip_token", "reuse_node", "cant_reuse_node", "breakdown_top_of_stack",
+    "condense", "resume", "done", "consume", "skip"
+};
+
+// the symbol of a record without a symbol
+#define TS_LOG_NO_SYMBOL 0xffff
+
+// the number of jint values of a drained record
+#define TS_LOG_RECORD_STRIDE 6
+
+// a compact log record, the logger does not expose the byte offset,
+// so the row and column are the last position seen by the parser
+struct TSLogRecord {
+    uint8_t type;
+    uint8_t event;
+    uint16_t symbol;
+    int32_t state;
+    uint32_t row;
+    uint32_t column;
+};
+
+struct TSTransparentHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view value) const {
+        return std::hash<std::string_view>()(value);
+    }
+};
+
+// a lock-free single producer single consumer ring buffer, the parsing
+// thread produces the records and the draining thread consumes them,
+// the records are dropped instead of blocking the parser when it is full
+class TSLogRing {
+public:
+    explicit TSLogRing(const TSParser *parser, uint32_t capacity)
+        : parser_(parser), row_(0), column_(0), head_(0), tail_(0), dropped_(0) {
+        capacity_ = 64;
+        while (capacity_ < capacity && capacity_ < (1u << 24)) capacity_ <<= 1;
+        records_ = static_cast<TSLogRecord*>(calloc(capacity_, sizeof(TSLogRecord)));
+    }
+
+    ~TSLogRing() { free(records_); }
+
+    TSLogRing(const TSLogRing&) = delete;
+    TSLogRing &operator=(const TSLogRing&) = delete;
+
+    // the producer, called by the tree-sitter logger on the parsing thread
+    void log(TSLogType type, const char *message) {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) >= capacity_) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        TSLogRecord &record = records_[tail & (capacity_ - 1)];
+        parse(type, message, record);
+        tail_.store(tail + 1, std::memory_order_release);
+    }
+
+    // the consumer, copy at most max_count records and release them
+    template <typename Fn>
+    uint32_t drain(uint32_t max_count, Fn &&consume) {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        uint64_t tail = tail_.load(std::memory_order_acquire);
+        uint32_t count = 0;
+        while (head != tail && count < max_count) {
+            consume(records_[head & (capacity_ - 1)]);
+            head += 1;
+            count += 1;
+        }
+        head_.store(head, std::memory_order_release);
+        return count;
+    }
+
+    uint32_t capacity() const { return capacity_; }
+
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    const TSParser *parser() const { return parser_; }
+
+private:
+    // get the value of `key:` in the message, like `state:12`
+    static const char *find_value(const char *message, const char *key) {
+        const char *value = strstr(message, key);
+        return value ? value + strlen(key) : nullptr;
+    }
+
+    void parse(TSLogType type, const char *message, TSLogRecord &record) {
+        record.type = static_cast<uint8_t>(type);
+        record.event = TS_LOG_OTHER;
+        record.symbol = TS_LOG_NO_SYMBOL;
+        record.state = -1;
+
+        // the event is the first word of the message
+        size_t length = strcspn(message, " _:");
+        while (message[length] == '_') length += 1 + strcspn(message + length + 1, " _:");
+        std::string_view word(message, length);
+        for (uint8_t i = 1; i < TS_LOG_EVENT_COUNT; ++i) {
+            if (word == ts_log_event_names[i] ||
+                (i == TS_LOG_RECOVER && word.starts_with("recover")) ||
+                (i == TS_LOG_CANT_REUSE_NODE && word.starts_with("cant_reuse_node"))) {
+                record.event = i;
+                break;
+            }
+        }
+
+        if (const char *state = find_value(message, "state:")) {
+            record.state = static_cast<int32_t>(strtol(state, nullptr, 10));
+        }
+        if (const char *row = find_value(message, "row:")) {
+            row_ = static_cast<uint32_t>(strtoul(row, nullptr, 10));
+            const char *column = find_value(message, "col:");
+            if (column == nullptr) column = find_value(message, "column:");
+            if (column != nullptr) column_ = static_cast<uint32_t>(strtoul(column, nullptr, 10));
+        }
+        record.row = row_;
+        record.column = column_;
+
+        const char *symbol = find_value(message, "sym:");
+        if (symbol == nullptr) symbol = find_value(message, "symbol:");
+        if (symbol != nullptr) record.symbol = resolve_symbol(symbol);
+    }
+
+    // the symbol name ends at the next `, key:`, note the name may be `,`
+    uint16_t resolve_symbol(const char *symbol) {
+        const char *end = symbol;
+        while (*end != '\0') {
+            if (end != symbol && end[0] == ',' && end[1] == ' ') break;
+            end += 1;
+        }
+        std::string_view name(symbol, end - symbol);
+
+        // the ids of the names are of the language, which may be changed between the parses
+        const TSLanguage *language = ts_parser_language(parser_);
+        if (language != language_) {
+            symbols_.clear();
+            language_ = language;
+        }
+        auto it = symbols_.find(name);
+        if (it != symbols_.end()) return it->second;
+
+        // only the first time of every name is a linear search
+        uint16_t id = TS_LOG_NO_SYMBOL;
+        if (language != nullptr) {
+            uint32_t size = static_cast<uint32_t>(name.size());
+            TSSymbol result = ts_language_symbol_for_name(language, name.data(), size, true);
+            if (result == 0) result = ts_language_symbol_for_name(language, name.data(), size, false);
+            if (result != 0) id = result;
+        }
+        symbols_.emplace(std::string(name), id);
+        return id;
+    }
+
+    const TSParser *parser_;
+    TSLogRecord *records_;
+    uint32_t capacity_;
+    // the producer only states
+    uint32_t row_;
+    uint32_t column_;
+    // the symbol ids by name of the language
+    std::unordered_map<std::string, uint16_t, TSTransparentHash, std::equal_to<>> symbols_;
+    const TSLanguage *language_ = nullptr;
+
+    alignas(64) std::atomic<uint64_t> head_;
+    alignas(64) std::atomic<uint64_t> tail_;
+    std::atomic<uint64_t> dropped_;
+};
+
+#endif // __TS_LOG_RING_H__
@@ -15,12 +15,15 @@
  */
 
 #include "ts_utils.h"
+#include "ts_string_table.h"
+
+#include <vector>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-jlong JNICALL lookahead_iterator_init(jlong language, jshort state) {
+jlong JNICALL lookahead_iterator_init CRITICAL_ARGS(jlong language, jshort state) {
     TSLookaheadIterator *self = ts_lookahead_iterator_new(
         reinterpret_cast<TSLanguage*>(language), 
         static_cast<uint16_t>(state)
@@ -28,7 +31,7 @@ jlong JNICALL lookahead_iterator_init(jlong language, jshort state) {
     return reinterpret_cast<jlong>(self);
 }
 
-void JNICALL lookahead_iterator_delete(jlong lookahead) {
+void JNICALL lookahead_iterator_delete CRITICAL_ARGS(jlong lookahead) {
     ts_lookahead_iterator_delete(
         reinterpret_cast<TSLookaheadIterator*>(lookahead)
     );
@@ -54,8 +57,9 @@ jshort JNICALL lookahead_iterator_get_current_symbol(JNIEnv *env, jobject thiz)
 
 jstring JNICALL lookahead_iterator_get_current_symbol_name(JNIEnv *env, jobject thiz) {
     TSLookaheadIterator *self = GET_POINTER(TSLookaheadIterator, thiz);
-    const char *name = ts_lookahead_iterator_current_symbol_name(self);
-    return env->NewStringUTF(name);
+    return TSStringTable::symbol_name(
+        env, ts_lookahead_iterator_language(self), ts_lookahead_iterator_current_symbol(self)
+    );
 }
 
 jboolean JNICALL lookahead_iterator_reset(JNIEnv *env, jobject thiz, jshort state, jobject language) {
@@ -81,6 +85,20 @@ jboolean JNICALL lookahead_iterator_native_next(JNIEnv *env, jobject thiz) {
     return static_cast<jboolean>(ts_lookahead_iterator_next(self));
 }
 
+// all the symbols of the state in one call, instead of one call per symbol
+jshortArray JNICALL lookahead_iterator_native_symbols(JNIEnv *env, jobject thiz, jshort state) {
+    TSLookaheadIterator *self = GET_POINTER(TSLookaheadIterator, thiz);
+    std::vector<jshort> symbols;
+    if (ts_lookahead_iterator_reset_state(self, static_cast<uint16_t>(state))) {
+        while (ts_lookahead_iterator_next(self)) {
+            symbols.push_back(static_cast<jshort>(ts_lookahead_iterator_current_symbol(self)));
+        }
+    }
+    jshortArray result = env->NewShortArray(static_cast<jsize>(symbols.size()));
+    env->SetShortArrayRegion(result, 0, static_cast<jsize>(symbols.size()), symbols.data());
+    return result;
+}
+
 extern const JNINativeMethod TSLookaheadIterator_methods[] = {
     {"init", "(JS)J", (void *)&lookahead_iterator_init},
     {"delete", "(J)V", (void *)&lookahead_iterator_delete},
@@ -90,6 +108,7 @@ extern const JNINativeMethod TSLookaheadIterator_methods[] = {
      (void *)&lookahead_iterator_get_current_symbol_name},
     {"reset", "(SL" PACKAGE "TSLanguage;)Z", (void *)&lookahead_iterator_reset},
     {"nativeNext", "()Z", (void *)&lookahead_iterator_native_next},
+    {"nativeSymbols", "(S)[S", (void *)&lookahead_iterator_native_symbols},
 };
 
 extern const size_t TSLookaheadIterator_methods_size =
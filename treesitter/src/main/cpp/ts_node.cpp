@@ -16,7 +16,11 @@
 
 #include <stdio.h>
 
+#include <algorithm>
+#include <vector>
+
 #include "ts_utils.h"
+#include "ts_string_table.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -43,14 +47,12 @@ jshort JNICALL node_grammar_symbol(JNIEnv *env, jobject thiz) {
 
 jstring JNICALL node_type(JNIEnv *env, jobject thiz) {
     TSNode self = unmarshal_node(env, thiz);
-    const char *type = ts_node_type(self);
-    return env->NewStringUTF(type);
+    return TSStringTable::symbol_name(env, ts_tree_language(self.tree), ts_node_symbol(self));
 }
 
 jstring JNICALL node_grammar_type(JNIEnv *env, jobject thiz) {
     TSNode self = unmarshal_node(env, thiz);
-    const char *type = ts_node_grammar_type(self);
-    return env->NewStringUTF(type);
+    return TSStringTable::symbol_name(env, ts_tree_language(self.tree), ts_node_grammar_symbol(self));
 }
 
 jboolean JNICALL node_is_named(JNIEnv *env, jobject thiz) {
@@ -278,6 +280,75 @@ jobject JNICALL node_children_by_field_id(JNIEnv *env, jobject thiz, jshort id)
     return array_list;
 }
 
+// walk the descendants in preorder and pack the nodes of the types, the subtrees
+// outside the byte range [start, end) are skipped without visiting their children
+jintArray JNICALL node_native_find_descendants(
+    JNIEnv *env, jobject thiz, jshortArray types, jint start, jint end, jint max_results
+) {
+    TSNode self = unmarshal_node(env, thiz);
+    uint32_t range_start = static_cast<uint32_t>(start);
+    uint32_t range_end = static_cast<uint32_t>(end);
+    uint32_t limit = static_cast<uint32_t>(std::max(max_results, 0));
+
+    // the bitmap of the symbols, the ERROR symbol 65535 is the largest one
+    jsize type_count = env->GetArrayLength(types);
+    std::vector<uint16_t> symbols(type_count);
+    env->GetShortArrayRegion(types, 0, type_count, reinterpret_cast<jshort*>(symbols.data()));
+    std::vector<uint64_t> bitmap;
+    for (uint16_t symbol : symbols) {
+        if (symbol / 64U >= bitmap.size()) bitmap.resize(symbol / 64U + 1, 0);
+        bitmap[symbol / 64U] |= 1ULL << (symbol % 64U);
+    }
+
+    std::vector<jint> results;
+    TSTreeCursor cursor = ts_tree_cursor_new(self);
+    bool ok = !bitmap.empty() && limit > 0 && ts_tree_cursor_goto_first_child(&cursor);
+    while (ok) {
+        TSNode node = ts_tree_cursor_current_node(&cursor);
+        uint32_t start_byte = ts_node_start_byte(node);
+        uint32_t end_byte = ts_node_end_byte(node);
+        // the following nodes in preorder start at or after this one
+        if (start_byte >= range_end) break;
+
+        if (end_byte > range_start) {
+            TSSymbol symbol = ts_node_symbol(node);
+            if (symbol / 64U < bitmap.size() && (bitmap[symbol / 64U] >> (symbol % 64U) & 1U)) {
+                TSPoint end_point = ts_node_end_point(node);
+                uint64_t id = reinterpret_cast<uint64_t>(node.id);
+                results.insert(results.end(), {
+                    static_cast<jint>(node.context[0]),
+                    static_cast<jint>(node.context[1]),
+                    static_cast<jint>(node.context[2]),
+                    static_cast<jint>(node.context[3]),
+                    static_cast<jint>(id & 0xffffffffULL),
+                    static_cast<jint>(id >> 32),
+                    static_cast<jint>(end_byte),
+                    static_cast<jint>(end_point.row),
+                    static_cast<jint>(end_point.column),
+                    static_cast<jint>(symbol)
+                });
+                if (results.size() / NODE_DESCENDANT_STRIDE >= limit) break;
+            }
+            // skip the children which end before the range
+            if (start_byte < range_start) {
+                if (ts_tree_cursor_goto_first_child_for_byte(&cursor, range_start) >= 0) continue;
+            } else if (ts_tree_cursor_goto_first_child(&cursor)) {
+                continue;
+            }
+        }
+
+        // the next sibling of the node or the nearest ancestor
+        while (!(ok = ts_tree_cursor_goto_next_sibling(&cursor))) {
+            if (!ts_tree_cursor_goto_parent(&cursor)) break;
+        }
+    }
+    ts_tree_cursor_delete(&cursor);
+
+    jintArray result = env->NewIntArray(static_cast<jsize>(results.size()));
+    env->SetIntArrayRegion(result, 0, static_cast<jsize>(results.size()), results.data());
+    return result;
+}
+
 jstring JNICALL node_field_name_for_child(JNIEnv *env, jobject thiz, jint index) {
     TSNode self = unmarshal_node(env, thiz);
     if (ts_node_child_count(self) <= static_cast<uint32_t>(index)) {
@@ -289,7 +360,7 @@ jstring JNICALL node_field_name_for_child(JNIEnv *env, jobject thiz, jint index)
     }
 
     const char *field_name = ts_node_field_name_for_child(self, static_cast<uint32_t>(index));
-    return field_name ? env->NewStringUTF(field_name) : nullptr;
+    return TSStringTable::field_name(env, ts_tree_language(self.tree), field_name);
 }
 
 jstring JNICALL node_field_name_for_named_child(JNIEnv *env, jobject thiz, jint index) {
@@ -303,7 +374,7 @@ jstring JNICALL node_field_name_for_named_child(JNIEnv *env, jobject thiz, jint
     }
 
     const char *field_name = ts_node_field_name_for_named_child(self, static_cast<uint32_t>(index));
-    return field_name ? env->NewStringUTF(field_name) : nullptr;
+    return TSStringTable::field_name(env, ts_tree_language(self.tree), field_name);
 }
 
 jobject JNICALL node_child_with_descendant(JNIEnv *env, jobject thiz, jobject descendant) {
@@ -421,6 +492,7 @@ extern const JNINativeMethod TSNode_methods[] = {
     {"childByFieldName", "(Ljava/lang/String;)L" PACKAGE "TSNode;",
      (void *)&node_child_by_field_name},
     {"childrenByFieldId", "(S)Ljava/util/List;", (void *)&node_children_by_field_id},
+    {"nativeFindDescendants", "([SIII)[I", (void *)&node_native_find_descendants},
     {"fieldNameForChild", "(I)Ljava/lang/String;", (void *)&node_field_name_for_child},
     {"fieldNameForNamedChild", "(I)Ljava/lang/String;", (void *)&node_field_name_for_named_child},
     {"childWithDescendant", "(L" PACKAGE "TSNode;)L" PACKAGE "TSNode;",
@@ -0,0 +1,180 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ts_utils.h"
+#include "ts_offset_index.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+jlong JNICALL offset_index_init(JNIEnv *env, jclass clazz, jstring text) {
+    jsize length = env->GetStringLength(text);
+    // note here no JNI calls are allowed until the string is released
+    const jchar *chars = env->GetStringCritical(text, nullptr);
+    TSOffsetIndex *index = new TSOffsetIndex(
+        reinterpret_cast<const char16_t*>(chars), static_cast<uint32_t>(length)
+    );
+    env->ReleaseStringCritical(text, chars);
+    return reinterpret_cast<jlong>(index);
+}
+
+jlong JNICALL offset_index_copy(JNIEnv *env, jclass clazz, jlong index) {
+    return reinterpret_cast<jlong>(new TSOffsetIndex(*reinterpret_cast<TSOffsetIndex*>(index)));
+}
+
+void JNICALL offset_index_delete CRITICAL_ARGS(jlong index) {
+    delete reinterpret_cast<TSOffsetIndex*>(index);
+}
+
+jint JNICALL offset_index_get_utf8_length(JNIEnv *env, jobject thiz) {
+    TSOffsetIndex *self = GET_POINTER(TSOffsetIndex, thiz);
+    return static_cast<jint>(self->utf8_length());
+}
+
+jint JNICALL offset_index_get_utf16_length(JNIEnv *env, jobject thiz) {
+    TSOffsetIndex *self = GET_POINTER(TSOffsetIndex, thiz);
+    return static_cast<jint>(self->utf16_length());
+}
+
+jint JNICALL offset_index_to_utf8(JNIEnv *env, jobject thiz, jint offset) {
+    TSOffsetIndex *self = GET_POINTER(TSOffsetIndex, thiz);
+    return static_cast<jint>(self->to_utf8(static_cast<uint32_t>(std::max(offset, 0))));
+}
+
+jint JNICALL offset_index_to_utf16(JNIEnv *env, jobject thiz, jint offset) {
+    TSOffsetIndex *self = GET_POINTER(TSOffsetIndex, thiz);
+    return static_cast<jint>(self->to_utf16(static_cast<uint32_t>(std::max(offset, 0))));
+}
+
+void JNICALL offset_index_replace(JNIEnv *env, jobject thiz, jint start, jint end, jstring text) {
+    TSOffsetIndex *self = GET_POINTER(TSOffsetIndex, thiz);
+    jsize length = env->GetStringLength(text);
+    const jchar *chars = env->GetStringCritical(text, nullptr);
+    uint32_t start8, end8, new_end8;
+    self->edit(
+        static_cast<uint32_t>(std::max(start, 0)), static_cast<uint32_t>(std::max(end, 0)),
+        reinterpret_cast<const char16_t*>(chars), static_cast<uint32_t>(length),
+        &start8, &end8, &new_end8
+    );
+    env->ReleaseStringCritical(text, chars);
+}
+
+// decode the UTF-8 range [start, end) to a java string, the range is read from
+// the blocks of the index, so the bytes are never copied as a whole
+jstring JNICALL offset_index_text(JNIEnv *env, jobject thiz, jint start, jint end) {
+    TSOffsetIndex *self = GET_POINTER(TSOffsetIndex, thiz);
+    uint32_t offset = static_cast<uint32_t>(std::max(start, 0));
+    uint32_t limit = std::clamp<uint32_t>(static_cast<uint32_t>(std::max(end, 0)), offset, self->utf8_length());
+    std::u16string text;
+    text.reserve(limit - offset);
+    uint32_t code = 0, remaining = 0;
+    while (offset < limit) {
+        uint32_t length;
+        const uint8_t *p = reinterpret_cast<const uint8_t*>(self->segment(offset, &length));
+        length = std::min(length, limit - offset);
+        for (uint32_t i = 0; i < length; ++i) {
+            uint8_t c = p[i];
+            if (remaining > 0) {
+                code = (code << 6) | (c & 0x3f);
+                if (--remaining > 0) continue;
+            } else if (c < 0x80) {
+                code = c;
+            } else {
+                // the lead byte, the index only holds the valid sequences
+                remaining = c >= 0xf0 ? 3 : c >= 0xe0 ? 2 : 1;
+                code = c & (0x3f >> remaining);
+                continue;
+            }
+            if (code >= 0x10000) {
+                text += static_cast<char16_t>(0xd800 + ((code - 0x10000) >> 10));
+                text += static_cast<char16_t>(0xdc00 + ((code - 0x10000) & 0x3ff));
+            } else {
+                text += static_cast<char16_t>(code);
+            }
+        }
+        offset += length;
+    }
+    return env->NewString(reinterpret_cast<const jchar*>(text.data()), static_cast<jsize>(text.size()));
+}
+
+// the edits are packed in UTF-16 code units, same as TSTree.editAll, the index
+// is updated by every edit in order, and the edit is translated to UTF-8 bytes
+void JNICALL offset_index_native_edit(
+    JNIEnv *env, jobject thiz, jobject tree, jintArray edits, jobjectArray texts
+) {
+    TSOffsetIndex *self = GET_POINTER(TSOffsetIndex, thiz);
+    TSTree *tree_ptr = tree ? GET_POINTER(TSTree, tree) : nullptr;
+    jsize length = env->GetArrayLength(edits);
+    if (length % INPUT_EDIT_STRIDE != 0 || length / INPUT_EDIT_STRIDE != env->GetArrayLength(texts)) {
+        THROW(IllegalArgumentException, "The packed edits length must be 9 times the texts size");
+        return;
+    }
+
+    std::vector<jint> values(length);
+    env->GetIntArrayRegion(edits, 0, length, values.data());
+    for (jsize i = 0; i < length; i += INPUT_EDIT_STRIDE) {
+        const jint *edit = values.data() + i;
+        uint32_t start16 = static_cast<uint32_t>(edit[0]);
+        uint32_t old_end16 = static_cast<uint32_t>(edit[1]);
+        uint32_t new_end16 = static_cast<uint32_t>(edit[2]);
+        // the line starts of the old positions, translated before the text is changed
+        uint32_t start_line8 = self->to_utf8(start16 - std::min<uint32_t>(edit[4], start16));
+        uint32_t old_end_line8 = self->to_utf8(old_end16 - std::min<uint32_t>(edit[6], old_end16));
+
+        jstring text = static_cast<jstring>(env->GetObjectArrayElement(texts, i / INPUT_EDIT_STRIDE));
+        jsize text_length = env->GetStringLength(text);
+        const jchar *chars = env->GetStringCritical(text, nullptr);
+        uint32_t start8, old_end8, new_end8;
+        self->edit(
+            start16, old_end16, reinterpret_cast<const char16_t*>(chars),
+            static_cast<uint32_t>(text_length), &start8, &old_end8, &new_end8
+        );
+        env->ReleaseStringCritical(text, chars);
+        env->DeleteLocalRef(text);
+
+        if (tree_ptr == nullptr) continue;
+        uint32_t new_end_line8 = self->to_utf8(new_end16 - std::min<uint32_t>(edit[8], new_end16));
+        TSInputEdit input_edit = {
+            .start_byte = start8,
+            .old_end_byte = old_end8,
+            .new_end_byte = new_end8,
+            .start_point = {static_cast<uint32_t>(edit[3]), start8 - start_line8},
+            .old_end_point = {static_cast<uint32_t>(edit[5]), old_end8 - old_end_line8},
+            .new_end_point = {static_cast<uint32_t>(edit[7]), new_end8 - new_end_line8}
+        };
+        ts_tree_edit(tree_ptr, &input_edit);
+    }
+}
+
+extern const JNINativeMethod TSOffsetIndex_methods[] = {
+    {"init", "(Ljava/lang/String;)J", (void *)&offset_index_init},
+    {"copy", "(J)J", (void *)&offset_index_copy},
+    {"delete", "(J)V", (void *)&offset_index_delete},
+    {"getUtf8Length", "()I", (void *)&offset_index_get_utf8_length},
+    {"getUtf16Length", "()I", (void *)&offset_index_get_utf16_length},
+    {"toUtf8", "(I)I", (void *)&offset_index_to_utf8},
+    {"toUtf16", "(I)I", (void *)&offset_index_to_utf16},
+    {"replace", "(IILjava/lang/String;)V", (void *)&offset_index_replace},
+    {"text", "(II)Ljava/lang/String;", (void *)&offset_index_text},
+    {"nativeEdit", "(L" PACKAGE "TSTree;[I[Ljava/lang/String;)V", (void *)&offset_index_native_edit}
+};
+
+extern const size_t TSOffsetIndex_methods_size = sizeof TSOffsetIndex_methods / sizeof(JNINativeMethod);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
@@ -0,0 +1,379 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __TS_OFFSET_INDEX_H__
+#define __TS_OFFSET_INDEX_H__
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// the max distance in UTF-16 code units between two checkpoints, also from the
+// start of the document to the first one, and from the last one to the end
+#define TS_OFFSET_INDEX_INTERVAL 1024
+
+// the size of the blocks of the UTF-8 bytes, an edit copies the edited blocks only
+#define TS_OFFSET_INDEX_BLOCK 4096
+
+// check 16 UTF-8 bytes are all ASCII
+static inline bool ts_is_ascii16(const uint8_t *bytes) {
+#if defined(__ARM_NEON) && defined(__aarch64__)
+    return vmaxvq_u8(vld1q_u8(bytes)) < 0x80;
+#elif defined(__SSE2__)
+    return _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes))) == 0;
+#else
+    uint64_t a, b;
+    memcpy(&a, bytes, 8);
+    memcpy(&b, bytes + 8, 8);
+    return ((a | b) & 0x8080808080808080ULL) == 0;
+#endif
+}
+
+// narrow 8 UTF-16 code units to UTF-8 if they are all ASCII
+static inline bool ts_narrow_ascii8(const char16_t *units, uint8_t *out) {
+#if defined(__ARM_NEON) && defined(__aarch64__)
+    uint16x8_t value = vld1q_u16(reinterpret_cast<const uint16_t*>(units));
+    if (vmaxvq_u16(value) >= 0x80) return false;
+    vst1_u8(out, vmovn_u16(value));
+    return true;
+#elif defined(__SSE2__)
+    __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(units));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(value, _mm_set1_epi16(-0x80)), _mm_setzero_si128())) != 0xffff)
+        return false;
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(value, value));
+    return true;
+#else
+    uint64_t a, b;
+    memcpy(&a, units, 8);
+    memcpy(&b, units + 4, 8);
+    if (((a | b) & 0xff80ff80ff80ff80ULL) != 0) return false;
+    for (int i = 0; i < 8; ++i) out[i] = static_cast<uint8_t>(units[i]);
+    return true;
+#endif
+}
+
+// the number of UTF-16 code units of the UTF-8 character started with the lead byte,
+// the continuation bytes are zero, and the 4 bytes characters are surrogate pairs
+static inline uint32_t ts_utf16_units(uint8_t lead) {
+    if ((lead & 0xc0) == 0x80) return 0;
+    return lead >= 0xf0 ? 2 : 1;
+}
+
+// the UTF-8 source code of a UTF-16 document, and the checkpoints between the
+// UTF-16 code unit offsets and the UTF-8 byte offsets. The text is kept in the
+// immutable blocks shared by the copies, an edit replaces the edited blocks by
+// new ones, so a copy never copies the bytes. The checkpoints are sorted by
+// both offsets, a lookup is a binary search and a short scan
+class TSOffsetIndex {
+public:
+    struct Checkpoint {
+        uint32_t utf16;
+        uint32_t utf8;
+    };
+
+    TSOffsetIndex(const char16_t *text, uint32_t length) : length8_(0), length16_(length) {
+        std::string utf8;
+        transcode(text, length, 0, 0, utf8, checkpoints_);
+        split(utf8, blocks_);
+        length8_ = static_cast<uint32_t>(utf8.size());
+        update_starts(0);
+    }
+
+    uint32_t utf8_length() const { return length8_; }
+
+    uint32_t utf16_length() const { return length16_; }
+
+    // get the contiguous bytes started at the UTF-8 offset, used by the TSInput
+    const char *segment(uint32_t offset, uint32_t *length) const {
+        if (offset >= length8_) {
+            *length = 0;
+            return "";
+        }
+        size_t i = block_of(offset);
+        uint32_t position = offset - starts_[i];
+        *length = static_cast<uint32_t>(blocks_[i]->size()) - position;
+        return blocks_[i]->data() + position;
+    }
+
+    // the UTF-16 offset in the middle of a surrogate pair is moved after the pair
+    uint32_t to_utf8(uint32_t offset16) const {
+        offset16 = std::min(offset16, length16_);
+        auto it = std::upper_bound(
+            checkpoints_.begin(), checkpoints_.end(), offset16,
+            [](uint32_t value, const Checkpoint &c) { return value < c.utf16; }
+        );
+        Checkpoint c = it == checkpoints_.begin() ? Checkpoint {0, 0} : *(it - 1);
+        uint32_t length8 = utf8_length();
+        while (c.utf16 < offset16 && c.utf8 < length8) {
+            uint32_t length;
+            const uint8_t *p = reinterpret_cast<const uint8_t*>(segment(c.utf8, &length));
+            uint32_t i = 0;
+            // the ASCII fast path, 16 bytes are 16 code units
+            while (i + 16 <= length && c.utf16 + 16 <= offset16 && ts_is_ascii16(p + i)) {
+                i += 16;
+                c.utf16 += 16;
+            }
+            while (i < length && c.utf16 < offset16) {
+                c.utf16 += ts_utf16_units(p[i]);
+                i += 1;
+            }
+            c.utf8 += i;
+        }
+        // skip the continuation bytes of the last character
+        while (c.utf8 < length8 && ts_utf16_units(byte_at(c.utf8)) == 0) c.utf8 += 1;
+        return c.utf8;
+    }
+
+    // the UTF-8 offset in the middle of a character is moved to the character start
+    uint32_t to_utf16(uint32_t offset8) const {
+        offset8 = std::min(offset8, utf8_length());
+        auto it = std::upper_bound(
+            checkpoints_.begin(), checkpoints_.end(), offset8,
+            [](uint32_t value, const Checkpoint &c) { return value < c.utf8; }
+        );
+        Checkpoint c = it == checkpoints_.begin() ? Checkpoint {0, 0} : *(it - 1);
+        while (c.utf8 < offset8) {
+            uint32_t length;
+            const uint8_t *p = reinterpret_cast<const uint8_t*>(segment(c.utf8, &length));
+            length = std::min(length, offset8 - c.utf8);
+            uint32_t i = 0;
+            while (i + 16 <= length && ts_is_ascii16(p + i)) i += 16;
+            c.utf16 += i;
+            for (; i < length; ++i) c.utf16 += ts_utf16_units(p[i]);
+            c.utf8 += length;
+        }
+        // the offset is in the middle of a character
+        if (offset8 < utf8_length() && ts_utf16_units(byte_at(offset8)) == 0) {
+            uint32_t start = offset8;
+            while (start > 0 && ts_utf16_units(byte_at(start)) == 0) start -= 1;
+            c.utf16 -= ts_utf16_units(byte_at(start));
+        }
+        return c.utf16;
+    }
+
+    // replace the UTF-16 range [start16, end16) with the text, and
+    // get the replaced UTF-8 range [*start8, *end8) and the new end
+    void edit(uint32_t start16, uint32_t end16, const char16_t *text, uint32_t length,
+              uint32_t *start8, uint32_t *end8, uint32_t *new_end8) {
+        start16 = std::min(start16, length16_);
+        end16 = std::clamp(end16, start16, length16_);
+        *start8 = to_utf8(start16);
+        *end8 = to_utf8(end16);
+
+        std::string utf8;
+        std::vector<Checkpoint> inserted;
+        transcode(text, length, start16, *start8, utf8, inserted);
+        *new_end8 = *start8 + static_cast<uint32_t>(utf8.size());
+
+        replace(*start8, *end8 - *start8, utf8);
+
+        // drop the checkpoints inside the replaced range, and shift the following ones
+        int64_t delta16 = static_cast<int64_t>(length) - (end16 - start16);
+        int64_t delta8 = static_cast<int64_t>(utf8.size()) - (*end8 - *start8);
+        auto first = std::upper_bound(
+            checkpoints_.begin(), checkpoints_.end(), start16,
+            [](uint32_t value, const Checkpoint &c) { return value < c.utf16; }
+        );
+        auto last = std::lower_bound(
+            first, checkpoints_.end(), end16,
+            [](const Checkpoint &c, uint32_t value) { return c.utf16 < value; }
+        );
+        for (auto it = last; it != checkpoints_.end(); ++it) {
+            it->utf16 = static_cast<uint32_t>(it->utf16 + delta16);
+            it->utf8 = static_cast<uint32_t>(it->utf8 + delta8);
+        }
+        auto position = checkpoints_.erase(first, last);
+        size_t index = static_cast<size_t>(position - checkpoints_.begin());
+        checkpoints_.insert(position, inserted.begin(), inserted.end());
+        length16_ = static_cast<uint32_t>(length16_ + delta16);
+
+        // the checkpoints around the edit may be far apart now, like typing one character at a time
+        // which never inserts a checkpoint, so the gaps at both sides of the inserted ones are filled
+        fill(index + inserted.size());
+        if (!inserted.empty()) fill(index);
+    }
+
+    const std::vector<Checkpoint> &checkpoints() const { return checkpoints_; }
+
+private:
+    // add the checkpoints between the checkpoint at the index and the one before it, so
+    // that no gap is longer than the interval, the start and the end of the document
+    // are the implicit checkpoints before the first one and after the last one
+    void fill(size_t index) {
+        Checkpoint c = index == 0 ? Checkpoint {0, 0} : checkpoints_[index - 1];
+        Checkpoint next = index == checkpoints_.size() ? Checkpoint {length16_, utf8_length()} : checkpoints_[index];
+        if (next.utf16 - c.utf16 <= TS_OFFSET_INDEX_INTERVAL) return;
+        std::vector<Checkpoint> added;
+        uint32_t since = 0;
+        while (c.utf8 < next.utf8) {
+            uint32_t length;
+            const uint8_t *p = reinterpret_cast<const uint8_t*>(segment(c.utf8, &length));
+            length = std::min(length, next.utf8 - c.utf8);
+            uint32_t i = 0;
+            while (i < length) {
+                uint32_t count = 1, units = ts_utf16_units(p[i]);
+                if (i + 16 <= length && since + 16 <= TS_OFFSET_INDEX_INTERVAL && ts_is_ascii16(p + i)) {
+                    count = units = 16;
+                } else if (units > 0 && since + units > TS_OFFSET_INDEX_INTERVAL) {
+                    // a checkpoint is before a character, never in the middle of it
+                    added.push_back(c);
+                    since = 0;
+                }
+                since += units;
+                c.utf16 += units;
+                c.utf8 += count;
+                i += count;
+            }
+        }
+        checkpoints_.insert(checkpoints_.begin() + static_cast<ptrdiff_t>(index), added.begin(), added.end());
+    }
+
+    uint8_t byte_at(uint32_t offset) const {
+        size_t i = block_of(offset);
+        return static_cast<uint8_t>((*blocks_[i])[offset - starts_[i]]);
+    }
+
+    // the block containing the offset, the last block for the end of the document
+    size_t block_of(uint32_t offset) const {
+        auto it = std::upper_bound(starts_.begin(), starts_.end(), offset);
+        return static_cast<size_t>(it - starts_.begin()) - 1;
+    }
+
+    // the start offsets of the blocks from the index
+    void update_starts(size_t index) {
+        starts_.resize(blocks_.size());
+        for (size_t i = index; i < blocks_.size(); ++i) {
+            starts_[i] = i == 0 ? 0 : starts_[i - 1] + static_cast<uint32_t>(blocks_[i - 1]->size());
+        }
+    }
+
+    // split the bytes to the blocks of about TS_OFFSET_INDEX_BLOCK bytes, every cut is moved back
+    // to a character start, the lexer reads a segment as a whole, so a character split between
+    // two segments is decoded twice from its tail. The bytes are started at a character, so are
+    // the blocks, and replace keeps it by splitting the whole blocks around the edit
+    static void split(const std::string &bytes, std::vector<std::shared_ptr<const std::string>> &out) {
+        size_t count = (bytes.size() + TS_OFFSET_INDEX_BLOCK / 2) / TS_OFFSET_INDEX_BLOCK;
+        count = std::max<size_t>(count, bytes.empty() ? 0 : 1);
+        size_t start = 0;
+        for (size_t i = 0; i < count; ++i) {
+            size_t end = bytes.size() * (i + 1) / count;
+            while (end > start && end < bytes.size() && (static_cast<uint8_t>(bytes[end]) & 0xc0) == 0x80) --end;
+            if (end == start) continue;
+            out.push_back(std::make_shared<const std::string>(bytes, start, end - start));
+            start = end;
+        }
+    }
+
+    // convert the UTF-16 text to UTF-8, and add a checkpoint at most every
+    // interval code units, the offsets are started at base16 and base8
+    static void transcode(const char16_t *text, uint32_t length, uint32_t base16, uint32_t base8,
+                          std::string &out, std::vector<Checkpoint> &checkpoints) {
+        out.reserve(out.size() + length);
+        uint32_t last = 0;
+        uint32_t i = 0;
+        while (i < length) {
+            // the ASCII fast path, 8 code units are 8 bytes
+            uint8_t ascii[8];
+            if (i + 8 <= length && i - last + 8 <= TS_OFFSET_INDEX_INTERVAL && ts_narrow_ascii8(text + i, ascii)) {
+                out.append(reinterpret_cast<const char*>(ascii), 8);
+                i += 8;
+                continue;
+            }
+            bool is_pair = text[i] >= 0xd800 && text[i] < 0xdc00 && i + 1 < length &&
+                text[i + 1] >= 0xdc00 && text[i + 1] < 0xe000;
+            if (i - last + (is_pair ? 2 : 1) > TS_OFFSET_INDEX_INTERVAL) {
+                checkpoints.push_back({base16 + i, base8 + static_cast<uint32_t>(out.size())});
+                last = i;
+            }
+            uint32_t c = text[i++];
+            if (c >= 0xd800 && c < 0xdc00 && i < length && text[i] >= 0xdc00 && text[i] < 0xe000) {
+                c = 0x10000 + ((c - 0xd800) << 10) + (text[i++] - 0xdc00);
+            } else if (c >= 0xd800 && c < 0xe000) {
+                // an unpaired surrogate, keep a 3 bytes sequence so the code units still match
+                c = 0xfffd;
+            }
+            if (c < 0x80) {
+                out += static_cast<char>(c);
+            } else if (c < 0x800) {
+                out += static_cast<char>(0xc0 | (c >> 6));
+                out += static_cast<char>(0x80 | (c & 0x3f));
+            } else if (c < 0x10000) {
+                out += static_cast<char>(0xe0 | (c >> 12));
+                out += static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+                out += static_cast<char>(0x80 | (c & 0x3f));
+            } else {
+                out += static_cast<char>(0xf0 | (c >> 18));
+                out += static_cast<char>(0x80 | ((c >> 12) & 0x3f));
+                out += static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+                out += static_cast<char>(0x80 | (c & 0x3f));
+            }
+        }
+    }
+
+    // replace the bytes of the range [offset, offset + count) with the text, the blocks
+    // are never changed once created, so the edited blocks are replaced by new ones
+    void replace(uint32_t offset, uint32_t count, const std::string &text) {
+        if (blocks_.empty()) {
+            split(text, blocks_);
+            length8_ = static_cast<uint32_t>(text.size());
+            update_starts(0);
+            return;
+        }
+        size_t first = block_of(offset);
+        size_t last = count == 0 ? first : block_of(offset + count - 1);
+        std::string bytes;
+        bytes.reserve(TS_OFFSET_INDEX_BLOCK * 2 + text.size());
+        bytes.append(*blocks_[first], 0, offset - starts_[first]);
+        bytes.append(text);
+        bytes.append(*blocks_[last], offset + count - starts_[last], std::string::npos);
+        // a small block is merged with its neighbor, so the edits don't leave many tiny blocks
+        if (bytes.size() < TS_OFFSET_INDEX_BLOCK / 2) {
+            if (last + 1 < blocks_.size()) {
+                bytes.append(*blocks_[++last]);
+            } else if (first > 0) {
+                bytes.insert(0, *blocks_[--first]);
+            }
+        }
+
+        std::vector<std::shared_ptr<const std::string>> replaced;
+        split(bytes, replaced);
+        auto position = blocks_.erase(
+            blocks_.begin() + static_cast<ptrdiff_t>(first), blocks_.begin() + static_cast<ptrdiff_t>(last + 1)
+        );
+        blocks_.insert(position, replaced.begin(), replaced.end());
+        length8_ = length8_ - count + static_cast<uint32_t>(text.size());
+        update_starts(first);
+    }
+
+    // the blocks are immutable, the copies share them by the reference count alone
+    std::vector<std::shared_ptr<const std::string>> blocks_;
+    std::vector<uint32_t> starts_;
+    uint32_t length8_;
+    uint32_t length16_;
+    std::vector<Checkpoint> checkpoints_;
+};
+
+#endif // __TS_OFFSET_INDEX_H__
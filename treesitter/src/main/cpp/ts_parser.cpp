@@ -16,10 +16,17 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
 
 #include "ts_utils.h"
+#include "ts_log_ring.h"
+#include "ts_offset_index.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -29,15 +36,54 @@ extern "C" {
 static jbyteArray bytes = nullptr;
 static jbyte *chunks = nullptr;
 
-jlong JNICALL parser_init() {
+// count the parse, and the bytes that the reparse did not reuse
+static void stats_parse(const TSTree *old_tree, const TSTree *new_tree) {
+    if (!ts_stats_is_enabled() || new_tree == nullptr) return;
+    ts_stats_add(TS_STAT_PARSE_COUNT, 1);
+    if (old_tree == nullptr) return;
+    
+    uint32_t length;
+    TSRange *ranges = ts_tree_get_changed_ranges(old_tree, new_tree, &length);
+    uint64_t changed_bytes = 0;
+    for (uint32_t i = 0; i < length; ++i) {
+        changed_bytes += ranges[i].end_byte - ranges[i].start_byte;
+    }
+    free(ranges);
+    ts_stats_add(TS_STAT_REPARSE_COUNT, 1);
+    ts_stats_add(TS_STAT_REPARSE_BYTES, ts_node_end_byte(ts_tree_root_node(new_tree)));
+    ts_stats_add(TS_STAT_REPARSE_CHANGED_BYTES, changed_bytes);
+}
+
+// the logger of the ring buffer mode, the payload is a TSLogRing
+static void ring_log(void *payload, TSLogType type, const char *buffer) {
+    reinterpret_cast<TSLogRing*>(payload)->log(type, buffer);
+}
+
+// get the ring buffer of the parser, or null if the ring buffer mode is off
+static TSLogRing *get_log_ring(const TSParser *parser) {
+    TSLogger logger = ts_parser_logger(parser);
+    return logger.log == ring_log ? reinterpret_cast<TSLogRing*>(logger.payload) : nullptr;
+}
+
+// release the ring buffer or the global reference of the kotlin lambda
+static void release_logger(JNIEnv *env, TSParser *parser) {
+    TSLogger logger = ts_parser_logger(parser);
+    if (logger.payload == nullptr) return;
+    if (logger.log == ring_log) {
+        delete reinterpret_cast<TSLogRing*>(logger.payload);
+    } else {
+        env->DeleteGlobalRef(reinterpret_cast<jobject>(logger.payload));
+    }
+    ts_parser_set_logger(parser, {nullptr, nullptr});
+}
+
+jlong JNICALL parser_init CRITICAL_ARGS() {
     return reinterpret_cast<jlong>(ts_parser_new()); 
 }
 
 void JNICALL parser_delete(JNIEnv *env, jclass clazz, jlong parser) {
     TSParser *self = reinterpret_cast<TSParser*>(parser);
-    TSLogger logger = ts_parser_logger(self);
-    if (logger.payload != nullptr)
-        env->DeleteGlobalRef((jobject)logger.payload);
+    release_logger(env, self);
     ts_parser_delete(self);
 }
 
@@ -127,11 +173,10 @@ void JNICALL parser_set_logger(JNIEnv *env, jobject thiz, jobject value) {
     };
     
     TSParser *self = GET_POINTER(TSParser, thiz);
-    TSLogger logger = ts_parser_logger(self);
-    if (logger.payload != nullptr) {
-        // release previous global logger reference
-        env->DeleteGlobalRef(reinterpret_cast<jobject>(logger.payload));
-    }
+    // release the previous logger, the lambda replaces the ring buffer
+    release_logger(env, self);
+    env->SetIntField(thiz, global_field_cache.TSParser_logCapacity, 0);
+    TSLogger logger;
     // check the kotlin lambda object
     if (value != nullptr) {        
         logger.payload = reinterpret_cast<void*>(
@@ -148,6 +193,86 @@ void JNICALL parser_set_logger(JNIEnv *env, jobject thiz, jobject value) {
     env->SetObjectField(thiz, global_field_cache.TSParser_logger, value);
 }
 
+void JNICALL parser_set_log_capacity(JNIEnv *env, jobject thiz, jint value) {
+    TSParser *self = GET_POINTER(TSParser, thiz);
+    // the ring buffer replaces the previous logger
+    release_logger(env, self);
+    env->SetObjectField(thiz, global_field_cache.TSParser_logger, nullptr);
+    
+    TSLogRing *ring = nullptr;
+    if (value > 0) {
+        ring = new TSLogRing(self, static_cast<uint32_t>(value));
+        ts_parser_set_logger(self, {ring, ring_log});
+    }
+    env->SetIntField(thiz, global_field_cache.TSParser_logCapacity, ring ? ring->capacity() : 0);
+}
+
+jint JNICALL parser_drain_log(JNIEnv *env, jobject thiz, jintArray records) {
+    TSParser *self = GET_POINTER(TSParser, thiz);
+    TSLogRing *ring = get_log_ring(self);
+    if (ring == nullptr) return 0;
+    
+    uint32_t max_count = static_cast<uint32_t>(env->GetArrayLength(records)) / TS_LOG_RECORD_STRIDE;
+    // the array is written back in one call, the records are not pinned
+    // while the parser may be producing on another thread
+    std::vector<jint> values(static_cast<size_t>(max_count) * TS_LOG_RECORD_STRIDE);
+    jint *p = values.data();
+    uint32_t count = ring->drain(max_count, [&p](const TSLogRecord &record) {
+        *p++ = record.type;
+        *p++ = record.event;
+        *p++ = record.symbol == TS_LOG_NO_SYMBOL ? -1 : record.symbol;
+        *p++ = record.state;
+        *p++ = static_cast<jint>(record.row);
+        *p++ = static_cast<jint>(record.column);
+    });
+    env->SetIntArrayRegion(records, 0, count * TS_LOG_RECORD_STRIDE, values.data());
+    return static_cast<jint>(count);
+}
+
+jint JNICALL parser_dump_log(JNIEnv *env, jobject thiz, jint fd) {
+    TSParser *self = GET_POINTER(TSParser, thiz);
+    TSLogRing *ring = get_log_ring(self);
+    if (ring == nullptr) return 0;
+    
+    const TSLanguage *language = ts_parser_language(self);
+    std::string text;
+    char line[256];
+    uint32_t total = 0;
+    for (;;) {
+        // format a batch of the records, and write them in one call
+        uint32_t count = ring->drain(1024, [&](const TSLogRecord &record) {
+            const char *symbol = "";
+            if (record.symbol != TS_LOG_NO_SYMBOL && language != nullptr)
+                symbol = ts_language_symbol_name(language, record.symbol);
+            snprintf(line, sizeof line, "%s %s state:%d sym:%s row:%u col:%u\n",
+                record.type == TSLogTypeLex ? "LEX" : "PARSE", ts_log_event_names[record.event],
+                record.state, symbol ? symbol : "", record.row, record.column);
+            text += line;
+        });
+        if (count == 0) break;
+        total += count;
+        
+        size_t written = 0;
+        while (written < text.size()) {
+            ssize_t result = write(fd, text.data() + written, text.size() - written);
+            if (result < 0) {
+                if (errno == EINTR) continue;
+                LOGE("Error: %s\n", strerror(errno));
+                return -1;
+            }
+            written += static_cast<size_t>(result);
+        }
+        text.clear();
+    }
+    return static_cast<jint>(total);
+}
+
+jlong JNICALL parser_get_dropped_log_count(JNIEnv *env, jobject thiz) {
+    TSParser *self = GET_POINTER(TSParser, thiz);
+    TSLogRing *ring = get_log_ring(self);
+    return ring ? static_cast<jlong>(ring->dropped()) : 0;
+}
+
 jobject JNICALL parser_parse_string(
     JNIEnv *env, jobject thiz, jobject oldTree, jobject charset, jbyteArray byte_array
 ) { 
@@ -168,10 +293,16 @@ jobject JNICALL parser_parse_string(
     
     // old native TSTree
     TSTree *old_tree = oldTree ? GET_POINTER(TSTree, oldTree) : nullptr;
-    // new native TSTree    
-    TSTree *new_tree = ts_parser_parse_string_encoding(
-        self, old_tree, reinterpret_cast<const char*>(byte_chars), length, encoding
-    );
+    TSTree *new_tree = nullptr;
+    {
+        TSTraceSpan span("TSParser.parse", TS_STAT_PARSE_NANOS);
+        // new native TSTree    
+        new_tree = ts_parser_parse_string_encoding(
+            self, old_tree, reinterpret_cast<const char*>(byte_chars), length, encoding
+        );
+    }
+    ts_stats_add(TS_STAT_BYTES_READ, length);
+    stats_parse(old_tree, new_tree);
     
     jstring source = nullptr;
     // note here requires to check the encoding
@@ -215,6 +346,7 @@ jobject JNICALL parser_parse_function(
         jobject position = NEW_OBJECT(TSPoint, point.row, point.column);
         // convert kotlin Int to UInt
         jobject uint_index = env->AllocObject(global_class_cache.UInt);
+        ts_stats_add(TS_STAT_JNI_OBJECTS, 1);
         env->SetIntField(uint_index, global_field_cache.UInt_data, static_cast<jint>(byte_index));
         
         // call kotlin ParseCallback lambda
@@ -224,6 +356,7 @@ jobject JNICALL parser_parse_function(
         chunks = env->GetByteArrayElements(bytes, nullptr);
         // reset bytes_read
         *bytes_read = env->GetArrayLength(bytes);
+        ts_stats_add(TS_STAT_BYTES_READ, *bytes_read);
         
         env->DeleteLocalRef(uint_index);
         env->DeleteLocalRef(position);
@@ -240,12 +373,120 @@ jobject JNICALL parser_parse_function(
     
     // old native TSTree
     TSTree *old_tree = oldTree ? GET_POINTER(TSTree, oldTree) : nullptr;
-    // new native TSTree
-    TSTree *new_tree = ts_parser_parse(self, old_tree, {(void*)value, callback, encoding});    
+    TSTree *new_tree = nullptr;
+    {
+        TSTraceSpan span("TSParser.parse", TS_STAT_PARSE_NANOS);
+        // new native TSTree
+        new_tree = ts_parser_parse(self, old_tree, {(void*)value, callback, encoding});    
+    }
+    stats_parse(old_tree, new_tree);
     // return the new java TSTree object
     return NEW_OBJECT(TSTree, reinterpret_cast<jlong>(new_tree), nullptr, language);
 }
 
+// parse the UTF-8 source code of the offset index, the chunks are read
+// from the blocks of the index directly without copying
+jobject JNICALL parser_native_parse_index(
+    JNIEnv *env, jobject thiz, jobject oldTree, jobject index, jstring source
+) {
+    jobject language = GET_FIELD(Object, thiz, TSParser_language);
+    if (language == nullptr) {
+        THROW(IllegalStateException, "The parser has no language assigned");
+        return nullptr;
+    }
+    
+    auto read = [](void *payload, uint32_t byte_index, TSPoint point, uint32_t *bytes_read) {
+        return reinterpret_cast<TSOffsetIndex*>(payload)->segment(byte_index, bytes_read);
+    };
+    
+    TSParser *self = GET_POINTER(TSParser, thiz);
+    TSOffsetIndex *offset_index = GET_POINTER(TSOffsetIndex, index);
+    TSTree *old_tree = oldTree ? GET_POINTER(TSTree, oldTree) : nullptr;
+    TSTree *new_tree = nullptr;
+    {
+        TSTraceSpan span("TSParser.parse", TS_STAT_PARSE_NANOS);
+        new_tree = ts_parser_parse(self, old_tree, {offset_index, read, TSInputEncodingUTF8});
+    }
+    ts_stats_add(TS_STAT_BYTES_READ, offset_index->utf8_length());
+    stats_parse(old_tree, new_tree);
+    
+    if (new_tree == nullptr) {
+        THROW(IllegalStateException, "The parsing was cancelled or timed out");
+        return nullptr;
+    }
+    return NEW_OBJECT(TSTree, reinterpret_cast<jlong>(new_tree), source, language);
+}
+
+// map the file read-only and parse it as UTF-8, the mapping is only
+// alive while parsing, the tree does not reference the source code
+static jobject parse_mapped_file(JNIEnv *env, jobject thiz, jobject oldTree, int fd) {
+    jobject language = GET_FIELD(Object, thiz, TSParser_language);
+    if (language == nullptr) {
+        THROW(IllegalStateException, "The parser has no language assigned");
+        return nullptr;
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        THROW(IOException, strerror(errno));
+        return nullptr;
+    }
+    // the tree-sitter offsets are uint32_t
+    if (st.st_size > static_cast<off_t>(UINT32_MAX)) {
+        THROW(IllegalArgumentException, "The file is larger than 4GB");
+        return nullptr;
+    }
+    
+    size_t length = static_cast<size_t>(st.st_size);
+    void *mapping = nullptr;
+    if (length > 0) {
+        mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            THROW(IOException, strerror(errno));
+            return nullptr;
+        }
+        // the parser reads the file from the beginning to the end
+        madvise(mapping, length, MADV_SEQUENTIAL);
+    }
+    
+    TSParser *self = GET_POINTER(TSParser, thiz);
+    TSTree *old_tree = oldTree ? GET_POINTER(TSTree, oldTree) : nullptr;
+    TSTree *new_tree = nullptr;
+    {
+        TSTraceSpan span("TSParser.parseFile", TS_STAT_PARSE_NANOS);
+        new_tree = ts_parser_parse_string_encoding(
+            self, old_tree, mapping ? static_cast<const char*>(mapping) : "", length, TSInputEncodingUTF8
+        );
+    }
+    ts_stats_add(TS_STAT_BYTES_READ, length);
+    stats_parse(old_tree, new_tree);
+    
+    if (mapping != nullptr) munmap(mapping, length);
+    
+    if (new_tree == nullptr) {
+        THROW(IllegalStateException, "The parsing was cancelled or timed out");
+        return nullptr;
+    }
+    return NEW_OBJECT(TSTree, reinterpret_cast<jlong>(new_tree), nullptr, language);
+}
+
+jobject JNICALL parser_parse_file_descriptor(JNIEnv *env, jobject thiz, jobject oldTree, jint fd) {
+    return parse_mapped_file(env, thiz, oldTree, fd);
+}
+
+jobject JNICALL parser_parse_file_path(JNIEnv *env, jobject thiz, jobject oldTree, jstring pathname) {
+    const char *path = env->GetStringUTFChars(pathname, nullptr);
+    int fd = open(path, O_RDONLY|O_CLOEXEC);
+    env->ReleaseStringUTFChars(pathname, path);
+    if (fd < 0) {
+        THROW(IOException, strerror(errno));
+        return nullptr;
+    }
+    jobject tree = parse_mapped_file(env, thiz, oldTree, fd);
+    close(fd);
+    return tree;
+}
+
 extern const JNINativeMethod TSParser_methods[] = {
     {"init", "()J", (void *)&parser_init},
     {"delete", "(J)V", (void *)&parser_delete},
@@ -256,10 +497,18 @@ extern const JNINativeMethod TSParser_methods[] = {
     {"setTimeoutMicros", "(J)V", (void *)&parser_set_timeout_micros},
     {"setCancelled", "(Z)V", (void *)&parser_set_cancelled_flag},
     {"setLogger", "(Lkotlin/jvm/functions/Function2;)V", (void *)&parser_set_logger},
+    {"setLogCapacity", "(I)V", (void *)&parser_set_log_capacity},
+    {"drainLog", "([I)I", (void *)&parser_drain_log},
+    {"dumpLog", "(I)I", (void *)&parser_dump_log},
+    {"getDroppedLogCount", "()J", (void *)&parser_get_dropped_log_count},
     {"parse", "(L" PACKAGE "TSTree;L" PACKAGE "TSInputEncoding;[B)L" PACKAGE "TSTree;",
       (void *)&parser_parse_string},
     {"parse", "(L" PACKAGE "TSTree;L" PACKAGE "TSInputEncoding;Lkotlin/jvm/functions/Function2;)L" PACKAGE "TSTree;",
-      (void *)&parser_parse_function}
+      (void *)&parser_parse_function},
+    {"nativeParse", "(L" PACKAGE "TSTree;L" PACKAGE "TSOffsetIndex;Ljava/lang/String;)L" PACKAGE "TSTree;",
+      (void *)&parser_native_parse_index},
+    {"parseFile", "(L" PACKAGE "TSTree;I)L" PACKAGE "TSTree;", (void *)&parser_parse_file_descriptor},
+    {"parseFile", "(L" PACKAGE "TSTree;Ljava/lang/String;)L" PACKAGE "TSTree;", (void *)&parser_parse_file_path}
 };
 
 extern const size_t TSParser_methods_size = sizeof TSParser_methods / sizeof(JNINativeMethod);
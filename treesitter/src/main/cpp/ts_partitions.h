@@ -0,0 +1,99 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __TS_PARTITIONS_H__
+#define __TS_PARTITIONS_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <tree_sitter/api.h>
+
+// the byte ranges [start, end) changed by a reparse
+typedef std::vector<std::pair<uint32_t, uint32_t>> TSByteRanges;
+
+// the changed ranges between the edited old tree and the new tree
+static inline TSByteRanges ts_changed_byte_ranges(const TSTree *old_tree, const TSTree *tree) {
+    uint32_t length = 0;
+    TSRange *changes = ts_tree_get_changed_ranges(old_tree, tree, &length);
+    TSByteRanges ranges;
+    ranges.reserve(length);
+    for (uint32_t i = 0; i < length; ++i) ranges.emplace_back(changes[i].start_byte, changes[i].end_byte);
+    free(changes);
+    return ranges;
+}
+
+// the range [start, end) overlaps a range, the empty node touching a range is included
+static inline bool ts_overlaps(const TSByteRanges &ranges, uint32_t start, uint32_t end) {
+    for (const auto &range : ranges) {
+        if (start <= range.second && end >= range.first) return true;
+    }
+    return false;
+}
+
+// split the tree by the children of the root, like the indexes of TSLocals and TSCompletion,
+// the old partitions are the ones of the last update, one per child of the old tree in order,
+// each child of the tree is passed in order to move(partition, child) if its old partition can
+// be reused, or to build(child) otherwise, the old tree is the edited tree of the last update,
+// or null to build every child, a partition P has the length of its child
+//
+// a child is reused if it has the same length, no edit, and doesn't overlap a changed range,
+// the edit of a token to another of the same length, like renaming an identifier, changes
+// no syntax, so it's not in the changed ranges, but the edited child has changes
+//
+// returns the old partitions which are moved
+template <typename P, typename Move, typename Build>
+std::vector<bool> ts_split_partitions(const TSTree *tree, const TSTree *old_tree, std::vector<P> &old,
+                                      Move &&move, Build &&build) {
+    // the unchanged children of the edited old tree by the start byte
+    std::unordered_map<uint32_t, size_t> reusable;
+    if (old_tree != nullptr) {
+        TSByteRanges changes = ts_changed_byte_ranges(old_tree, tree);
+        TSTreeCursor cursor = ts_tree_cursor_new(ts_tree_root_node(old_tree));
+        size_t i = 0;
+        for (bool ok = ts_tree_cursor_goto_first_child(&cursor); ok && i < old.size();
+             ok = ts_tree_cursor_goto_next_sibling(&cursor), ++i) {
+            TSNode child = ts_tree_cursor_current_node(&cursor);
+            uint32_t start = ts_node_start_byte(child), end = ts_node_end_byte(child);
+            if (end - start == old[i].length && !ts_node_has_changes(child) && !ts_overlaps(changes, start, end)) {
+                reusable.emplace(start, i);
+            }
+        }
+        ts_tree_cursor_delete(&cursor);
+    }
+
+    std::vector<bool> moved(old.size(), false);
+    TSTreeCursor cursor = ts_tree_cursor_new(ts_tree_root_node(tree));
+    for (bool ok = ts_tree_cursor_goto_first_child(&cursor); ok; ok = ts_tree_cursor_goto_next_sibling(&cursor)) {
+        TSNode child = ts_tree_cursor_current_node(&cursor);
+        uint32_t start = ts_node_start_byte(child), end = ts_node_end_byte(child);
+        auto it = reusable.find(start);
+        if (it != reusable.end() && old[it->second].length == end - start && !moved[it->second]) {
+            moved[it->second] = true;
+            move(old[it->second], child);
+        } else {
+            build(child);
+        }
+    }
+    ts_tree_cursor_delete(&cursor);
+    return moved;
+}
+
+#endif // __TS_PARTITIONS_H__
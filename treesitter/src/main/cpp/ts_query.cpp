@@ -17,6 +17,8 @@
 #include <ctype.h>
 #include <malloc.h>
 
+#include <vector>
+
 #include "ts_utils.h"
 
 #ifdef __cplusplus
@@ -127,11 +129,11 @@ jlong JNICALL query_init(JNIEnv *env, jclass clazz, jlong language, jstring patt
     return reinterpret_cast<jlong>(nullptr);
 }
 
-jlong JNICALL query_cursor() { 
+jlong JNICALL query_cursor CRITICAL_ARGS() { 
     return reinterpret_cast<jlong>(ts_query_cursor_new()); 
 }
 
-void JNICALL query_delete(jlong query, jlong cursor) {
+void JNICALL query_delete CRITICAL_ARGS(jlong query, jlong cursor) {
     ts_query_delete(reinterpret_cast<TSQuery*>(query));
     ts_query_cursor_delete(reinterpret_cast<TSQueryCursor*>(cursor));
 }
@@ -264,6 +266,22 @@ jboolean JNICALL query_is_pattern_non_local(JNIEnv *env, jobject thiz, jint inde
     return JNI_FALSE;
 }
 
+// get the ids of the captures that appear in the pattern
+jintArray JNICALL query_captures_for_pattern(JNIEnv *env, jobject thiz, jint index) {
+    TSQuery *self = GET_POINTER(TSQuery, thiz);
+    uint32_t capture_count = ts_query_capture_count(self);
+    std::vector<jint> ids;
+    for (uint32_t id = 0; id < capture_count; ++id) {
+        TSQuantifier quantifier = ts_query_capture_quantifier_for_id(
+            self, static_cast<uint32_t>(index), id
+        );
+        if (quantifier != TSQuantifierZero) ids.push_back(static_cast<jint>(id));
+    }
+    jintArray result = env->NewIntArray(static_cast<jsize>(ids.size()));
+    env->SetIntArrayRegion(result, 0, static_cast<jsize>(ids.size()), ids.data());
+    return result;
+}
+
 jint JNICALL query_string_count(JNIEnv *env, jobject thiz) {
     TSQuery *self = GET_POINTER(TSQuery, thiz);
     return static_cast<jint>(ts_query_string_count(self));
@@ -343,7 +361,9 @@ void JNICALL query_exec(JNIEnv *env, jobject thiz, jobject node) {
         GET_FIELD(Long, thiz, TSQuery_cursor)
     );
     TSNode ts_node = unmarshal_node(env, node);
+    TSTraceSpan span("TSQuery.exec", TS_STAT_QUERY_NANOS);
     ts_query_cursor_exec(cursor, self, ts_node);
+    ts_stats_add(TS_STAT_QUERY_COUNT, 1);
 }
 
 jobject query_next_match(JNIEnv *env, jobject thiz, jobject tree) {
@@ -351,28 +371,17 @@ jobject query_next_match(JNIEnv *env, jobject thiz, jobject tree) {
         GET_FIELD(Long, thiz, TSQuery_cursor)
     );
     TSQueryMatch match;
-    if (!ts_query_cursor_next_match(cursor, &match))
-        return nullptr;
-
-    jobject capture_names = GET_FIELD(Object, thiz, TSQuery_captureNames);
-    // array list object
-    jobject captures = NEW_OBJECT(ArrayList, (jint)match.capture_count);
-    for (uint16_t i = 0; i < match.capture_count; ++i) {
-        TSQueryCapture capture = match.captures[i];
-        jobject node = marshal_node(env, &capture.node, tree);
-        jobject name = CALL_METHOD(Object, capture_names, List_get, capture.index);
-        if (env->ExceptionCheck())
-            return nullptr;
-
-        jobject capture_object = NEW_OBJECT(TSQueryCapture, node, name);
-        CALL_METHOD(Boolean, captures, ArrayList_add, capture_object);
-        env->DeleteLocalRef(capture_object);
-        env->DeleteLocalRef(node);
-        env->DeleteLocalRef(name);
-        if (env->ExceptionCheck())
+    {
+        // only counted, a span of every match would flood the trace
+        TSTraceSpan span(nullptr, TS_STAT_QUERY_NANOS);
+        if (!ts_query_cursor_next_match(cursor, &match))
             return nullptr;
     }
-    return NEW_OBJECT(TSQueryMatch, (jint)match.pattern_index, captures);
+    ts_stats_add(TS_STAT_QUERY_MATCHES, 1);
+    ts_stats_add(TS_STAT_QUERY_CAPTURES, match.capture_count);
+
+    jobject capture_names = GET_FIELD(Object, thiz, TSQuery_captureNames);
+    return marshal_query_match(env, &match, capture_names, tree);
 }
 
 jobject JNICALL query_next_capture(JNIEnv *env, jobject thiz, jobject tree) {
@@ -381,30 +390,15 @@ jobject JNICALL query_next_capture(JNIEnv *env, jobject thiz, jobject tree) {
     );
     uint32_t capture_index;
     TSQueryMatch match;
-    if (!ts_query_cursor_next_capture(cursor, &match, &capture_index))
-        return nullptr;
-
-    jobject capture_names = GET_FIELD(Object, thiz, TSQuery_captureNames);
-    jobject captures = NEW_OBJECT(ArrayList, (jint)match.capture_count);
-    for (uint16_t i = 0; i < match.capture_count; ++i) {
-        TSQueryCapture capture = match.captures[i];
-        jobject node = marshal_node(env, &capture.node, tree);
-        jobject name = CALL_METHOD(Object, capture_names, List_get, capture.index);
-        if (env->ExceptionCheck())
-            return nullptr;
-
-        jobject capture_object = NEW_OBJECT(TSQueryCapture, node, name);
-        CALL_METHOD(Boolean, captures, ArrayList_add, capture_object);
-        env->DeleteLocalRef(capture_object);
-        env->DeleteLocalRef(node);
-        env->DeleteLocalRef(name);
-        if (env->ExceptionCheck())
+    {
+        TSTraceSpan span(nullptr, TS_STAT_QUERY_NANOS);
+        if (!ts_query_cursor_next_capture(cursor, &match, &capture_index))
             return nullptr;
     }
-    jobject match_object = NEW_OBJECT(TSQueryMatch, (jint)match.pattern_index, captures);
-    jobject index = env->AllocObject(global_class_cache.UInt);
-    env->SetIntField(index, global_field_cache.UInt_data, (jint)capture_index);
-    return NEW_OBJECT(Pair, index, match_object);
+    ts_stats_add(TS_STAT_QUERY_CAPTURES, 1);
+
+    jobject capture_names = GET_FIELD(Object, thiz, TSQuery_captureNames);
+    return marshal_query_capture(env, &match, capture_index, capture_names, tree);
 }
 
 extern const JNINativeMethod TSQuery_methods[] = {
@@ -425,6 +419,7 @@ extern const JNINativeMethod TSQuery_methods[] = {
     {"isPatternRooted", "(I)Z", (void *)&query_is_pattern_rooted},
     {"isPatternNonLocal", "(I)Z", (void *)&query_is_pattern_non_local},
     {"stringCount", "()I", (void *)&query_string_count},
+    {"capturesForPattern", "(I)[I", (void *)&query_captures_for_pattern},
     {"captureNameForId", "(I)Ljava/lang/String;", (void *)&query_capture_name_for_id},
     {"stringValueForId", "(I)Ljava/lang/String;", (void *)&query_string_value_for_id},
     {"exec", "(L" PACKAGE "TSNode;)V", (void *)&query_exec},
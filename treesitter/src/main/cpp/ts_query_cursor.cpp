@@ -0,0 +1,138 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ts_utils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+jlong JNICALL query_cursor_init CRITICAL_ARGS() {
+    return reinterpret_cast<jlong>(ts_query_cursor_new());
+}
+
+void JNICALL query_cursor_delete CRITICAL_ARGS(jlong cursor) {
+    ts_query_cursor_delete(reinterpret_cast<TSQueryCursor*>(cursor));
+}
+
+jlong JNICALL query_cursor_get_timeout_micros(JNIEnv *env, jobject thiz) {
+    TSQueryCursor *self = GET_POINTER(TSQueryCursor, thiz);
+    return static_cast<jlong>(ts_query_cursor_timeout_micros(self));
+}
+
+void JNICALL query_cursor_set_timeout_micros(JNIEnv *env, jobject thiz, jlong value) {
+    TSQueryCursor *self = GET_POINTER(TSQueryCursor, thiz);
+    ts_query_cursor_set_timeout_micros(self, static_cast<uint64_t>(value));
+}
+
+jint JNICALL query_cursor_get_match_limit(JNIEnv *env, jobject thiz) {
+    TSQueryCursor *self = GET_POINTER(TSQueryCursor, thiz);
+    return static_cast<jint>(ts_query_cursor_match_limit(self));
+}
+
+void JNICALL query_cursor_set_match_limit(JNIEnv *env, jobject thiz, jint value) {
+    TSQueryCursor *self = GET_POINTER(TSQueryCursor, thiz);
+    ts_query_cursor_set_match_limit(self, static_cast<uint32_t>(value));
+}
+
+void JNICALL query_cursor_native_set_max_start_depth(JNIEnv *env, jobject thiz, jint value) {
+    TSQueryCursor *self = GET_POINTER(TSQueryCursor, thiz);
+    ts_query_cursor_set_max_start_depth(self, static_cast<uint32_t>(value));
+}
+
+jboolean JNICALL query_cursor_did_exceed_match_limit(JNIEnv *env, jobject thiz) {
+    TSQueryCursor *self = GET_POINTER(TSQueryCursor, thiz);
+    return static_cast<jboolean>(ts_query_cursor_did_exceed_match_limit(self));
+}
+
+void JNICALL query_cursor_native_set_byte_range(JNIEnv *env, jobject thiz, jint start, jint end) {
+    TSQueryCursor *self = GET_POINTER(TSQueryCursor, thiz);
+    ts_query_cursor_set_byte_range(self, static_cast<uint32_t>(start), static_cast<uint32_t>(end));
+}
+
+void JNICALL query_cursor_native_set_point_range(
+    JNIEnv *env, jobject thiz, jobject start, jobject end
+) {
+    TSQueryCursor *self = GET_POINTER(TSQueryCursor, thiz);
+    TSPoint start_point = unmarshal_point(env, start), end_point = unmarshal_point(env, end);
+    ts_query_cursor_set_point_range(self, start_point, end_point);
+}
+
+// the compiled query is only read by the cursor, so that
+// the same query can be executed by many cursors at the same time
+void JNICALL query_cursor_exec(JNIEnv *env, jobject thiz, jobject query, jobject node) {
+    TSQueryCursor *self = GET_POINTER(TSQueryCursor, thiz);
+    TSQuery *ts_query = GET_POINTER(TSQuery, query);
+    TSNode ts_node = unmarshal_node(env, node);
+    TSTraceSpan span("TSQueryCursor.exec", TS_STAT_QUERY_NANOS);
+    ts_query_cursor_exec(self, ts_query, ts_node);
+    ts_stats_add(TS_STAT_QUERY_COUNT, 1);
+}
+
+jobject JNICALL query_cursor_next_match(JNIEnv *env, jobject thiz, jobject query, jobject tree) {
+    TSQueryCursor *self = GET_POINTER(TSQueryCursor, thiz);
+    TSQueryMatch match;
+    {
+        TSTraceSpan span(nullptr, TS_STAT_QUERY_NANOS);
+        if (!ts_query_cursor_next_match(self, &match))
+            return nullptr;
+    }
+    ts_stats_add(TS_STAT_QUERY_MATCHES, 1);
+    ts_stats_add(TS_STAT_QUERY_CAPTURES, match.capture_count);
+
+    jobject capture_names = GET_FIELD(Object, query, TSQuery_captureNames);
+    return marshal_query_match(env, &match, capture_names, tree);
+}
+
+jobject JNICALL query_cursor_next_capture(JNIEnv *env, jobject thiz, jobject query, jobject tree) {
+    TSQueryCursor *self = GET_POINTER(TSQueryCursor, thiz);
+    uint32_t capture_index;
+    TSQueryMatch match;
+    {
+        TSTraceSpan span(nullptr, TS_STAT_QUERY_NANOS);
+        if (!ts_query_cursor_next_capture(self, &match, &capture_index))
+            return nullptr;
+    }
+    ts_stats_add(TS_STAT_QUERY_CAPTURES, 1);
+
+    jobject capture_names = GET_FIELD(Object, query, TSQuery_captureNames);
+    return marshal_query_capture(env, &match, capture_index, capture_names, tree);
+}
+
+extern const JNINativeMethod TSQueryCursor_methods[] = {
+    {"init", "()J", (void *)&query_cursor_init},
+    {"delete", "(J)V", (void *)&query_cursor_delete},
+    {"getTimeoutMicros", "()J", (void *)&query_cursor_get_timeout_micros},
+    {"setTimeoutMicros", "(J)V", (void *)&query_cursor_set_timeout_micros},
+    {"getMatchLimit", "()I", (void *)&query_cursor_get_match_limit},
+    {"setMatchLimit", "(I)V", (void *)&query_cursor_set_match_limit},
+    {"nativeSetMaxStartDepth", "(I)V", (void *)&query_cursor_native_set_max_start_depth},
+    {"didExceedMatchLimit", "()Z", (void *)&query_cursor_did_exceed_match_limit},
+    {"nativeSetByteRange", "(II)V", (void *)&query_cursor_native_set_byte_range},
+    {"nativeSetPointRange", "(L" PACKAGE "TSPoint;L" PACKAGE "TSPoint;)V",
+     (void *)&query_cursor_native_set_point_range},
+    {"exec", "(L" PACKAGE "TSQuery;L" PACKAGE "TSNode;)V", (void *)&query_cursor_exec},
+    {"nextMatch", "(L" PACKAGE "TSQuery;L" PACKAGE "TSTree;)L" PACKAGE "TSQueryMatch;",
+     (void *)&query_cursor_next_match},
+    {"nextCapture", "(L" PACKAGE "TSQuery;L" PACKAGE "TSTree;)Lkotlin/Pair;",
+     (void *)&query_cursor_next_capture},
+};
+
+extern const size_t TSQueryCursor_methods_size = sizeof TSQueryCursor_methods / sizeof(JNINativeMethod);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
@@ -0,0 +1,123 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ts_utils.h"
+#include "ts_selection.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// the range packed as [start, end], or an empty array if not found
+static jintArray new_range(JNIEnv *env, bool found, const TSSelection::Range &range) {
+    jintArray result = env->NewIntArray(found ? 2 : 0);
+    if (found) {
+        jint values[] = {static_cast<jint>(range.start), static_cast<jint>(range.end)};
+        env->SetIntArrayRegion(result, 0, 2, values);
+    }
+    return result;
+}
+
+static TSSelection::Range to_range(jint start, jint end) {
+    uint32_t start8 = static_cast<uint32_t>(std::max(start, 0));
+    return {start8, std::max(start8, static_cast<uint32_t>(std::max(end, 0)))};
+}
+
+static std::string to_string(JNIEnv *env, jstring string) {
+    const char *chars = env->GetStringUTFChars(string, nullptr);
+    std::string result(chars, env->GetStringUTFLength(string));
+    env->ReleaseStringUTFChars(string, chars);
+    return result;
+}
+
+jlong JNICALL selection_init(JNIEnv *env, jclass clazz, jobject textobjects) {
+    TSQuery *query = textobjects ? GET_POINTER(TSQuery, textobjects) : nullptr;
+    return reinterpret_cast<jlong>(new TSSelection(query));
+}
+
+void JNICALL selection_delete CRITICAL_ARGS(jlong selection) {
+    delete reinterpret_cast<TSSelection*>(selection);
+}
+
+jintArray JNICALL selection_expand(JNIEnv *env, jobject thiz, jobject tree, jint start, jint end) {
+    TSSelection *self = GET_POINTER(TSSelection, thiz);
+    TSTree *tree_ptr = GET_POINTER(TSTree, tree);
+    TSSelection::Range range;
+    bool found = self->expand(tree_ptr, to_range(start, end), range);
+    return new_range(env, found, range);
+}
+
+jintArray JNICALL selection_shrink(JNIEnv *env, jobject thiz, jobject tree, jint start, jint end) {
+    TSSelection *self = GET_POINTER(TSSelection, thiz);
+    TSTree *tree_ptr = GET_POINTER(TSTree, tree);
+    TSSelection::Range range;
+    bool found = self->shrink(tree_ptr, to_range(start, end), range);
+    return new_range(env, found, range);
+}
+
+jintArray JNICALL selection_sibling(JNIEnv *env, jobject thiz, jobject tree, jint start, jint end, jboolean forward) {
+    TSSelection *self = GET_POINTER(TSSelection, thiz);
+    TSTree *tree_ptr = GET_POINTER(TSTree, tree);
+    TSSelection::Range range;
+    bool found = self->sibling(tree_ptr, to_range(start, end), forward, range);
+    return new_range(env, found, range);
+}
+
+jintArray JNICALL selection_select(
+    JNIEnv *env, jobject thiz, jobject tree, jobject index, jstring capture, jint start, jint end
+) {
+    TSSelection *self = GET_POINTER(TSSelection, thiz);
+    TSTree *tree_ptr = GET_POINTER(TSTree, tree);
+    TSOffsetIndex *index_ptr = GET_POINTER(TSOffsetIndex, index);
+    TSSelection::Range range;
+    bool found = self->select(tree_ptr, index_ptr, to_string(env, capture), to_range(start, end), range);
+    return new_range(env, found, range);
+}
+
+jintArray JNICALL selection_move(
+    JNIEnv *env, jobject thiz, jobject tree, jobject index, jstring capture, jint byte, jboolean forward
+) {
+    TSSelection *self = GET_POINTER(TSSelection, thiz);
+    TSTree *tree_ptr = GET_POINTER(TSTree, tree);
+    TSOffsetIndex *index_ptr = GET_POINTER(TSOffsetIndex, index);
+    TSSelection::Range range;
+    bool found = self->move(
+        tree_ptr, index_ptr, to_string(env, capture), static_cast<uint32_t>(std::max(byte, 0)), forward, range
+    );
+    return new_range(env, found, range);
+}
+
+void JNICALL selection_reset(JNIEnv *env, jobject thiz) {
+    TSSelection *self = GET_POINTER(TSSelection, thiz);
+    self->reset();
+}
+
+extern const JNINativeMethod TSSelection_methods[] = {
+    {"init", "(L" PACKAGE "TSQuery;)J", (void *)&selection_init},
+    {"delete", "(J)V", (void *)&selection_delete},
+    {"expand", "(L" PACKAGE "TSTree;II)[I", (void *)&selection_expand},
+    {"shrink", "(L" PACKAGE "TSTree;II)[I", (void *)&selection_shrink},
+    {"sibling", "(L" PACKAGE "TSTree;IIZ)[I", (void *)&selection_sibling},
+    {"select", "(L" PACKAGE "TSTree;L" PACKAGE "TSOffsetIndex;Ljava/lang/String;II)[I", (void *)&selection_select},
+    {"move", "(L" PACKAGE "TSTree;L" PACKAGE "TSOffsetIndex;Ljava/lang/String;IZ)[I", (void *)&selection_move},
+    {"reset", "()V", (void *)&selection_reset},
+};
+
+extern const size_t TSSelection_methods_size = sizeof TSSelection_methods / sizeof(JNINativeMethod);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
@@ -0,0 +1,457 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __TS_SELECTION_H__
+#define __TS_SELECTION_H__
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <regex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <tree_sitter/api.h>
+
+#include "ts_offset_index.h"
+
+// the structural selection of a tree, expand and shrink by the enclosing named nodes,
+// and the text objects of a textobjects query like @function.outer. The chain of the
+// enclosing nodes is computed once for the first press, the next presses only move along
+// the cached chain, the text objects are collected once per tree for the first lookup.
+// The text predicates #eq?, #match?, #any-of? and their negations are evaluated on the text
+// of the offset index, #make-range! makes an object from its two captures, and the captures
+// started with an underscore like @_start are the helpers of the predicates, never objects
+class TSSelection {
+public:
+    struct Range {
+        uint32_t start;
+        uint32_t end;
+    };
+
+    explicit TSSelection(const TSQuery *textobjects) : query_(textobjects) {
+        if (query_ == nullptr) return;
+        cursor_ = ts_query_cursor_new();
+        for (uint32_t i = 0; i < ts_query_capture_count(query_); ++i) {
+            uint32_t length;
+            const char *name = ts_query_capture_name_for_id(query_, i, &length);
+            bool is_helper = length > 0 && name[0] == '_';
+            objects_of_captures_.push_back(is_helper ? UINT32_MAX : object_id(std::string(name, length)));
+        }
+        patterns_.resize(ts_query_pattern_count(query_));
+        for (uint32_t i = 0; i < patterns_.size(); ++i) compile(i);
+    }
+
+    ~TSSelection() {
+        if (cursor_ != nullptr) ts_query_cursor_delete(cursor_);
+    }
+
+    TSSelection(const TSSelection &) = delete;
+    TSSelection &operator=(const TSSelection &) = delete;
+
+    // the smallest named node strictly enclosing the selection, the next press
+    // of the same selection moves one level up the cached chain
+    bool expand(const TSTree *tree, Range selection, Range &out) {
+        validate(tree);
+        if (!is_current(selection)) build(selection);
+        if (level_ + 1 >= chain_.size()) return false;
+        out = chain_[++level_].range;
+        return true;
+    }
+
+    // the previous level of the cached chain, down to the selection of the first press,
+    // or the largest node at the start of a selection not made by expand
+    bool shrink(const TSTree *tree, Range selection, Range &out) {
+        validate(tree);
+        if (is_current(selection)) {
+            if (level_ == 0) return false;
+            out = chain_[--level_].range;
+            return true;
+        }
+        build({selection.start, selection.start});
+        for (size_t i = chain_.size(); i-- > 1;) {
+            const Range &range = chain_[i].range;
+            if (range.start >= selection.start && range.end <= selection.end &&
+                range.end - range.start < selection.end - selection.start) {
+                level_ = i;
+                out = range;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // the next or the previous named sibling of the selected node, the ancestors
+    // of the chain are kept, so the sibling can be expanded without a walk again
+    bool sibling(const TSTree *tree, Range selection, bool forward, Range &out) {
+        validate(tree);
+        if (!is_current(selection)) build(selection);
+        // a selection not made of a node moves from the innermost node around it
+        size_t level = ts_node_is_null(chain_[level_].node) ? level_ + 1 : level_;
+        if (level >= chain_.size()) return false;
+        TSNode node = chain_[level].node;
+        TSNode next = forward ? ts_node_next_named_sibling(node) : ts_node_prev_named_sibling(node);
+        if (ts_node_is_null(next)) return false;
+        chain_.erase(chain_.begin(), chain_.begin() + static_cast<ptrdiff_t>(level));
+        chain_[0] = {next, {ts_node_start_byte(next), ts_node_end_byte(next)}};
+        level_ = 0;
+        out = chain_[0].range;
+        return true;
+    }
+
+    // the smallest text object of the capture strictly enclosing the selection,
+    // the index is the text of the tree for the predicates
+    bool select(const TSTree *tree, const TSOffsetIndex *index, const std::string &capture,
+                Range selection, Range &out) {
+        const std::vector<Range> *objects = objects_of(tree, index, capture);
+        if (objects == nullptr) return false;
+        bool found = false;
+        // the objects are sorted by the start, only the ones started before the selection enclose it
+        for (const Range &range : *objects) {
+            if (range.start > selection.start) break;
+            if (range.end < selection.end || (range.start == selection.start && range.end == selection.end)) continue;
+            if (!found || range.end - range.start < out.end - out.start) {
+                out = range;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    // the first text object of the capture started after the byte, or the last one before it
+    bool move(const TSTree *tree, const TSOffsetIndex *index, const std::string &capture, uint32_t byte,
+              bool forward, Range &out) {
+        const std::vector<Range> *objects = objects_of(tree, index, capture);
+        if (objects == nullptr) return false;
+        auto by_start = [](const Range &range, uint32_t value) { return range.start < value; };
+        if (forward) {
+            auto it = std::lower_bound(objects->begin(), objects->end(), byte + 1, by_start);
+            if (it == objects->end()) return false;
+            out = *it;
+        } else {
+            auto it = std::lower_bound(objects->begin(), objects->end(), byte, by_start);
+            if (it == objects->begin()) return false;
+            // the outermost of the objects started at the same byte
+            uint32_t start = (it - 1)->start;
+            out = *std::lower_bound(objects->begin(), it, start, by_start);
+        }
+        return true;
+    }
+
+    void reset() {
+        chain_.clear();
+        objects_.clear();
+        level_ = 0;
+        is_collected_ = false;
+        tree_ = nullptr;
+    }
+
+private:
+    // a level of the chain, the node is null for the selection of the first press
+    struct Level {
+        TSNode node;
+        Range range;
+    };
+
+    enum PredicateKind { EQ, MATCH, ANY_OF, MAKE_RANGE };
+
+    // a predicate of a pattern, the capture is the first argument, the other one is the
+    // second capture of #eq? or the end of #make-range!, whose object is the first value
+    struct Predicate {
+        PredicateKind kind;
+        uint32_t capture;
+        uint32_t other;
+        std::vector<std::string> values;
+        std::regex regex;
+        bool is_positive;
+        bool is_any;
+    };
+
+    // the predicates of a pattern, a pattern with an invalid predicate never matches
+    struct Pattern {
+        std::vector<Predicate> predicates;
+        bool is_valid = true;
+    };
+
+    // the cached nodes belong to the tree, an edit changes the tree in place,
+    // so the owner resets the selection on every edit, see reset
+    void validate(const TSTree *tree) {
+        if (tree == tree_) return;
+        reset();
+        tree_ = tree;
+    }
+
+    bool is_current(Range selection) const {
+        return level_ < chain_.size() && chain_[level_].range.start == selection.start &&
+            chain_[level_].range.end == selection.end;
+    }
+
+    // descend from the root by the children enclosing the selection, the nodes
+    // of the same range are one level, which is the outermost of them
+    void build(Range selection) {
+        std::vector<Level> levels;
+        TSNode root = ts_tree_root_node(tree_);
+        levels.push_back({root, {ts_node_start_byte(root), ts_node_end_byte(root)}});
+        TSTreeCursor cursor = ts_tree_cursor_new(root);
+        while (goto_enclosing_child(&cursor, selection)) {
+            TSNode node = ts_tree_cursor_current_node(&cursor);
+            Range range {ts_node_start_byte(node), ts_node_end_byte(node)};
+            if (range.start > selection.start || range.end < selection.end) break;
+            if (!ts_node_is_named(node)) continue;
+            if (range.start != levels.back().range.start || range.end != levels.back().range.end) {
+                levels.push_back({node, range});
+            }
+        }
+        ts_tree_cursor_delete(&cursor);
+
+        chain_.clear();
+        chain_.push_back({TSNode {}, selection});
+        for (auto it = levels.rbegin(); it != levels.rend(); ++it) {
+            if (it->range.start == selection.start && it->range.end == selection.end) continue;
+            chain_.push_back(*it);
+        }
+        level_ = 0;
+    }
+
+    // move to the first child ending after the start of the selection, but the caret between
+    // two children, like the end of an identifier, is enclosed by the child ending at it, unless
+    // that one is anonymous and the next one starting at the caret is named, like `(|name`
+    static bool goto_enclosing_child(TSTreeCursor *cursor, Range selection) {
+        if (selection.start != selection.end || selection.start == 0) {
+            return ts_tree_cursor_goto_first_child_for_byte(cursor, selection.start) >= 0;
+        }
+        if (ts_tree_cursor_goto_first_child_for_byte(cursor, selection.start - 1) < 0) return false;
+        TSNode before = ts_tree_cursor_current_node(cursor);
+        if (ts_node_end_byte(before) != selection.start || ts_node_is_named(before)) return true;
+        if (ts_tree_cursor_goto_next_sibling(cursor)) {
+            TSNode after = ts_tree_cursor_current_node(cursor);
+            if (ts_node_start_byte(after) == selection.start && ts_node_is_named(after)) return true;
+            ts_tree_cursor_goto_previous_sibling(cursor);
+        }
+        return true;
+    }
+
+    // the object id of the name, the objects are the captures and the names of #make-range!
+    uint32_t object_id(const std::string &name) {
+        return captures_.emplace(name, static_cast<uint32_t>(captures_.size())).first->second;
+    }
+
+    // read the predicates of the pattern, the other predicates and directives like #set! are ignored
+    void compile(uint32_t pattern_index) {
+        Pattern &pattern = patterns_[pattern_index];
+        uint32_t count;
+        const TSQueryPredicateStep *steps = ts_query_predicates_for_pattern(query_, pattern_index, &count);
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t end = i;
+            while (end < count && steps[end].type != TSQueryPredicateStepTypeDone) ++end;
+            const TSQueryPredicateStep *step = steps + i;
+            uint32_t nargs = end - i;
+            i = end;
+            if (nargs == 0 || step[0].type != TSQueryPredicateStepTypeString) continue;
+            std::string name = string_of(step[0]);
+
+            Predicate predicate {};
+            predicate.other = UINT32_MAX;
+            predicate.is_positive = name.find("not-") == std::string::npos;
+            predicate.is_any = name.compare(0, 4, "any-") == 0 && name != "any-of?";
+            if (name == "make-range!") {
+                if (nargs != 4 || step[1].type != TSQueryPredicateStepTypeString ||
+                    step[2].type != TSQueryPredicateStepTypeCapture ||
+                    step[3].type != TSQueryPredicateStepTypeCapture) {
+                    pattern.is_valid = false;
+                    continue;
+                }
+                predicate.kind = MAKE_RANGE;
+                predicate.values.push_back(string_of(step[1]));
+                predicate.capture = step[2].value_id;
+                predicate.other = step[3].value_id;
+                object_id(predicate.values[0]);
+            } else if (name == "eq?" || name == "not-eq?" || name == "any-eq?" || name == "any-not-eq?" ||
+                       name == "match?" || name == "not-match?" || name == "any-match?" || name == "any-not-match?" ||
+                       name == "any-of?" || name == "not-any-of?") {
+                predicate.kind = name.find("eq?") != std::string::npos ? EQ :
+                    name.find("match?") != std::string::npos ? MATCH : ANY_OF;
+                if (nargs < 3 || (predicate.kind != ANY_OF && nargs != 3) ||
+                    step[1].type != TSQueryPredicateStepTypeCapture) {
+                    pattern.is_valid = false;
+                    continue;
+                }
+                predicate.capture = step[1].value_id;
+                for (uint32_t j = 2; j < nargs; ++j) {
+                    if (step[j].type == TSQueryPredicateStepTypeCapture && predicate.kind == EQ) {
+                        predicate.other = step[j].value_id;
+                    } else if (step[j].type == TSQueryPredicateStepTypeString) {
+                        predicate.values.push_back(string_of(step[j]));
+                    } else {
+                        pattern.is_valid = false;
+                    }
+                }
+                if (predicate.kind == MATCH && pattern.is_valid) {
+                    try {
+                        predicate.regex = std::regex(
+                            predicate.values[0], std::regex::ECMAScript | std::regex::optimize
+                        );
+                    } catch (const std::regex_error &) {
+                        pattern.is_valid = false;
+                    }
+                }
+            } else {
+                continue;
+            }
+            pattern.predicates.push_back(std::move(predicate));
+        }
+    }
+
+    std::string string_of(const TSQueryPredicateStep &step) const {
+        uint32_t length;
+        const char *value = ts_query_string_value_for_id(query_, step.value_id, &length);
+        return std::string(value, length);
+    }
+
+    static std::string text_of(const TSOffsetIndex *index, TSNode node) {
+        std::string text;
+        uint32_t offset = ts_node_start_byte(node), end = ts_node_end_byte(node);
+        while (offset < end) {
+            uint32_t length;
+            const char *p = index->segment(offset, &length);
+            if (length == 0) break;
+            length = std::min(length, end - offset);
+            text.append(p, length);
+            offset += length;
+        }
+        return text;
+    }
+
+    // the text predicates of the match, same as TSQueryPredicate of the TSQuery
+    static bool check(const Pattern &pattern, const TSQueryMatch &match, const TSOffsetIndex *index) {
+        if (!pattern.is_valid) return false;
+        std::vector<TSNode> nodes, others;
+        auto nodes_of = [&](uint32_t capture, std::vector<TSNode> &out) {
+            out.clear();
+            for (uint16_t i = 0; i < match.capture_count; ++i) {
+                if (match.captures[i].index == capture) out.push_back(match.captures[i].node);
+            }
+        };
+        for (const Predicate &predicate : pattern.predicates) {
+            if (predicate.kind == MAKE_RANGE) continue;
+            nodes_of(predicate.capture, nodes);
+            // no node of a quantified capture, #eq? of a string and #match? fail unless negated
+            if (nodes.empty()) {
+                bool result = predicate.kind == ANY_OF ? true :
+                    predicate.other != UINT32_MAX ? !predicate.is_any : !predicate.is_positive;
+                if (!result) return false;
+                continue;
+            }
+            if (predicate.other != UINT32_MAX) nodes_of(predicate.other, others);
+            size_t passed = 0;
+            for (TSNode node : nodes) {
+                std::string text = text_of(index, node);
+                bool result;
+                if (predicate.other != UINT32_MAX) {
+                    result = std::any_of(others.begin(), others.end(), [&](TSNode other) {
+                        return (text == text_of(index, other)) == predicate.is_positive;
+                    });
+                } else if (predicate.kind == EQ) {
+                    result = (text == predicate.values[0]) == predicate.is_positive;
+                } else if (predicate.kind == MATCH) {
+                    result = std::regex_search(text, predicate.regex) == predicate.is_positive;
+                } else {
+                    const std::vector<std::string> &values = predicate.values;
+                    result = (std::find(values.begin(), values.end(), text) != values.end()) == predicate.is_positive;
+                }
+                passed += result;
+            }
+            if (predicate.is_any ? passed == 0 : passed < nodes.size()) return false;
+        }
+        return true;
+    }
+
+    // the objects of the capture sorted by the start, then the outermost first, a quantified
+    // capture like (_)+ @parameter.inner is one object from its first node to its last node
+    const std::vector<Range> *objects_of(const TSTree *tree, const TSOffsetIndex *index, const std::string &capture) {
+        auto id = captures_.find(capture);
+        if (id == captures_.end()) return nullptr;
+        validate(tree);
+        if (!is_collected_) collect(index);
+        return &objects_[id->second];
+    }
+
+    void collect(const TSOffsetIndex *index) {
+        objects_.assign(captures_.size(), {});
+        ts_query_cursor_exec(cursor_, query_, ts_tree_root_node(tree_));
+        TSQueryMatch match;
+        std::vector<std::pair<uint32_t, Range>> merged;
+        auto merge = [&](uint32_t object, Range range) {
+            auto it = std::find_if(merged.begin(), merged.end(), [&](const auto &value) {
+                return value.first == object;
+            });
+            if (it == merged.end()) {
+                merged.push_back({object, range});
+            } else {
+                it->second.start = std::min(it->second.start, range.start);
+                it->second.end = std::max(it->second.end, range.end);
+            }
+        };
+        while (ts_query_cursor_next_match(cursor_, &match)) {
+            const Pattern &pattern = patterns_[match.pattern_index];
+            if (!check(pattern, match, index)) continue;
+            merged.clear();
+            for (uint16_t i = 0; i < match.capture_count; ++i) {
+                const TSQueryCapture &capture = match.captures[i];
+                uint32_t object = objects_of_captures_[capture.index];
+                if (object == UINT32_MAX) continue;
+                merge(object, {ts_node_start_byte(capture.node), ts_node_end_byte(capture.node)});
+            }
+            // the range from the start of the first capture to the end of the second one
+            for (const Predicate &predicate : pattern.predicates) {
+                if (predicate.kind != MAKE_RANGE) continue;
+                uint32_t start = UINT32_MAX, end = 0;
+                for (uint16_t i = 0; i < match.capture_count; ++i) {
+                    const TSQueryCapture &capture = match.captures[i];
+                    if (capture.index == predicate.capture) start = std::min(start, ts_node_start_byte(capture.node));
+                    if (capture.index == predicate.other) end = std::max(end, ts_node_end_byte(capture.node));
+                }
+                if (start <= end) merge(captures_.at(predicate.values[0]), {start, end});
+            }
+            for (const auto &[object, range] : merged) objects_[object].push_back(range);
+        }
+        for (std::vector<Range> &objects : objects_) {
+            std::sort(objects.begin(), objects.end(), [](const Range &a, const Range &b) {
+                return a.start < b.start || (a.start == b.start && a.end > b.end);
+            });
+            objects.erase(std::unique(objects.begin(), objects.end(), [](const Range &a, const Range &b) {
+                return a.start == b.start && a.end == b.end;
+            }), objects.end());
+        }
+        is_collected_ = true;
+    }
+
+    const TSQuery *query_;
+    TSQueryCursor *cursor_ = nullptr;
+    // the object ids of the names, and the object id of every capture id, none for the helpers
+    std::unordered_map<std::string, uint32_t> captures_;
+    std::vector<uint32_t> objects_of_captures_;
+    std::vector<Pattern> patterns_;
+    std::vector<std::vector<Range>> objects_;
+    bool is_collected_ = false;
+    // the chain of the last selection, innermost first, the level is the current selection
+    std::vector<Level> chain_;
+    size_t level_ = 0;
+    const TSTree *tree_ = nullptr;
+};
+
+#endif // __TS_SELECTION_H__
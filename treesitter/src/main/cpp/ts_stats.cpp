@@ -0,0 +1,182 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ts_utils.h"
+
+std::atomic<bool> ts_stats_enabled(false);
+
+// the blocks of the live threads and the sum of the exited threads
+static std::mutex stats_mutex;
+static std::vector<TSStatBlock*> stats_blocks;
+static uint64_t stats_retired[TS_STAT_COUNT];
+
+// the max number of the trace events kept in memory
+#define TRACE_EVENT_LIMIT (1 << 20)
+
+struct TSTraceEvent {
+    const char *name;
+    uint64_t start_nanos;
+    uint64_t duration_nanos;
+    pid_t tid;
+};
+
+static std::mutex trace_mutex;
+static std::vector<TSTraceEvent> trace_events;
+
+// register the block of the current thread, and merge it
+// to the retired counters when the thread exits
+struct TSStatHolder {
+    TSStatBlock block = {};
+
+    TSStatHolder() {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        stats_blocks.push_back(&block);
+    }
+
+    ~TSStatHolder() {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        for (int i = 0; i < TS_STAT_COUNT; ++i) {
+            stats_retired[i] += block.values[i].load(std::memory_order_relaxed);
+        }
+        stats_blocks.erase(std::remove(stats_blocks.begin(), stats_blocks.end(), &block), stats_blocks.end());
+    }
+};
+
+TSStatBlock *ts_stats_local() {
+    static thread_local TSStatHolder holder;
+    return &holder.block;
+}
+
+void ts_stats_snapshot(uint64_t values[TS_STAT_COUNT]) {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    for (int i = 0; i < TS_STAT_COUNT; ++i) {
+        values[i] = stats_retired[i];
+        for (TSStatBlock *block : stats_blocks) {
+            values[i] += block->values[i].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void ts_stats_reset() {
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        for (int i = 0; i < TS_STAT_COUNT; ++i) {
+            stats_retired[i] = 0;
+            for (TSStatBlock *block : stats_blocks) {
+                block->values[i].store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+    std::lock_guard<std::mutex> lock(trace_mutex);
+    trace_events.clear();
+}
+
+void ts_trace_record(const char *name, uint64_t start_nanos, uint64_t duration_nanos) {
+    std::lock_guard<std::mutex> lock(trace_mutex);
+    if (trace_events.size() < TRACE_EVENT_LIMIT) {
+        trace_events.push_back({name, start_nanos, duration_nanos, gettid()});
+    }
+}
+
+bool ts_trace_write(int fd) {
+    std::string json = "{\"traceEvents\":[";
+    char buffer[256];
+    {
+        std::lock_guard<std::mutex> lock(trace_mutex);
+        for (size_t i = 0; i < trace_events.size(); ++i) {
+            const TSTraceEvent &event = trace_events[i];
+            // the chrome trace event timestamps are microseconds
+            snprintf(buffer, sizeof buffer,
+                "%s{\"name\":\"%s\",\"cat\":\"treesitter\",\"ph\":\"X\","
+                "\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d}",
+                i == 0 ? "" : ",", event.name, event.start_nanos / 1000.0,
+                event.duration_nanos / 1000.0, getpid(), event.tid);
+            json += buffer;
+        }
+    }
+    json += "]}\n";
+
+    size_t written = 0;
+    while (written < json.size()) {
+        ssize_t result = write(fd, json.data() + written, json.size() - written);
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        written += static_cast<size_t>(result);
+    }
+    return true;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void JNICALL stats_native_set_enabled(JNIEnv *env, jobject thiz, jboolean value) {
+    ts_stats_enabled.store(value, std::memory_order_relaxed);
+}
+
+void JNICALL stats_native_snapshot(JNIEnv *env, jobject thiz, jlongArray values) {
+    uint64_t counters[TS_STAT_COUNT];
+    ts_stats_snapshot(counters);
+    jsize length = std::min<jsize>(env->GetArrayLength(values), TS_STAT_COUNT);
+    env->SetLongArrayRegion(values, 0, length, reinterpret_cast<const jlong*>(counters));
+}
+
+void JNICALL stats_native_reset(JNIEnv *env, jobject thiz) {
+    ts_stats_reset();
+}
+
+jboolean JNICALL stats_dump_trace(JNIEnv *env, jobject thiz, jstring pathname) {
+#ifdef __ANDROID__
+    // the spans are written to atrace, capture them by perfetto or systrace
+    return JNI_FALSE;
+#else
+    const char *path = env->GetStringUTFChars(pathname, nullptr);
+    int fd = open(path, O_CREAT|O_TRUNC|O_WRONLY, 0666);
+    env->ReleaseStringUTFChars(pathname, path);
+    if (fd < 0) {
+        LOGE("Error: %s\n", strerror(errno));
+        return JNI_FALSE;
+    }
+    bool result = ts_trace_write(fd);
+    close(fd);
+    return result ? JNI_TRUE : JNI_FALSE;
+#endif
+}
+
+extern const JNINativeMethod TSStats_methods[] = {
+    {"nativeSetEnabled", "(Z)V", (void *)&stats_native_set_enabled},
+    {"nativeSnapshot", "([J)V", (void *)&stats_native_snapshot},
+    {"nativeReset", "()V", (void *)&stats_native_reset},
+    {"dumpTrace", "(Ljava/lang/String;)Z", (void *)&stats_dump_trace}
+};
+
+extern const size_t TSStats_methods_size = sizeof TSStats_methods / sizeof(JNINativeMethod);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
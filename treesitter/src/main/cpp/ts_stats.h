@@ -0,0 +1,118 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __TS_STATS_H__
+#define __TS_STATS_H__
+
+#include <stdint.h>
+#include <time.h>
+
+#include <atomic>
+
+#ifdef __ANDROID__
+#include <android/trace.h>
+#endif
+
+// the native counters, keep the same order as the TSStats.kt
+enum TSStatCounter {
+    TS_STAT_PARSE_COUNT,
+    TS_STAT_PARSE_NANOS,
+    TS_STAT_BYTES_READ,
+    TS_STAT_REPARSE_COUNT,
+    TS_STAT_REPARSE_BYTES,
+    TS_STAT_REPARSE_CHANGED_BYTES,
+    TS_STAT_QUERY_COUNT,
+    TS_STAT_QUERY_NANOS,
+    TS_STAT_QUERY_MATCHES,
+    TS_STAT_QUERY_CAPTURES,
+    TS_STAT_JNI_OBJECTS,
+    TS_STAT_COUNT
+};
+
+// the counters of a thread, only the owner thread writes them
+struct TSStatBlock {
+    std::atomic<uint64_t> values[TS_STAT_COUNT];
+};
+
+// the stats are disabled by default, see TSStats.isEnabled
+extern std::atomic<bool> ts_stats_enabled;
+
+// get the counters of the current thread, registered on the first use
+extern TSStatBlock *ts_stats_local();
+
+// sum the counters of all the threads
+extern void ts_stats_snapshot(uint64_t values[TS_STAT_COUNT]);
+
+extern void ts_stats_reset();
+
+// record a complete trace event, only used off android
+extern void ts_trace_record(const char *name, uint64_t start_nanos, uint64_t duration_nanos);
+
+// write the recorded trace events as chrome trace event json
+extern bool ts_trace_write(int fd);
+
+static inline bool ts_stats_is_enabled() {
+    return __builtin_expect(ts_stats_enabled.load(std::memory_order_relaxed), false);
+}
+
+static inline void ts_stats_add(TSStatCounter counter, uint64_t value) {
+    if (ts_stats_is_enabled()) {
+        // uncontended, the block is owned by the current thread
+        ts_stats_local()->values[counter].fetch_add(value, std::memory_order_relaxed);
+    }
+}
+
+static inline uint64_t ts_stats_now_nanos() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+}
+
+// measure the scope time into the counter, the scope is also traced
+// as a span named `name` unless the name is null
+class TSTraceSpan {
+public:
+    TSTraceSpan(const char *name, TSStatCounter counter)
+        : name_(name), counter_(counter), start_(0) {
+        if (ts_stats_is_enabled()) {
+            start_ = ts_stats_now_nanos();
+#ifdef __ANDROID__
+            if (name_ != nullptr) ATrace_beginSection(name_);
+#endif
+        }
+    }
+
+    ~TSTraceSpan() {
+        if (start_ == 0) return;
+        uint64_t duration = ts_stats_now_nanos() - start_;
+        ts_stats_local()->values[counter_].fetch_add(duration, std::memory_order_relaxed);
+#ifdef __ANDROID__
+        if (name_ != nullptr) ATrace_endSection();
+#else
+        if (name_ != nullptr) ts_trace_record(name_, start_, duration);
+#endif
+    }
+
+    TSTraceSpan(const TSTraceSpan&) = delete;
+    TSTraceSpan &operator=(const TSTraceSpan&) = delete;
+
+private:
+    const char *name_;
+    TSStatCounter counter_;
+    uint64_t start_;
+};
+
+#endif // __TS_STATS_H__
@@ -0,0 +1,157 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __TS_STRING_TABLE_H__
+#define __TS_STRING_TABLE_H__
+
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include <jni.h>
+#include <tree_sitter/api.h>
+
+// the number of the languages that can be interned, the rest fall back to NewStringUTF
+#define TS_STRING_TABLE_LANGUAGES 64
+
+// the interned java strings of the symbol names and the field names of a language,
+// the names of a language are fixed, so a name is created once as a global reference
+// when it is first used, then every call returns a new local reference to the same string
+class TSStringTable {
+public:
+    // get the table of the language, the table is created on first use and kept until
+    // the library is unloaded, the lookup scans the few languages without locking
+    static TSStringTable *of(const TSLanguage *language) {
+        size_t count = count_.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; ++i) {
+            if (languages_[i].load(std::memory_order_relaxed) == language)
+                return tables_[i].load(std::memory_order_relaxed);
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        count = count_.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < count; ++i) {
+            if (languages_[i].load(std::memory_order_relaxed) == language)
+                return tables_[i].load(std::memory_order_relaxed);
+        }
+        if (count == TS_STRING_TABLE_LANGUAGES) return nullptr;
+        TSStringTable *table = new TSStringTable(language);
+        languages_[count].store(language, std::memory_order_relaxed);
+        tables_[count].store(table, std::memory_order_relaxed);
+        count_.store(count + 1, std::memory_order_release);
+        return table;
+    }
+
+    // the symbol name of the language, or a new string if the language is not interned
+    static jstring symbol_name(JNIEnv *env, const TSLanguage *language, TSSymbol symbol) {
+        TSStringTable *table = of(language);
+        if (table != nullptr) return table->symbol_name(env, symbol);
+        const char *name = ts_language_symbol_name(language, symbol);
+        return name ? env->NewStringUTF(name) : nullptr;
+    }
+
+    // the field name of the language, or a new string if the language is not interned
+    static jstring field_name(JNIEnv *env, const TSLanguage *language, TSFieldId id) {
+        TSStringTable *table = of(language);
+        if (table != nullptr) return table->field_name(env, id);
+        const char *name = ts_language_field_name_for_id(language, id);
+        return name ? env->NewStringUTF(name) : nullptr;
+    }
+
+    // the field name returned by the tree-sitter api, which has no field id variant
+    static jstring field_name(JNIEnv *env, const TSLanguage *language, const char *name) {
+        if (name == nullptr) return nullptr;
+        TSFieldId id = ts_language_field_id_for_name(language, name, static_cast<uint32_t>(strlen(name)));
+        return id != 0 ? field_name(env, language, id) : env->NewStringUTF(name);
+    }
+
+    // delete the global references of all the tables, called by JNI_OnUnload
+    static void clear(JNIEnv *env) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t count = count_.exchange(0, std::memory_order_acq_rel);
+        for (size_t i = 0; i < count; ++i) {
+            TSStringTable *table = tables_[i].exchange(nullptr, std::memory_order_relaxed);
+            table->release(env);
+            delete table;
+            languages_[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    // the ERROR symbol has its own slot after the symbols of the grammar
+    jstring symbol_name(JNIEnv *env, TSSymbol symbol) {
+        uint32_t slot = symbol == static_cast<TSSymbol>(-1) ? symbol_count_ : symbol;
+        const char *name = ts_language_symbol_name(language_, symbol);
+        if (name == nullptr) return nullptr;
+        if (slot > symbol_count_) return env->NewStringUTF(name);
+        return intern(env, symbols_[slot], name);
+    }
+
+    // the field ids start at 1, 0 is no field
+    jstring field_name(JNIEnv *env, TSFieldId id) {
+        if (id == 0 || id > field_count_) return nullptr;
+        const char *name = ts_language_field_name_for_id(language_, id);
+        return name ? intern(env, fields_[id], name) : nullptr;
+    }
+
+private:
+    explicit TSStringTable(const TSLanguage *language)
+        : language_(language),
+          symbol_count_(ts_language_symbol_count(language)),
+          field_count_(ts_language_field_count(language)),
+          symbols_(new std::atomic<jstring>[symbol_count_ + 1]()),
+          fields_(new std::atomic<jstring>[field_count_ + 1]()) {}
+
+    // create the global string of the slot once, the thread losing the race drops its copy
+    static jstring intern(JNIEnv *env, std::atomic<jstring> &slot, const char *name) {
+        jstring string = slot.load(std::memory_order_acquire);
+        if (string == nullptr) {
+            jstring local = env->NewStringUTF(name);
+            if (local == nullptr) return nullptr;
+            jstring global = static_cast<jstring>(env->NewGlobalRef(local));
+            env->DeleteLocalRef(local);
+            if (slot.compare_exchange_strong(string, global, std::memory_order_acq_rel)) {
+                string = global;
+            } else {
+                env->DeleteGlobalRef(global);
+            }
+        }
+        return static_cast<jstring>(env->NewLocalRef(string));
+    }
+
+    void release(JNIEnv *env) {
+        for (uint32_t i = 0; i <= symbol_count_; ++i) {
+            if (jstring string = symbols_[i].load(std::memory_order_relaxed)) env->DeleteGlobalRef(string);
+        }
+        for (uint32_t i = 0; i <= field_count_; ++i) {
+            if (jstring string = fields_[i].load(std::memory_order_relaxed)) env->DeleteGlobalRef(string);
+        }
+    }
+
+    const TSLanguage *language_;
+    uint32_t symbol_count_;
+    uint32_t field_count_;
+    std::unique_ptr<std::atomic<jstring>[]> symbols_;
+    std::unique_ptr<std::atomic<jstring>[]> fields_;
+
+    static inline std::mutex mutex_;
+    static inline std::atomic<size_t> count_{0};
+    static inline std::atomic<const TSLanguage*> languages_[TS_STRING_TABLE_LANGUAGES];
+    static inline std::atomic<TSStringTable*> tables_[TS_STRING_TABLE_LANGUAGES];
+};
+
+#endif // __TS_STRING_TABLE_H__
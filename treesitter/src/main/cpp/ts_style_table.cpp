@@ -0,0 +1,93 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ts_utils.h"
+#include "ts_style_table.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// compile the theme for the capture ids of the query, the keys
+// are the capture names and the values are the packed styles
+jlong JNICALL style_table_init(
+    JNIEnv *env, jclass clazz, jobject query, jobjectArray keys, jlongArray values
+) {
+    TSQuery *ts_query = GET_POINTER(TSQuery, query);
+    jsize count = env->GetArrayLength(keys);
+    if (count != env->GetArrayLength(values)) {
+        THROW(IllegalArgumentException, "The theme keys and values must have the same size");
+        return 0;
+    }
+
+    std::vector<jlong> styles(count);
+    env->GetLongArrayRegion(values, 0, count, styles.data());
+    std::unordered_map<std::string, uint64_t> theme;
+    theme.reserve(count);
+    for (jsize i = 0; i < count; ++i) {
+        jstring key = static_cast<jstring>(env->GetObjectArrayElement(keys, i));
+        const char *chars = env->GetStringUTFChars(key, nullptr);
+        theme[std::string(chars, env->GetStringUTFLength(key))] = static_cast<uint64_t>(styles[i]);
+        env->ReleaseStringUTFChars(key, chars);
+        env->DeleteLocalRef(key);
+    }
+    return reinterpret_cast<jlong>(new TSStyleTable(ts_query, theme));
+}
+
+void JNICALL style_table_delete CRITICAL_ARGS(jlong table) {
+    delete reinterpret_cast<TSStyleTable*>(table);
+}
+
+jlong JNICALL style_table_get CRITICAL_ARGS(jlong table, jint id) {
+    TSStyleTable *self = reinterpret_cast<TSStyleTable*>(table);
+    return static_cast<jlong>(self->get(static_cast<uint32_t>(id)));
+}
+
+jint JNICALL style_table_get_size(JNIEnv *env, jobject thiz) {
+    TSStyleTable *self = GET_POINTER(TSStyleTable, thiz);
+    return static_cast<jint>(self->size());
+}
+
+// the style runs [start, end, id] of the captures over the range [start, end)
+jintArray JNICALL style_table_resolve_runs(
+    JNIEnv *env, jobject thiz, jintArray captures, jint count, jint start, jint end
+) {
+    TSStyleTable *self = GET_POINTER(TSStyleTable, thiz);
+    if (count < 0 || count > env->GetArrayLength(captures) / TS_STYLE_RUN_STRIDE) {
+        THROW(IllegalArgumentException, "The capture count exceeds the captures array");
+        return nullptr;
+    }
+    std::vector<jint> values(count * TS_STYLE_RUN_STRIDE);
+    env->GetIntArrayRegion(captures, 0, count * TS_STYLE_RUN_STRIDE, values.data());
+    std::vector<int32_t> runs = self->resolve_runs(values.data(), static_cast<size_t>(count), start, end);
+    jintArray result = env->NewIntArray(static_cast<jsize>(runs.size()));
+    env->SetIntArrayRegion(result, 0, static_cast<jsize>(runs.size()), runs.data());
+    return result;
+}
+
+extern const JNINativeMethod TSStyleTable_methods[] = {
+    {"init", "(L" PACKAGE "TSQuery;[Ljava/lang/String;[J)J", (void *)&style_table_init},
+    {"delete", "(J)V", (void *)&style_table_delete},
+    {"get", "(JI)J", (void *)&style_table_get},
+    {"getSize", "()I", (void *)&style_table_get_size},
+    {"resolveRuns", "([IIII)[I", (void *)&style_table_resolve_runs},
+};
+
+extern const size_t TSStyleTable_methods_size = sizeof TSStyleTable_methods / sizeof(JNINativeMethod);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
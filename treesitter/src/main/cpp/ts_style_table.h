@@ -0,0 +1,127 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __TS_STYLE_TABLE_H__
+#define __TS_STYLE_TABLE_H__
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <tree_sitter/api.h>
+
+// the packed style of a capture, keep the same layout as TSStyleTable.kt
+// bits [0, 32) the foreground ARGB, 0 is no foreground
+// bits [32, 56) the background RGB, bits [56, 60) the background alpha / 17,
+// the alpha 0 is no background, bit 60 bold, 61 italic, 62 underline, 63 strikethrough
+#define TS_STYLE_NONE 0ULL
+
+// the number of jint values of a capture or a run, [start, end, capture id]
+#define TS_STYLE_RUN_STRIDE 3
+
+// paint the captures [start, end, id] in order over the range [start, end), so that
+// the later capture, which is the inner node, wins, then merge the same styles to runs,
+// the painting is over the spans between the capture bounds rather than the columns,
+// so that a long line costs no more than the captures on it. The style of an id is
+// given by the style function, the captures without a style are skipped
+template <typename Style>
+std::vector<int32_t> ts_style_resolve_runs(
+    const int32_t *captures, size_t count, int32_t start, int32_t end, Style style
+) {
+    std::vector<int32_t> runs;
+    if (end <= start) return runs;
+
+    std::vector<int32_t> bounds {start, end};
+    for (size_t i = 0; i < count * TS_STYLE_RUN_STRIDE; i += TS_STYLE_RUN_STRIDE) {
+        if (style(captures[i + 2]) == TS_STYLE_NONE) continue;
+        int32_t from = std::max(captures[i], start), to = std::min(captures[i + 1], end);
+        if (from < to) {
+            bounds.push_back(from);
+            bounds.push_back(to);
+        }
+    }
+    std::sort(bounds.begin(), bounds.end());
+    bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+
+    // the owner of the span [bounds[k], bounds[k + 1])
+    std::vector<int32_t> owners(bounds.size() - 1, -1);
+    for (size_t i = 0; i < count * TS_STYLE_RUN_STRIDE; i += TS_STYLE_RUN_STRIDE) {
+        int32_t id = captures[i + 2];
+        if (style(id) == TS_STYLE_NONE) continue;
+        int32_t from = std::max(captures[i], start), to = std::min(captures[i + 1], end);
+        if (from >= to) continue;
+        auto first = std::lower_bound(bounds.begin(), bounds.end(), from) - bounds.begin();
+        auto last = std::lower_bound(bounds.begin(), bounds.end(), to) - bounds.begin();
+        std::fill(owners.begin() + first, owners.begin() + last, id);
+    }
+
+    size_t length = owners.size();
+    for (size_t i = 0, j; i < length; i = j) {
+        uint64_t value = owners[i] < 0 ? TS_STYLE_NONE : style(owners[i]);
+        for (j = i + 1; j < length; ++j) {
+            uint64_t next = owners[j] < 0 ? TS_STYLE_NONE : style(owners[j]);
+            if (next != value) break;
+        }
+        runs.push_back(bounds[i]);
+        runs.push_back(bounds[j]);
+        runs.push_back(owners[i]);
+    }
+    return runs;
+}
+
+// the styles of a theme compiled for the capture ids of a query, a capture name without
+// a style falls back to its parent name, like function.method to function
+class TSStyleTable {
+public:
+    TSStyleTable(const TSQuery *query, const std::unordered_map<std::string, uint64_t> &theme) {
+        uint32_t count = ts_query_capture_count(query);
+        styles_.resize(count, TS_STYLE_NONE);
+        for (uint32_t id = 0; id < count; ++id) {
+            uint32_t length;
+            const char *name = ts_query_capture_name_for_id(query, id, &length);
+            if (name != nullptr) styles_[id] = resolve(std::string(name, length), theme);
+        }
+    }
+
+    uint64_t get(uint32_t id) const { return id < styles_.size() ? styles_[id] : TS_STYLE_NONE; }
+
+    uint32_t size() const { return static_cast<uint32_t>(styles_.size()); }
+
+    // the style runs [start, end, id] of the captures, see ts_style_resolve_runs
+    std::vector<int32_t> resolve_runs(const int32_t *captures, size_t count, int32_t start, int32_t end) const {
+        return ts_style_resolve_runs(captures, count, start, end, [this](int32_t id) {
+            return get(static_cast<uint32_t>(id));
+        });
+    }
+
+private:
+    static uint64_t resolve(std::string name, const std::unordered_map<std::string, uint64_t> &theme) {
+        while (true) {
+            auto it = theme.find(name);
+            if (it != theme.end()) return it->second;
+            size_t dot = name.rfind('.');
+            if (dot == std::string::npos) return TS_STYLE_NONE;
+            name.resize(dot);
+        }
+    }
+
+    std::vector<uint64_t> styles_;
+};
+
+#endif // __TS_STYLE_TABLE_H__
@@ -25,13 +25,13 @@
 extern "C" {
 #endif
 
-jlong JNICALL tree_copy(jlong tree) { 
+jlong JNICALL tree_copy CRITICAL_ARGS(jlong tree) { 
     return reinterpret_cast<jlong>(
         ts_tree_copy(reinterpret_cast<TSTree*>(tree))
     );
 }
 
-void JNICALL tree_delete(jlong tree) { 
+void JNICALL tree_delete CRITICAL_ARGS(jlong tree) { 
     ts_tree_delete(reinterpret_cast<TSTree*>(tree)); 
 }
 
@@ -59,6 +59,23 @@ void JNICALL tree_edit(JNIEnv *env, jobject thiz, jobject edit) {
     ts_tree_edit(self, &input_edit);
 }
 
+void JNICALL tree_edit_all(JNIEnv *env, jobject thiz, jintArray edits) {
+    TSTree *self = GET_POINTER(TSTree, thiz);
+    jsize length = env->GetArrayLength(edits);
+    if (length % INPUT_EDIT_STRIDE != 0) {
+        THROW(IllegalArgumentException, "The packed edits length must be a multiple of 9");
+        return;
+    }
+    // note here no JNI calls are allowed until the array is released
+    jint *values = static_cast<jint*>(env->GetPrimitiveArrayCritical(edits, nullptr));
+    for (jsize i = 0; i < length; i += INPUT_EDIT_STRIDE) {
+        TSInputEdit input_edit = unpack_input_edit(values + i);
+        // edit the syntax tree in order
+        ts_tree_edit(self, &input_edit);
+    }
+    env->ReleasePrimitiveArrayCritical(edits, values, JNI_ABORT);
+}
+
 jobject JNICALL tree_changed_ranges(JNIEnv *env, jobject thiz, jobject newTree) {
     uint32_t length;
     TSTree *old_tree = GET_POINTER(TSTree, thiz);
@@ -115,6 +132,7 @@ extern const JNINativeMethod TSTree_methods[] = {
     {"rootNodeWithOffset", "(IL" PACKAGE "TSPoint;)L" PACKAGE "TSNode;",
      (void *)&tree_root_node_with_offset},
     {"edit", "(L" PACKAGE "TSInputEdit;)V", (void *)&tree_edit},
+    {"editAll", "([I)V", (void *)&tree_edit_all},
     {"changedRanges", "(L" PACKAGE "TSTree;)Ljava/util/List;", (void *)&tree_changed_ranges},
     {"includedRanges", "()Ljava/util/List;", (void *)&tree_included_ranges},
     {"dotGraph", "(Ljava/lang/String;)V", (void *)&tree_dot_graph}
@@ -15,6 +15,7 @@
  */
 
 #include "ts_utils.h"
+#include "ts_string_table.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -28,7 +29,7 @@ jlong JNICALL tree_cursor_init(JNIEnv *env, jclass clazz, jobject node) {
     );
 }
 
-jlong JNICALL tree_cursor_copy(jlong cursor) {
+jlong JNICALL tree_cursor_copy CRITICAL_ARGS(jlong cursor) {
     TSTreeCursor copy = ts_tree_cursor_copy(
         reinterpret_cast<TSTreeCursor*>(cursor)
     );
@@ -36,7 +37,7 @@ jlong JNICALL tree_cursor_copy(jlong cursor) {
     return reinterpret_cast<jlong>(new TSTreeCursor(copy));
 }
 
-void JNICALL tree_cursor_delete(jlong cursor) {
+void JNICALL tree_cursor_delete CRITICAL_ARGS(jlong cursor) {
     ts_tree_cursor_delete(reinterpret_cast<TSTreeCursor*>(cursor));
     delete reinterpret_cast<TSTreeCursor*>(cursor);
 }
@@ -60,8 +61,9 @@ jshort JNICALL tree_cursor_get_current_field_id(JNIEnv *env, jobject thiz) {
 
 jstring JNICALL tree_cursor_get_current_field_name(JNIEnv *env, jobject thiz) {
     TSTreeCursor *self = GET_POINTER(TSTreeCursor, thiz);
-    const char *name = ts_tree_cursor_current_field_name(self);
-    return name ? env->NewStringUTF(name) : nullptr;
+    TSFieldId field_id = ts_tree_cursor_current_field_id(self);
+    TSNode node = ts_tree_cursor_current_node(self);
+    return TSStringTable::field_name(env, ts_tree_language(node.tree), field_id);
 }
 
 jint JNICALL tree_cursor_get_current_descendant_index(JNIEnv *env, jobject thiz) {
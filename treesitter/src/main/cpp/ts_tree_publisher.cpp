@@ -0,0 +1,111 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ts_utils.h"
+#include "ts_epoch_publisher.h"
+
+// the published values are the global references of the java TSTreeSnapshot
+typedef TSEpochPublisher<jobject> TSTreePublisher;
+
+// close the snapshot that no reader can see, and release the global reference
+static void release_snapshot(JNIEnv *env, TSPublished<jobject> *entry) {
+    CALL_METHOD_NO_ARGS(Void, entry->value, TSTreeSnapshot_close);
+    if (env->ExceptionCheck()) {
+        LOGE("Failed to close the snapshot of generation %lld\n", (long long)entry->generation);
+        env->ExceptionClear();
+    }
+    env->DeleteGlobalRef(entry->value);
+    delete entry;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+jlong JNICALL tree_publisher_init CRITICAL_ARGS() {
+    return reinterpret_cast<jlong>(new TSTreePublisher());
+}
+
+void JNICALL tree_publisher_delete(JNIEnv *env, jclass clazz, jlong publisher) {
+    TSTreePublisher *self = reinterpret_cast<TSTreePublisher*>(publisher);
+    self->clear([env](TSPublished<jobject> *entry) { release_snapshot(env, entry); });
+    delete self;
+}
+
+void JNICALL tree_publisher_native_publish(
+    JNIEnv *env, jobject thiz, jobject snapshot, jlong generation
+) {
+    TSTreePublisher *self = GET_POINTER(TSTreePublisher, thiz);
+    auto *entry = new TSPublished<jobject> {env->NewGlobalRef(snapshot), generation};
+    self->publish(entry, [env](TSPublished<jobject> *retired) { release_snapshot(env, retired); });
+}
+
+jint JNICALL tree_publisher_pin(JNIEnv *env, jobject thiz) {
+    TSTreePublisher *self = GET_POINTER(TSTreePublisher, thiz);
+    int slot = self->pin();
+    if (slot < 0) {
+        THROW(IllegalStateException, "Too many readers of the tree publisher");
+    }
+    return static_cast<jint>(slot);
+}
+
+// the local reference is only valid until the slot is unpinned
+jobject JNICALL tree_publisher_current(JNIEnv *env, jobject thiz) {
+    TSTreePublisher *self = GET_POINTER(TSTreePublisher, thiz);
+    const TSPublished<jobject> *entry = self->current();
+    return entry ? env->NewLocalRef(entry->value) : nullptr;
+}
+
+void JNICALL tree_publisher_unpin(JNIEnv *env, jobject thiz, jint slot) {
+    TSTreePublisher *self = GET_POINTER(TSTreePublisher, thiz);
+    self->unpin(static_cast<int>(slot));
+    self->try_reclaim([env](TSPublished<jobject> *retired) { release_snapshot(env, retired); });
+}
+
+jlong JNICALL tree_publisher_get_generation(JNIEnv *env, jobject thiz) {
+    TSTreePublisher *self = GET_POINTER(TSTreePublisher, thiz);
+    int slot = self->pin();
+    if (slot < 0) {
+        THROW(IllegalStateException, "Too many readers of the tree publisher");
+        return -1;
+    }
+    const TSPublished<jobject> *entry = self->current();
+    jlong generation = entry ? entry->generation : -1;
+    self->unpin(slot);
+    return generation;
+}
+
+jint JNICALL tree_publisher_get_retired_count(JNIEnv *env, jobject thiz) {
+    TSTreePublisher *self = GET_POINTER(TSTreePublisher, thiz);
+    return static_cast<jint>(self->retired_count());
+}
+
+extern const JNINativeMethod TSTreePublisher_methods[] = {
+    {"init", "()J", (void *)&tree_publisher_init},
+    {"delete", "(J)V", (void *)&tree_publisher_delete},
+    {"nativePublish", "(L" PACKAGE "TSTreeSnapshot;J)V", (void *)&tree_publisher_native_publish},
+    {"pin", "()I", (void *)&tree_publisher_pin},
+    {"current", "()L" PACKAGE "TSTreeSnapshot;", (void *)&tree_publisher_current},
+    {"unpin", "(I)V", (void *)&tree_publisher_unpin},
+    {"getGeneration", "()J", (void *)&tree_publisher_get_generation},
+    {"getRetiredCount", "()I", (void *)&tree_publisher_get_retired_count},
+};
+
+extern const size_t TSTreePublisher_methods_size = sizeof TSTreePublisher_methods / sizeof(JNINativeMethod);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
@@ -20,6 +20,7 @@
 #include <tree_sitter/api.h>
 
 #include "jni_helper.h"
+#include "ts_stats.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -49,11 +50,13 @@ extern "C" {
     env->_cat3(Call, jtype, Method)((object), global_method_cache.method)
 
 #define NEW_OBJECT(clazz, ...)                                                               \
-    env->NewObject(global_class_cache.clazz, global_method_cache._cat2(clazz, init),       \
-                      __VA_ARGS__)
+    (ts_stats_add(TS_STAT_JNI_OBJECTS, 1),                                                 \
+     env->NewObject(global_class_cache.clazz, global_method_cache._cat2(clazz, init),      \
+                      __VA_ARGS__))
 
 #define NEW_OBJECT_NO_ARGS(clazz)                                                       \
-    env->NewObject(global_class_cache.clazz, global_method_cache._cat2(clazz, init))
+    (ts_stats_add(TS_STAT_JNI_OBJECTS, 1),                                                 \
+     env->NewObject(global_class_cache.clazz, global_method_cache._cat2(clazz, init)))
                       
 #define THROW(clazz, message) env->ThrowNew(global_class_cache.clazz, message)
 
@@ -71,6 +74,15 @@ typedef struct {
     jclass TSTree;
     jclass TSTreeCursor;
     jclass TSQuery;
+    jclass TSQueryCursor;
+    jclass TSTreeSnapshot;
+    jclass TSTreePublisher;
+    jclass TSStyleTable;
+    jclass TSDiagnostics;
+    jclass TSLocals;
+    jclass TSContextStack;
+    jclass TSCompletion;
+    jclass TSSelection;
     jclass TSRange;
     
     jclass TSInputEdit;
@@ -85,6 +97,8 @@ typedef struct {
     jclass TSQueryMatch;
     jclass TSQueryPredicateStep;
     jclass TSQueryPredicateStepType;
+    jclass TSStats;
+    jclass TSOffsetIndex;
     
     jclass TSQueryError$Capture;
     jclass TSQueryError$Field;
@@ -100,6 +114,7 @@ typedef struct {
     jclass IllegalStateException;
     jclass IllegalArgumentException;
     jclass IndexOutOfBoundsException;
+    jclass IOException;
 } JClassCache;
 
 typedef struct {
@@ -121,6 +136,7 @@ typedef struct {
     jfieldID TSParser_timeoutMicros;
     jfieldID TSParser_includedRanges;
     jfieldID TSParser_isCancelled;
+    jfieldID TSParser_logCapacity;
     
     jfieldID TSPoint_row;
     jfieldID TSPoint_column;   
@@ -137,6 +153,7 @@ typedef struct {
     jfieldID TSSymbolType_ANONYMOUS;
     jfieldID TSSymbolType_AUXILIARY;
     
+    jfieldID TSOffsetIndex_self;
     jfieldID TSTree_self;
     jfieldID TSTree_source;
     jfieldID TSTree_language;
@@ -153,6 +170,15 @@ typedef struct {
     jfieldID TSQuery_captureNames;
     jfieldID TSQuery_timeoutMicros;
     
+    jfieldID TSQueryCursor_self;
+    jfieldID TSTreePublisher_self;
+    jfieldID TSStyleTable_self;
+    jfieldID TSDiagnostics_self;
+    jfieldID TSLocals_self;
+    jfieldID TSContextStack_self;
+    jfieldID TSCompletion_self;
+    jfieldID TSSelection_self;
+    
     jfieldID TSLookaheadIterator_self;
     jfieldID UInt_data;
 } JFieldCache;
@@ -173,6 +199,7 @@ typedef struct {
     
     jmethodID TSQueryMatch_init;
     jmethodID TSQueryCapture_init;
+    jmethodID TSTreeSnapshot_close;
     
     jmethodID List_get;
     jmethodID List_size;
@@ -194,6 +221,7 @@ static inline jobject marshal_node(
    JNIEnv *env, const TSNode *node, jobject tree
 ) {
     jintArray int_array = env->NewIntArray(4);
+    ts_stats_add(TS_STAT_JNI_OBJECTS, 1);
     env->SetIntArrayRegion(int_array, 0, 4, (jint*)node->context);
     jlong id = reinterpret_cast<jlong>(node->id);
     return NEW_OBJECT(TSNode, int_array, id, tree);
@@ -290,6 +318,71 @@ static inline TSInputEdit unmarshal_input_edit(JNIEnv *env, jobject edit) {
     };
 }
 
+// the number of jint values of a packed TSInputEdit
+#define INPUT_EDIT_STRIDE 9
+
+// get the native TSInputEdit from the packed values
+// [startByte, oldEndByte, newEndByte, startRow, startColumn,
+//  oldEndRow, oldEndColumn, newEndRow, newEndColumn]
+static inline TSInputEdit unpack_input_edit(const jint *values) {
+    return TSInputEdit {
+        .start_byte = static_cast<uint32_t>(values[0]),
+        .old_end_byte = static_cast<uint32_t>(values[1]),
+        .new_end_byte = static_cast<uint32_t>(values[2]),
+        .start_point = {
+            static_cast<uint32_t>(values[3]), static_cast<uint32_t>(values[4])
+        },
+        .old_end_point = {
+            static_cast<uint32_t>(values[5]), static_cast<uint32_t>(values[6])
+        },
+        .new_end_point = {
+            static_cast<uint32_t>(values[7]), static_cast<uint32_t>(values[8])
+        }
+    };
+}
+
+// the number of jint values of a node packed by TSNode.findDescendants
+// [startByte, startRow, startColumn, alias, idLow, idHigh, endByte, endRow, endColumn, symbol]
+// the first 4 values are the node context, same as marshal_node
+#define NODE_DESCENDANT_STRIDE 10
+
+// get the java TSQueryMatch object, the capture names are the TSQuery.captureNames list
+static inline jobject marshal_query_match(
+    JNIEnv *env, const TSQueryMatch *match, jobject capture_names, jobject tree
+) {
+    jobject captures = NEW_OBJECT(ArrayList, (jint)match->capture_count);
+    for (uint16_t i = 0; i < match->capture_count; ++i) {
+        TSQueryCapture capture = match->captures[i];
+        jobject node = marshal_node(env, &capture.node, tree);
+        jobject name = CALL_METHOD(Object, capture_names, List_get, capture.index);
+        if (env->ExceptionCheck())
+            return nullptr;
+
+        jobject capture_object = NEW_OBJECT(TSQueryCapture, node, name, (jint)capture.index);
+        CALL_METHOD(Boolean, captures, ArrayList_add, capture_object);
+        env->DeleteLocalRef(capture_object);
+        env->DeleteLocalRef(node);
+        env->DeleteLocalRef(name);
+        if (env->ExceptionCheck())
+            return nullptr;
+    }
+    return NEW_OBJECT(TSQueryMatch, (jint)match->pattern_index, captures);
+}
+
+// get the java Pair<UInt, TSQueryMatch> object of a capture
+static inline jobject marshal_query_capture(
+    JNIEnv *env, const TSQueryMatch *match, uint32_t capture_index,
+    jobject capture_names, jobject tree
+) {
+    jobject match_object = marshal_query_match(env, match, capture_names, tree);
+    if (match_object == nullptr)
+        return nullptr;
+    jobject index = env->AllocObject(global_class_cache.UInt);
+    ts_stats_add(TS_STAT_JNI_OBJECTS, 1);
+    env->SetIntField(index, global_field_cache.UInt_data, (jint)capture_index);
+    return NEW_OBJECT(Pair, index, match_object);
+}
+
 #ifdef __cplusplus
 }
 #endif // __cplusplus
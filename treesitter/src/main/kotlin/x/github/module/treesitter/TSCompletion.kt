@@ -0,0 +1,122 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package x.github.module.treesitter
+
+import dalvik.annotation.optimization.CriticalNative
+import dalvik.annotation.optimization.FastNative
+import java.lang.ref.Cleaner
+
+/**
+ * The completions of the word being typed, the keywords which the grammar accepts
+ * after the previous token merged with the identifiers of the document.
+ *
+ * The keywords are the named-like anonymous symbols of the [TSLookaheadIterator] of the
+ * parse state after the previous token, so only the keywords valid at the position are
+ * offered. The identifiers are the leaves of the given symbol [identifiers] types, kept
+ * in a trie with the number of their occurrences, and the identifiers are only offered if
+ * the state accepts one of the types. The trie is split by the children of the root,
+ * [update] only harvests the children changed by the edits again.
+ *
+ * A keyword ranks as [KEYWORD_SCORE] occurrences, then shorter words rank first.
+ *
+ * __NOTE:__ If you're targeting Android SDK level < 33,
+ * you must `use` or [close] the instance to free up resources.
+ *
+ * #### Example
+ *
+ * ```kotlin
+ * val completion = TSCompletion(shortArrayOf(identifierSymbol))
+ * // after every parse
+ * completion.update(tree, oldTree, index)
+ * val result = completion.complete(tree, index, cursorByte)
+ * replace(result.prefixStart, cursorByte, result.words[0])
+ * ```
+ *
+ * @constructor Create the completion of the identifier symbol [identifiers].
+ */
+class TSCompletion private constructor(private val self: Long) : AutoCloseable {
+
+    constructor(identifiers: ShortArray) : this(init(identifiers))
+
+    private val cleaner: Cleaner.Cleanable?
+
+    init {
+        cleaner = RefCleaner(this, CleanAction(self))
+    }
+
+    /**
+     * The completions, the [words] ranked best first, their [kinds] one of
+     * [KEYWORD] or [IDENTIFIER], and the UTF-8 [prefixStart] of the word being
+     * typed, which is replaced by the chosen word.
+     */
+    class Result(val words: Array<String>, val kinds: IntArray, val prefixStart: Int) {
+        val size: Int get() = words.size
+    }
+
+    /**
+     * Harvest the identifiers of the [tree] parsed from the [index]. The [oldTree] is the
+     * [edited][TSTree.edit] tree passed to the last update, the whole tree is harvested
+     * if it's `null` or another tree.
+     */
+    fun update(tree: TSTree, oldTree: TSTree?, index: TSOffsetIndex) = nativeUpdate(tree, oldTree, index)
+
+    /**
+     * Get at most [maxResults] completions of the word before the UTF-8 [byte]
+     * of the [tree] parsed from the [index], the word itself is not offered.
+     */
+    @JvmOverloads
+    fun complete(tree: TSTree, index: TSOffsetIndex, byte: Int, maxResults: Int = 32): Result {
+        val info = IntArray(maxResults.coerceAtLeast(0) + 1)
+        val words = nativeComplete(tree, index, byte, info)
+        return Result(words, info.copyOf(words.size), info[info.size - 1])
+    }
+
+    /** Forget the identifiers, so the next [update] harvests the whole tree. */
+    @FastNative
+    external fun reset()
+
+    override fun close() {
+        cleaner?.let { it.clean() } ?: run { delete(self) }
+    }
+
+    private external fun nativeUpdate(tree: TSTree, oldTree: TSTree?, index: TSOffsetIndex)
+
+    private external fun nativeComplete(tree: TSTree, index: TSOffsetIndex, byte: Int, info: IntArray): Array<String>
+
+    private class CleanAction(private val completion: Long) : Runnable {
+        override fun run() = delete(completion)
+    }
+
+    companion object {
+        /** The kind of a keyword of the grammar. */
+        const val KEYWORD = 0
+
+        /** The kind of an identifier of the document. */
+        const val IDENTIFIER = 1
+
+        /** The score of a keyword, an identifier scores the number of its occurrences. */
+        const val KEYWORD_SCORE = 3
+
+        @JvmStatic
+        @FastNative
+        private external fun init(identifiers: ShortArray): Long
+
+        @JvmStatic
+        @CriticalNative
+        private external fun delete(completion: Long)
+    }
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package x.github.module.treesitter
+
+import dalvik.annotation.optimization.CriticalNative
+import dalvik.annotation.optimization.FastNative
+import java.lang.ref.Cleaner
+
+/**
+ * The chain of the enclosing scope nodes at a byte, like the class and the function
+ * of the first visible line for a sticky header or a breadcrumb.
+ *
+ * The scope nodes are the given symbol [types]. The chain of the last byte is kept,
+ * so the next byte of the same tree only pops the levels which don't contain it
+ * and descends from the innermost level which does, no [TSNode] is created.
+ * The chain is walked again from the root when another tree is given.
+ *
+ * __NOTE:__ If you're targeting Android SDK level < 33,
+ * you must `use` or [close] the instance to free up resources.
+ *
+ * #### Example
+ *
+ * ```kotlin
+ * val stack = TSContextStack(shortArrayOf(classSymbol, functionSymbol))
+ * // on every scroll frame
+ * val levels = stack.at(tree, topLineByte)
+ * for (i in levels.indices step TSContextStack.STRIDE) {
+ *     drawHeader(levels[i + 1], levels[i + 4], levels[i + 5])
+ * }
+ * ```
+ *
+ * @constructor Create the stack of the scope symbol [types].
+ */
+class TSContextStack private constructor(private val self: Long) : AutoCloseable {
+
+    constructor(types: ShortArray) : this(init(types))
+
+    private val cleaner: Cleaner.Cleanable?
+
+    init {
+        cleaner = RefCleaner(this, CleanAction(self))
+    }
+
+    /**
+     * Get the scope nodes enclosing the UTF-8 [byte] of the [tree], outermost first,
+     * at most [maxDepth] of the innermost ones, packed as `[symbol, startRow, startByte,
+     * endByte, nameStartByte, nameEndByte]`, see [STRIDE]. The name is the `name` field,
+     * or the innermost `declarator` field like a C function, `-1` if there is neither.
+     *
+     * [reset] the stack whenever the [tree] is [edited][TSTree.edit], the edit changes
+     * the same tree in place, so the cached nodes would keep the positions before it.
+     */
+    @JvmOverloads
+    fun at(tree: TSTree, byte: Int, maxDepth: Int = Int.MAX_VALUE): IntArray = nativeAt(tree, byte, maxDepth)
+
+    /** Forget the chain of the last byte. */
+    @FastNative
+    external fun reset()
+
+    override fun close() {
+        cleaner?.let { it.clean() } ?: run { delete(self) }
+    }
+
+    @FastNative
+    private external fun nativeAt(tree: TSTree, byte: Int, maxDepth: Int): IntArray
+
+    private class CleanAction(private val stack: Long) : Runnable {
+        override fun run() = delete(stack)
+    }
+
+    companion object {
+        /** The number of the values of a level packed by [at]. */
+        const val STRIDE = 6
+
+        @JvmStatic
+        @FastNative
+        private external fun init(types: ShortArray): Long
+
+        @JvmStatic
+        @CriticalNative
+        private external fun delete(stack: Long)
+    }
+}
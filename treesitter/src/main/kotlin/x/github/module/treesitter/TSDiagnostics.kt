@@ -0,0 +1,139 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package x.github.module.treesitter
+
+import dalvik.annotation.optimization.CriticalNative
+import dalvik.annotation.optimization.FastNative
+import java.lang.ref.Cleaner
+
+/**
+ * The syntax errors of a tree, the `ERROR` and `MISSING` nodes sorted by the start byte.
+ *
+ * The subtrees without an error are skipped by [TSNode.hasError], and an [update]
+ * with the old tree only scans the changed ranges again, the other diagnostics are
+ * moved to the new tree. The expected symbols of a diagnostic are only computed
+ * by [expectedSymbols], so the list stays cheap for a document full of errors.
+ *
+ * __NOTE:__ If you're targeting Android SDK level < 33,
+ * you must `use` or [close] the instance to free up resources.
+ *
+ * #### Example
+ *
+ * ```kotlin
+ * val diagnostics = TSDiagnostics()
+ * diagnostics.update(tree)
+ * // after editing the tree and parsing again
+ * diagnostics.update(newTree, tree)
+ * if (diagnostics.hasError(row)) drawGutterMark(row)
+ * ```
+ */
+class TSDiagnostics private constructor(private val self: Long) : AutoCloseable {
+
+    /** Create a new instance without any diagnostic. */
+    constructor() : this(init())
+
+    private val cleaner: Cleaner.Cleanable?
+
+    init {
+        cleaner = RefCleaner(this, CleanAction(self))
+    }
+
+    /** The number of the diagnostics. */
+    @get:JvmName("getSize")
+    val size: Int
+        @FastNative external get
+
+    /**
+     * Collect the diagnostics of the [tree].
+     *
+     * The [oldTree] is the tree of the last update, edited and then parsed
+     * to the [tree], so only its changed ranges are scanned. Without it,
+     * or if it's another tree, the whole [tree] is scanned.
+     */
+    @JvmOverloads
+    fun update(tree: TSTree, oldTree: TSTree? = null) = nativeUpdate(tree, oldTree)
+
+    /** Forget the diagnostics, so the next [update] scans the whole tree. */
+    @FastNative
+    external fun reset()
+
+    /**
+     * Get the diagnostics packed as `[startByte, endByte, startRow, startColumn,
+     * endRow, endColumn, kind, symbol, state]`, see [STRIDE], the kind is [ERROR]
+     * or [MISSING], and the symbol of a missing node is the missing symbol.
+     */
+    @get:JvmName("getDiagnostics")
+    val diagnostics: IntArray
+        @FastNative external get
+
+    /**
+     * Get the rows covered by a diagnostic as a bitmap,
+     * the row `n` is the bit `n % 64` of the element `n / 64`.
+     */
+    @get:JvmName("getLineBitmap")
+    val lineBitmap: LongArray
+        @FastNative external get
+
+    /** Check if the [row] is covered by a diagnostic. */
+    @FastNative
+    external fun hasError(row: Int): Boolean
+
+    /**
+     * Get the visible symbols which are valid at the diagnostic of the [index],
+     * at most [maxCount] of them, the name is [TSLanguage.symbolName].
+     * A missing node only expects the missing symbol.
+     *
+     * @throws [IndexOutOfBoundsException] If the [index] is out of bounds.
+     */
+    @JvmOverloads
+    @Throws(IndexOutOfBoundsException::class)
+    fun expectedSymbols(index: Int, maxCount: Int = 16) = nativeExpectedSymbols(index, maxCount)
+
+    override fun toString() = "TSDiagnostics(size=$size)"
+
+    override fun close() {
+        cleaner?.let { it.clean() } ?: run { delete(self) }
+    }
+
+    private external fun nativeUpdate(tree: TSTree, oldTree: TSTree?)
+
+    @FastNative
+    private external fun nativeExpectedSymbols(index: Int, maxCount: Int): ShortArray
+
+    private class CleanAction(private val diagnostics: Long) : Runnable {
+        override fun run() = delete(diagnostics)
+    }
+
+    companion object {
+        /** The number of the values of a diagnostic packed by [diagnostics]. */
+        const val STRIDE = 9
+
+        /** The kind of an `ERROR` node, the text which can't be parsed. */
+        const val ERROR = 0
+
+        /** The kind of a `MISSING` node, the token inserted by the error recovery. */
+        const val MISSING = 1
+
+        @JvmStatic
+        @CriticalNative
+        private external fun init(): Long
+
+        @JvmStatic
+        @CriticalNative
+        private external fun delete(diagnostics: Long)
+    }
+}
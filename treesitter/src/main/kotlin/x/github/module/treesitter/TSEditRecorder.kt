@@ -0,0 +1,132 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package x.github.module.treesitter
+
+import java.io.BufferedOutputStream
+import java.io.File
+import java.io.FileOutputStream
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Record the edits of a syntax tree to a compact binary trace,
+ * the trace can be replayed on the host by the `ts-replay` benchmark.
+ *
+ * All the values are little endian, the texts are UTF-16LE code units.
+ * The offsets and the columns of the edits are UTF-16 code units too, same as
+ * [TSOffsetIndex.edit], so `ts-replay` translates them to UTF-8 by the offset index.
+ *
+ * ```
+ * header: magic "TSTR", version u32, name length u32, name UTF-8,
+ *         text length u32, initial text UTF-16LE
+ * batch:  delay micros u32, edit count u32, edit count * (
+ *             [TSTree.EDIT_STRIDE] * i32, text length u32, inserted text UTF-16LE)
+ * ```
+ *
+ * Each batch is one [TSOffsetIndex.edit] call followed by a reparse.
+ *
+ * @param file The trace file, it will be overwritten.
+ * @param language The language name like `c`, `kotlin` etc.
+ * @param text The text of the document before the first edit.
+ */
+class TSEditRecorder(
+    file: File,
+    language: String,
+    text: CharSequence
+): AutoCloseable {
+
+    private val output = BufferedOutputStream(FileOutputStream(file), 64 * 1024)
+
+    private var buffer = ByteBuffer.allocate(4096).order(ByteOrder.LITTLE_ENDIAN)
+
+    private var lastNanos = System.nanoTime()
+
+    /** The number of the recorded batches. */
+    var batchCount: Int = 0
+        private set
+
+    init {
+        val name = language.toByteArray(Charsets.UTF_8)
+        ensure(16 + name.size)
+        buffer.put(MAGIC).putInt(VERSION).putInt(name.size).put(name)
+        putText(text)
+        flush()
+    }
+
+    /**
+     * Record a batch of packed edits, see [TSOffsetIndex.edit].
+     *
+     * @param edits The packed edits in UTF-16 code units.
+     * @param texts The inserted text of each edit.
+     */
+    @Synchronized
+    fun record(edits: IntArray, texts: List<CharSequence>) {
+        val count = edits.size / TSTree.EDIT_STRIDE
+        require(texts.size == count) { "Expected $count texts but got ${texts.size}" }
+
+        val now = System.nanoTime()
+        val delay = ((now - lastNanos) / 1000L).coerceIn(0L, UInt.MAX_VALUE.toLong())
+        lastNanos = now
+
+        ensure(8)
+        buffer.putInt(delay.toInt()).putInt(count)
+        for (i in 0 until count) {
+            ensure(TSTree.EDIT_STRIDE * 4)
+            for (j in 0 until TSTree.EDIT_STRIDE) {
+                buffer.putInt(edits[i * TSTree.EDIT_STRIDE + j])
+            }
+            putText(texts[i])
+        }
+        flush()
+        batchCount++
+    }
+
+    @Synchronized
+    override fun close() {
+        output.close()
+    }
+
+    private fun putText(text: CharSequence) {
+        ensure(4 + text.length * 2)
+        buffer.putInt(text.length)
+        for (i in 0 until text.length) {
+            buffer.putChar(text[i])
+        }
+    }
+
+    private fun ensure(size: Int) {
+        if (buffer.remaining() < size) {
+            val old = buffer
+            old.flip()
+            buffer = ByteBuffer.allocate(maxOf(old.capacity() * 2, old.limit() + size))
+                .order(ByteOrder.LITTLE_ENDIAN)
+            buffer.put(old)
+        }
+    }
+
+    private fun flush() {
+        output.write(buffer.array(), 0, buffer.position())
+        buffer.clear()
+    }
+
+    companion object {
+        /** The version of the trace format, the version 1 had the offsets in UTF-16 bytes. */
+        const val VERSION = 2
+
+        private val MAGIC = byteArrayOf('T'.code.toByte(), 'S'.code.toByte(), 'T'.code.toByte(), 'R'.code.toByte())
+    }
+}
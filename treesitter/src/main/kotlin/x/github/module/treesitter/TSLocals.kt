@@ -0,0 +1,156 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package x.github.module.treesitter
+
+import dalvik.annotation.optimization.CriticalNative
+import dalvik.annotation.optimization.FastNative
+import java.lang.ref.Cleaner
+
+/**
+ * The scopes, definitions and references of a tree, resolved by a locals query
+ * with the `@local.scope`, `@local.definition.*` and `@local.reference` captures.
+ *
+ * A reference is resolved to the nearest definition before it in the enclosing scopes,
+ * the definitions outside any scope are global and resolved by name. The index is split
+ * by the children of the root node, an [update] with the old tree only queries the children
+ * overlapping the changed ranges again, the other children are moved to the new tree.
+ *
+ * The lookups by offset are binary searches over the children and their entries,
+ * then the symbol is a group of its scope, or the hashed name for a global symbol.
+ *
+ * The definitions and the resolved references are styled by the capture ids of the
+ * highlight query, like `@local.definition.parameter` by `@variable.parameter`,
+ * so that the [captures] are resolved by the same [TSStyleTable] as the highlights.
+ * The predicates of the locals query are not evaluated.
+ *
+ * __NOTE:__ If you're targeting Android SDK level < 33,
+ * you must `use` or [close] the instance to free up resources.
+ *
+ * #### Example
+ *
+ * ```kotlin
+ * val locals = TSLocals(TSQuery(language, localsPattern), highlightQuery)
+ * locals.update(tree, null, index)
+ * // the definition and the references of the identifier at the caret
+ * val ranges = locals.occurrences(index.toUtf8(caret))
+ * // jump to the definition
+ * locals.definition(index.toUtf8(caret)).takeIf { it.isNotEmpty() }?.let { moveTo(index.toUtf16(it[0])) }
+ * ```
+ *
+ * @constructor Create the index of the locals [query], the query must be kept open
+ *  until the index is closed, the [highlights] query is only read by the constructor.
+ */
+class TSLocals private constructor(
+    private val self: Long,
+    // the native index reads the locals query on every update
+    @Suppress("unused") private val query: TSQuery
+) : AutoCloseable {
+
+    constructor(query: TSQuery, highlights: TSQuery) : this(init(query, highlights), query)
+
+    private val cleaner: Cleaner.Cleanable?
+
+    init {
+        cleaner = RefCleaner(this, CleanAction(self))
+    }
+
+    /** The number of the definitions and references. */
+    @get:JvmName("getSize")
+    val size: Int
+        @FastNative external get
+
+    /**
+     * Index the [tree], the text of the identifiers is read from the [index].
+     *
+     * The [oldTree] is the tree of the last update, edited and then parsed
+     * to the [tree], so only the changed children of the root are queried.
+     * Without it, or if it's another tree, the whole [tree] is queried.
+     *
+     * @return The rows of the children queried again, packed as `[startRow, endRow]`,
+     *  the semantic captures of the other rows are not changed, except the references
+     *  to a global definition, which may be defined or removed in another child.
+     */
+    fun update(tree: TSTree, oldTree: TSTree?, index: TSOffsetIndex): IntArray =
+        nativeUpdate(tree, oldTree, index)
+
+    /** Forget the index, so the next [update] queries the whole tree. */
+    @FastNative
+    external fun reset()
+
+    /**
+     * Get the semantic captures overlapping the UTF-8 range from [start] until [end],
+     * packed as `[startByte, endByte, captureId]` in the order of the start, see [STRIDE].
+     * The capture id is a capture of the highlight query, the style of the definition,
+     * the references without a definition are skipped.
+     */
+    @FastNative
+    external fun captures(start: Int, end: Int): IntArray
+
+    /**
+     * Get the occurrences of the identifier at the UTF-8 [byte], the definitions
+     * and the references of the same symbol packed as `[startByte, endByte]`,
+     * or an empty array if there is no identifier.
+     */
+    @FastNative
+    external fun occurrences(byte: Int): IntArray
+
+    /**
+     * Get the definitions of the identifier at the UTF-8 [byte] packed as `[startByte, endByte]`,
+     * one for a local symbol, and every global definition of the name for a global symbol.
+     */
+    @FastNative
+    external fun definition(byte: Int): IntArray
+
+    /**
+     * Get the references of the identifier at the UTF-8 [byte], without the definitions,
+     * packed as `[startByte, endByte]` in the order of the start.
+     */
+    @FastNative
+    external fun references(byte: Int): IntArray
+
+    /**
+     * Get the definitions of the [name] in any scope of the file,
+     * packed as `[startByte, endByte]` in the order of the start.
+     */
+    @FastNative
+    external fun definitions(name: String): IntArray
+
+    override fun toString() = "TSLocals(size=$size)"
+
+    override fun close() {
+        cleaner?.let { it.clean() } ?: run { delete(self) }
+    }
+
+    private external fun nativeUpdate(tree: TSTree, oldTree: TSTree?, index: TSOffsetIndex): IntArray
+
+    private class CleanAction(private val locals: Long) : Runnable {
+        override fun run() = delete(locals)
+    }
+
+    companion object {
+        /** The number of the values of a capture packed by [captures]. */
+        const val STRIDE = 3
+
+        @JvmStatic
+        @FastNative
+        private external fun init(query: TSQuery, highlights: TSQuery): Long
+
+        @JvmStatic
+        @CriticalNative
+        private external fun delete(locals: Long)
+    }
+}
@@ -71,6 +71,12 @@ class TSLookaheadIterator @Throws(IllegalArgumentException::class) internal cons
         }
     }
 
+    /**
+     * Get all the symbol IDs in one native call,
+     * the iterator is moved to the end like [symbols].
+     */
+    fun symbolArray(): ShortArray = nativeSymbols(state.toShort())
+
     /** Iterate over the symbol names. */
     fun symbolNames(): Sequence<String> {
         reset(state, null)
@@ -113,6 +119,9 @@ class TSLookaheadIterator @Throws(IllegalArgumentException::class) internal cons
     @FastNative
     private external fun nativeNext(): Boolean
 
+    @FastNative
+    private external fun nativeSymbols(state: Short): ShortArray
+
     private companion object {
         @JvmStatic
         @JvmName("init")
@@ -125,26 +125,23 @@ class TSNode internal constructor(
     val nextParseState: UShort
         @FastNative external get
 
-    /** 
-      * The start byte of the node. 
-      * for UTF-16 encoding requires startByte / 2
-      */
+    /**
+     * The start byte of the node, in the encoding of the parsed input.
+     * A tree parsed from a [TSOffsetIndex] has UTF-8 offsets, see [TSOffsetIndex.toUtf16].
+     */
     @get:JvmName("getStartByte")
     val startByte: UInt
         @FastNative external get
 
-    /** 
-     * The end byte of the node.
-     * for UTF-16 encoding requires startByte / 2
-    */
+    /**
+     * The end byte of the node, in the encoding of the parsed input.
+     * A tree parsed from a [TSOffsetIndex] has UTF-8 offsets, see [TSOffsetIndex.toUtf16].
+     */
     @get:JvmName("getEndByte")
     val endByte: UInt
         @FastNative external get
 
-    /**
-     * The range of the node in terms of bytes.
-     * for UTF-16 encoding requires start and end byte * 2
-     */
+    /** The range of the node in terms of bytes, see [startByte]. */
     val byteRange: UIntRange
         get() = startByte..endByte
 
@@ -152,17 +149,17 @@ class TSNode internal constructor(
     val range: TSRange
         get() = TSRange(startPoint, endPoint, startByte, endByte)
 
-    /** 
-     * The start point of the node.
-     * for UTF-16 encoding requires point.column / 2
+    /**
+     * The start point of the node, the column is in bytes of the parsed input,
+     * UTF-8 bytes for a tree parsed from a [TSOffsetIndex].
      */
     @get:JvmName("getStartPoint")
     val startPoint: TSPoint
         @FastNative external get
 
-    /** 
-     * The end point of the node.
-     * for UTF-16 encoding requires point.column / 2
+    /**
+     * The end point of the node, the column is in bytes of the parsed input,
+     * UTF-8 bytes for a tree parsed from a [TSOffsetIndex].
      */
     @get:JvmName("getEndPoint")
     val endPoint: TSPoint
@@ -230,7 +227,13 @@ class TSNode internal constructor(
     
     /** Get the source code of the node, if available. */
     fun text() = tree.text()?.run {
-        subSequence((startByte / 2U).toInt(), minOf((endByte / 2U).toInt(), length))
+        val index = tree.offsetIndex
+        if (index != null) {
+            // the UTF-8 offsets of the tree, the index must not be edited since parsing
+            subSequence(index.toUtf16(startByte.toInt()), minOf(index.toUtf16(endByte.toInt()), length))
+        } else {
+            subSequence((startByte / 2U).toInt(), minOf((endByte / 2U).toInt(), length))
+        }
     }
     
     /**
@@ -345,6 +348,41 @@ class TSNode internal constructor(
     @JvmName("namedDescendant")
     external fun namedDescendant(start: TSPoint, end: TSPoint): TSNode?
 
+    /**
+     * Find the descendants of the given symbol [types] that overlap the byte [range].
+     *
+     * The tree is walked natively in preorder by a symbol bitmap, the subtrees
+     * outside the range are skipped, and the walk stops after [maxResults] nodes.
+     * The nodes are packed as [DESCENDANT_STRIDE] integers in the order
+     * `[startByte, startRow, startColumn, alias, idLow, idHigh, endByte, endRow, endColumn, symbol]`,
+     * get the node of a result by [descendantAt] when it is needed.
+     *
+     * #### Example
+     *
+     * ```kotlin
+     * val types = shortArrayOf(language.symbolForName("comment", true).toShort())
+     * val comments = node.findDescendants(types)
+     * for (i in comments.indices step TSNode.DESCENDANT_STRIDE) {
+     *     scan(comments[i].toUInt(), comments[i + 6].toUInt())
+     * }
+     * ```
+     *
+     * @param range The byte range, the [last][UIntRange.last] byte is exclusive like [TSQuery.byteRange].
+     */
+    @JvmOverloads
+    fun findDescendants(
+        types: ShortArray,
+        range: UIntRange = UInt.MIN_VALUE..UInt.MAX_VALUE,
+        maxResults: Int = Int.MAX_VALUE
+    ): IntArray = nativeFindDescendants(types, range.first.toInt(), range.last.toInt(), maxResults)
+
+    /** Get the node of the [index]-th result packed by [findDescendants]. */
+    fun descendantAt(results: IntArray, index: Int): TSNode {
+        val offset = index * DESCENDANT_STRIDE
+        val id = (results[offset + 4].toLong() and 0xffffffffL) or (results[offset + 5].toLong() shl 32)
+        return TSNode(results.copyOfRange(offset, offset + 4), id, tree)
+    }
+
     /**
      * Edit this node to keep it in-sync with source code that has been edited.
      *
@@ -369,5 +407,12 @@ class TSNode internal constructor(
 
     @FastNative
     private external fun nativeEquals(that: TSNode): Boolean
+
+    private external fun nativeFindDescendants(types: ShortArray, start: Int, end: Int, maxResults: Int): IntArray
+
+    companion object {
+        /** The number of integers of a node packed by [findDescendants]. */
+        const val DESCENDANT_STRIDE = 10
+    }
 }
 
@@ -0,0 +1,140 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package x.github.module.treesitter
+
+import dalvik.annotation.optimization.CriticalNative
+import dalvik.annotation.optimization.FastNative
+import java.lang.ref.Cleaner
+
+/**
+ * The UTF-8 copy of a UTF-16 document, with an index between
+ * the UTF-16 code unit offsets and the UTF-8 byte offsets.
+ *
+ * Parsing the UTF-8 copy by [TSParser.parse] halves the bytes scanned
+ * by the lexer for the mostly ASCII source code. The index keeps a checkpoint
+ * every 1024 code units, a translation is a binary search and a short scan,
+ * the ASCII runs are scanned 16 bytes at a time.
+ *
+ * __NOTE:__ If you're targeting Android SDK level < 33,
+ * you must `use` or [close] the instance to free up resources.
+ *
+ * #### Example
+ *
+ * ```kotlin
+ * val index = TSOffsetIndex(text)
+ * val tree = parser.parse(null, index, text)
+ * // the node offsets are UTF-8 bytes
+ * val start = index.toUtf16(node.startByte.toInt())
+ * ```
+ */
+class TSOffsetIndex private constructor(private val self: Long) : AutoCloseable {
+
+    /** Create a new instance with the UTF-16 [text]. */
+    constructor(text: String = "") : this(init(text))
+
+    private val cleaner: Cleaner.Cleanable?
+
+    init {
+        cleaner = RefCleaner(this, CleanAction(self))
+    }
+
+    /** The length of the document in UTF-8 bytes. */
+    @get:JvmName("getUtf8Length")
+    val utf8Length: Int
+        @FastNative external get
+
+    /** The length of the document in UTF-16 code units. */
+    @get:JvmName("getUtf16Length")
+    val utf16Length: Int
+        @FastNative external get
+
+    /**
+     * Translate the UTF-16 code unit [offset] to the UTF-8 byte offset,
+     * the offset in the middle of a surrogate pair is moved after the pair.
+     */
+    @FastNative
+    external fun toUtf8(offset: Int): Int
+
+    /**
+     * Translate the UTF-8 byte [offset] to the UTF-16 code unit offset,
+     * the offset in the middle of a character is moved to the character start.
+     */
+    @FastNative
+    external fun toUtf16(offset: Int): Int
+
+    /** Replace the UTF-16 range from [start] until [end] with the [text]. */
+    @FastNative
+    external fun replace(start: Int, end: Int, text: String)
+
+    /** Get the text of the UTF-8 range from [start] until [end]. */
+    @FastNative
+    external fun text(start: Int, end: Int): String
+
+    /** Append the [text] to the end of the document. */
+    fun append(text: String) = utf16Length.let { replace(it, it, text) }
+
+    /**
+     * Apply a batch of edits to the document, and to the syntax [tree] if any.
+     *
+     * The edits are packed as [TSTree.editAll], but the offsets and the columns
+     * are UTF-16 code units, and [texts] are the inserted texts of the edits.
+     * The edits are translated to UTF-8 bytes before editing the tree.
+     *
+     * @throws [IllegalArgumentException]
+     *  If the array size is not [TSTree.EDIT_STRIDE] times the size of [texts].
+     */
+    @Throws(IllegalArgumentException::class)
+    fun edit(tree: TSTree?, edits: IntArray, texts: List<CharSequence>) =
+        nativeEdit(tree, edits, Array(texts.size) { texts[it].toString() })
+
+    /**
+     * Create a copy of the document and the index, so that
+     * it can be parsed on another thread while this one is edited.
+     *
+     * The UTF-8 bytes are kept in immutable blocks of 4KB shared by the copies,
+     * an edit replaces the edited blocks by new ones, so a copy only costs
+     * the block references and the checkpoints of the index.
+     */
+    fun copy() = TSOffsetIndex(copy(self))
+
+    override fun toString() = "TSOffsetIndex(utf16Length=$utf16Length, utf8Length=$utf8Length)"
+
+    override fun close() {
+        cleaner?.let { it.clean() } ?: run { delete(self) }
+    }
+
+    @FastNative
+    private external fun nativeEdit(tree: TSTree?, edits: IntArray, texts: Array<String>)
+
+    private class CleanAction(private val index: Long) : Runnable {
+        override fun run() = delete(index)
+    }
+
+    private companion object {
+        @JvmStatic
+        @FastNative
+        private external fun init(text: String): Long
+
+        // not a @CriticalNative, the copy may take a while for a huge document
+        @JvmStatic
+        private external fun copy(index: Long): Long
+
+        @JvmStatic
+        @CriticalNative
+        private external fun delete(index: Long)
+    }
+}
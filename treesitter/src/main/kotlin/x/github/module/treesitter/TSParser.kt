@@ -18,6 +18,7 @@ package x.github.module.treesitter
 
 import dalvik.annotation.optimization.CriticalNative
 import dalvik.annotation.optimization.FastNative
+import java.io.IOException
 import java.lang.ref.Cleaner
 
 /**
@@ -104,6 +105,41 @@ class TSParser(language: TSLanguage) : AutoCloseable {
     var logger: LogFunction? = null
         @FastNative external set
     
+    /**
+     * The capacity of the native log ring buffer, or `0` if disabled.
+     *
+     * Unlike the [logger], the parser writes compact binary log records into
+     * a lock-free ring buffer without calling back into the JVM, so logging can
+     * be left on in the field. The capacity is rounded up to a power of two,
+     * the records are dropped instead of blocking the parser when it is full,
+     * see [droppedLogCount]. Enabling the ring buffer replaces the [logger],
+     * and vice versa. Don't change it while parsing or draining.
+     *
+     * #### Example
+     *
+     * ```
+     * parser.logCapacity = 1 shl 16
+     * val tree = parser.parse(null, source)
+     * val records = IntArray(1024 * TSParser.LOG_RECORD_STRIDE)
+     * while (true) {
+     *     val count = parser.drainLog(records)
+     *     if (count == 0) break
+     *     for (i in 0 until count) {
+     *         val offset = i * TSParser.LOG_RECORD_STRIDE
+     *         val event = TSLogEvent.entries[records[offset + 1]]
+     *     }
+     * }
+     * ```
+     */
+    @set:JvmName("setLogCapacity")
+    var logCapacity: Int = 0
+        @FastNative external set
+    
+    /** The number of the log records dropped because the ring buffer was full. */
+    @get:JvmName("getDroppedLogCount")
+    val droppedLogCount: Long
+        @FastNative external get
+    
     /**
      * Parse a source code string and create a syntax tree.
      *
@@ -144,6 +180,51 @@ class TSParser(language: TSLanguage) : AutoCloseable {
     @Throws(IllegalStateException::class)
     external fun parse(oldTree: TSTree?, encoding: TSInputEncoding, callback: ParseCallback): TSTree
     
+    /**
+     * Parse the UTF-8 source code of the offset [index] and create a syntax tree.
+     *
+     * The byte offsets and the columns of the tree are UTF-8, translate them by the
+     * [index]. The edits of the old tree must be applied by [TSOffsetIndex.edit] so
+     * that the document and the tree are edited together.
+     *
+     * @param source The UTF-16 source code, which is required by the query predicates.
+     * @throws [IllegalStateException]
+     *  If the parser does not have a [language] assigned or
+     *  if parsing was cancelled due to a [timeout][timeoutMicros].
+     */
+    @Throws(IllegalStateException::class)
+    fun parse(oldTree: TSTree?, index: TSOffsetIndex, source: String? = null) =
+        nativeParse(oldTree, index, source).also { it.offsetIndex = index }
+    
+    /**
+     * Parse a UTF-8 file from an open file descriptor and create a syntax tree.
+     *
+     * The file is memory-mapped read-only and parsed directly from the mapping, so
+     * the memory use is proportional to the syntax tree rather than the file size.
+     * The mapping is released before returning, the file descriptor is not closed.
+     * The byte offsets and the columns of the tree are UTF-8, and the tree has no
+     * source code, so the node text must be read from the file or the text buffer.
+     *
+     * @param oldTree The edited previous syntax tree of the file, or `null`.
+     * @param fd The file descriptor, like `ParcelFileDescriptor.fd`.
+     * @throws [IllegalStateException]
+     *  If the parser does not have a [language] assigned or
+     *  if parsing was cancelled due to a [timeout][timeoutMicros].
+     * @throws [IllegalArgumentException] If the file is larger than 4GB.
+     * @throws [IOException] If the file can't be mapped.
+     */
+    @Throws(IllegalStateException::class, IllegalArgumentException::class, IOException::class)
+    external fun parseFile(oldTree: TSTree?, fd: Int): TSTree
+    
+    /**
+     * Parse a UTF-8 file from the [pathname] and create a syntax tree,
+     * see [parseFile] with a file descriptor.
+     *
+     * @throws [IOException] If the file can't be opened or mapped.
+     */
+    @Throws(IllegalStateException::class, IllegalArgumentException::class, IOException::class)
+    external fun parseFile(oldTree: TSTree?, pathname: String): TSTree
+    
     /**
      * Instruct the parser to start the next [parse] from the beginning.
      *
@@ -156,6 +237,31 @@ class TSParser(language: TSLanguage) : AutoCloseable {
     external fun reset()
     
     external fun dotGraphs(pathname: String)
+    
+    /**
+     * Move the log records out of the ring buffer into [records].
+     *
+     * Each record is [LOG_RECORD_STRIDE] ints: the [TSLogType] ordinal,
+     * the [TSLogEvent] ordinal, the symbol or `-1`, the parse state or `-1`,
+     * the row and the column. The tree-sitter logger doesn't report the byte
+     * offset, the row and the column are the last position lexed by the parser.
+     * The column is in bytes, so it is doubled for the UTF-16 source code.
+     *
+     * It may be called on another thread while parsing, but only one thread
+     * may drain at a time.
+     *
+     * @return The number of the records, `0` if the ring buffer is empty or disabled.
+     */
+    @FastNative
+    external fun drainLog(records: IntArray): Int
+    
+    /**
+     * Move all the log records out of the ring buffer and write them
+     * as text lines to the file descriptor [fd], like `ParcelFileDescriptor.fd`.
+     *
+     * @return The number of the records written, or `-1` if the write failed.
+     */
+    external fun dumpLog(fd: Int): Int
 
     override fun toString() = "TSParser(language=$language)"
 
@@ -163,11 +269,17 @@ class TSParser(language: TSLanguage) : AutoCloseable {
         cleaner?.let { it.clean() } ?: run { delete(self) }
     }
 
+    @Throws(IllegalStateException::class)
+    private external fun nativeParse(oldTree: TSTree?, index: TSOffsetIndex, source: String?): TSTree
+
     private class CleanAction(private val parser: Long) : Runnable {
         override fun run() = delete(parser)
     }
     
-    private companion object {        
+    companion object {
+        /** The number of ints of a log record, see [drainLog]. */
+        const val LOG_RECORD_STRIDE = 6
+        
         @JvmStatic
         @CriticalNative
         private external fun init(): Long
@@ -19,6 +19,10 @@ package x.github.module.treesitter
 import dalvik.annotation.optimization.CriticalNative
 import dalvik.annotation.optimization.FastNative
 import java.lang.ref.Cleaner
+import java.util.concurrent.CompletableFuture
+import java.util.concurrent.CompletionException
+import java.util.concurrent.Executor
+import java.util.concurrent.ForkJoinPool
 
 /**
  * A class that represents a set of patterns which match nodes in a syntax tree.
@@ -32,7 +36,7 @@ import java.lang.ref.Cleaner
  * @throws [TSQueryError] If any error occurred while creating the query.
  */
 class TSQuery @Throws(TSQueryError::class) constructor(
-    private val language: TSLanguage,
+    val language: TSLanguage,
     private val pattern: String
 ) : AutoCloseable {
     // TSQuery pointer
@@ -41,7 +45,10 @@ class TSQuery @Throws(TSQueryError::class) constructor(
     // TSQueryCursor pointer
     private val cursor: Long = cursor()
     
+    // indexed by the capture ids, the disabled captures are kept so the ids still match
     private val captureNames: MutableList<String>
+    
+    private val disabledCaptures = mutableSetOf<String>()
 
     private val predicates: List<MutableList<TSQueryPredicate>>
 
@@ -385,10 +392,50 @@ class TSQuery @Throws(TSQueryError::class) constructor(
      */
     @Throws(NoSuchElementException::class)
     fun disableCapture(name: String) {
-        if (!captureNames.remove(name))
+        if (name !in captureNames || !disabledCaptures.add(name))
             throw NoSuchElementException("Capture @$name does not exist")
         nativeDisableCapture(name)
     }
+    
+    /**
+     * Disable the captures that are not [used][isUsed], and the patterns
+     * that have none of the used captures, so that the cursor skips them.
+     *
+     * The captures that the predicates of the enabled patterns refer to are kept.
+     * Like [disablePattern], this can not be undone, create a new query to restore them.
+     *
+     * #### Example
+     *
+     * ```kotlin
+     * query.prune { id -> styleTable[id] != TSStyleTable.NONE }
+     * ```
+     *
+     * @param isUsed Check if the capture with the given id is used.
+     * @return The number of the disabled patterns.
+     */
+    fun prune(isUsed: (UInt) -> Boolean): Int {
+        val used = BooleanArray(captureNames.size) { isUsed(it.toUInt()) }
+        val kept = used.copyOf()
+        var disabled = 0
+        for (i in 0U..<patternCount) {
+            if (capturesForPattern(i.toInt()).any { used[it] }) {
+                // the predicate arguments of the enabled patterns
+                predicates[i].flatMap { it.args }.forEach { arg ->
+                    if (arg is TSQueryPredicateArgs.Capture) {
+                        val id = captureNames.indexOf(arg.value)
+                        if (id >= 0) kept[id] = true
+                    }
+                }
+            } else {
+                disablePattern(i)
+                disabled += 1
+            }
+        }
+        captureNames.forEachIndexed { id, name ->
+            if (!kept[id] && disabledCaptures.add(name)) nativeDisableCapture(name)
+        }
+        return disabled
+    }
 
     /**
      * Get the byte offset where the given pattern starts in the query's source.
@@ -547,6 +594,90 @@ class TSQuery @Throws(TSQueryError::class) constructor(
         }
     }
     
+    /**
+     * Collect all the individual captures like [captures], but on many threads.
+     *
+     * The byte range of the [node] is split at the node boundaries into chunks
+     * of about the same size, every chunk is executed by a cursor of the [pool]
+     * on the [executor], and the sorted captures of the chunks are merged.
+     * A capture belongs to the chunk where its node starts,
+     * so the captures that cross a chunk boundary are not repeated.
+     *
+     * The tree must not be edited or closed until this returns,
+     * and the [predicate] may be called by many threads at the same time.
+     *
+     * @param node The node that the query will run on.
+     * @param pool The pool of the cursors that run the chunks.
+     * @param executor The executor that runs the chunks.
+     * @param parallelism The number of threads, every thread takes about two chunks.
+     * @param predicate A function that handles custom predicates.
+     */
+    @JvmOverloads
+    fun parallelCaptures(
+        node: TSNode,
+        pool: TSQueryCursorPool,
+        executor: Executor = ForkJoinPool.commonPool(),
+        parallelism: Int = Runtime.getRuntime().availableProcessors(),
+        predicate: TSQueryPredicate.(TSQueryMatch) -> Boolean = { true }
+    ): List<Pair<UInt, TSQueryMatch>> {
+        val start = maxOf(node.startByte, byteRange.first)
+        val end = minOf(node.endByte, byteRange.last)
+        if (end <= start) return emptyList()
+        
+        val bounds = mutableListOf(start)
+        val chunkSize = maxOf((end - start) / (parallelism * 2).coerceAtLeast(1).toUInt(), MIN_CHUNK_BYTES)
+        partition(node, chunkSize, end, bounds)
+        bounds += end
+        // the settings are read once, the cursor of the query is not shared
+        val timeout = timeoutMicros
+        val limit = matchLimit
+        val depth = maxStartDepth
+        val last = bounds.size - 2
+        val chunks = (0..last).map { i ->
+            CompletableFuture.supplyAsync({
+                pool.withCursor { cursor ->
+                    cursor.timeoutMicros = timeout
+                    cursor.matchLimit = limit
+                    cursor.maxStartDepth = depth
+                    cursor.byteRange = bounds[i]..bounds[i + 1]
+                    cursor.captures(this, node, predicate).filter { (index, match) ->
+                        val startByte = match.captures[index].node.startByte
+                        (i == 0 || startByte >= bounds[i]) && (i == last || startByte < bounds[i + 1])
+                    }.toList()
+                }
+            }, executor)
+        }
+        // the chunks are in order, so that the merged captures are sorted
+        return chunks.flatMap {
+            try {
+                it.join()
+            } catch (e: CompletionException) {
+                throw e.cause ?: e
+            }
+        }
+    }
+    
+    /**
+     * Check the predicates of the [match] for the cursors
+     * that execute this query, see [TSQueryCursor].
+     */
+    internal fun checkMatch(
+        match: TSQueryMatch,
+        tree: TSTree,
+        predicate: TSQueryPredicate.(TSQueryMatch) -> Boolean
+    ): TSQueryMatch? = match.check(tree, predicate)
+    
+    // split the range after the last bound at the child node starts,
+    // the children larger than a chunk are split recursively
+    private fun partition(node: TSNode, chunkSize: UInt, end: UInt, bounds: MutableList<UInt>) {
+        for (child in node.children) {
+            if (child.startByte >= end) return
+            if (child.endByte <= bounds.last()) continue
+            if (child.startByte >= bounds.last() + chunkSize) bounds += child.startByte
+            if (child.endByte - child.startByte > chunkSize) partition(child, chunkSize, end, bounds)
+        }
+    }
+    
     private inline fun TSQueryMatch.check(
         tree: TSTree,
         predicate: TSQueryPredicate.(TSQueryMatch) -> Boolean
@@ -555,6 +686,7 @@ class TSQuery @Throws(TSQueryError::class) constructor(
         val result = predicates[patternIndex].all {      
             if (it !is TSQueryPredicate.Generic) it(this) else predicate(it, this)        
         }        
+        if (!result) TSStats.rejectPredicate()
         return if (result) this else null
     }
 
@@ -563,6 +695,9 @@ class TSQuery @Throws(TSQueryError::class) constructor(
 
     @FastNative
     private external fun stringCount(): Int
+    
+    @FastNative
+    private external fun capturesForPattern(index: Int): IntArray
 
     @FastNative
     private external fun exec(node: TSNode)
@@ -622,6 +757,9 @@ class TSQuery @Throws(TSQueryError::class) constructor(
 
         private const val TSQueryPredicateStepTypeString = 2
         
+        // the smallest chunk of the parallelCaptures
+        private const val MIN_CHUNK_BYTES = 16384U
+        
         @JvmStatic
         @Throws(TSQueryError::class)
         private external fun init(language: Long, pattern: String): Long
@@ -0,0 +1,212 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package x.github.module.treesitter
+
+import dalvik.annotation.optimization.CriticalNative
+import dalvik.annotation.optimization.FastNative
+import java.lang.ref.Cleaner
+
+/**
+ * A cursor that executes a [TSQuery] on a syntax tree.
+ *
+ * The compiled query is only read by the cursor, so that the same query can be
+ * executed on many threads at the same time, every thread with its own cursor.
+ * The cursor itself must not be used by more than one thread at a time,
+ * see [TSQueryCursorPool] for reusing the cursors between threads.
+ *
+ * __NOTE:__ If you're targeting Android SDK level < 33,
+ * you must `use` or [close] the instance to free up resources.
+ *
+ * #### Example
+ *
+ * ```kotlin
+ * TSQueryCursor().use { cursor ->
+ *     cursor.byteRange = start..end
+ *     cursor.captures(query, tree.rootNode).forEach { ... }
+ * }
+ * ```
+ */
+class TSQueryCursor private constructor(private val self: Long) : AutoCloseable {
+
+    /** Create a new cursor with the default settings. */
+    constructor() : this(init())
+
+    private val cleaner: Cleaner.Cleanable?
+
+    init {
+        cleaner = RefCleaner(this, CleanAction(self))
+    }
+
+    /**
+     * The maximum duration in microseconds that query
+     * execution should be allowed to take before halting.
+     *
+     * Default: `0`
+     */
+    @get:JvmName("getTimeoutMicros")
+    @set:JvmName("setTimeoutMicros")
+    var timeoutMicros: ULong
+        @FastNative external get
+
+        @FastNative external set
+
+    /**
+     * The maximum number of in-progress matches.
+     *
+     * Default: `UInt.MAX_VALUE`
+     */
+    @get:JvmName("getMatchLimit")
+    @set:JvmName("setMatchLimit")
+    var matchLimit: UInt
+        @FastNative external get
+
+        @FastNative external set
+
+    /**
+     * The maximum start depth for the query.
+     *
+     * Default: `UInt.MAX_VALUE`
+     */
+    var maxStartDepth: UInt = UInt.MAX_VALUE
+        set(value) {
+            nativeSetMaxStartDepth(value.toInt())
+            field = value
+        }
+
+    /**
+     * Check if the cursor exceeded its maximum number of
+     * in-progress matches during its last execution.
+     */
+    @get:JvmName("didExceedMatchLimit")
+    val didExceedMatchLimit: Boolean
+        @FastNative external get
+
+    /**
+     * The range of bytes in which the query will be executed.
+     *
+     * Default: `UInt.MIN_VALUE..UInt.MAX_VALUE`
+     */
+    var byteRange: UIntRange = UInt.MIN_VALUE..UInt.MAX_VALUE
+        set(value) {
+            nativeSetByteRange(value.first.toInt(), value.last.toInt())
+            field = value
+        }
+
+    /**
+     * The range of points in which the query will be executed.
+     *
+     * Default: `Point.MIN..Point.MAX`
+     */
+    var pointRange: ClosedRange<TSPoint> = TSPoint.MIN..TSPoint.MAX
+        set(value) {
+            nativeSetPointRange(value.start, value.endInclusive)
+            field = value
+        }
+
+    /**
+     * Iterate over all the matches of the [query] in the order that they were found.
+     *
+     * @param node The node that the query will run on.
+     * @param predicate A function that handles custom predicates.
+     * @see [TSQuery.matches]
+     */
+    @JvmOverloads
+    fun matches(
+        query: TSQuery,
+        node: TSNode,
+        predicate: TSQueryPredicate.(TSQueryMatch) -> Boolean = { true }
+    ): Sequence<TSQueryMatch> {
+        exec(query, node)
+        return sequence {
+            var match = nextMatch(query, node.tree)
+            while (match != null) {
+                val result = query.checkMatch(match, node.tree, predicate)
+                if (result != null) yield(result)
+                match = nextMatch(query, node.tree)
+            }
+        }
+    }
+
+    /**
+     * Iterate over all the individual captures of the [query] in the order that they appear.
+     *
+     * @param node The node that the query will run on.
+     * @param predicate A function that handles custom predicates.
+     * @see [TSQuery.captures]
+     */
+    @JvmOverloads
+    fun captures(
+        query: TSQuery,
+        node: TSNode,
+        predicate: TSQueryPredicate.(TSQueryMatch) -> Boolean = { true }
+    ): Sequence<Pair<UInt, TSQueryMatch>> {
+        exec(query, node)
+        return sequence {
+            var capture = nextCapture(query, node.tree)
+            while (capture != null) {
+                val match = query.checkMatch(capture.second, node.tree, predicate)
+                if (match != null) yield(capture.first to match)
+                capture = nextCapture(query, node.tree)
+            }
+        }
+    }
+
+    /** Restore the default settings of the cursor. */
+    fun reset() {
+        timeoutMicros = 0UL
+        matchLimit = UInt.MAX_VALUE
+        maxStartDepth = UInt.MAX_VALUE
+        byteRange = UInt.MIN_VALUE..UInt.MAX_VALUE
+        pointRange = TSPoint.MIN..TSPoint.MAX
+    }
+
+    override fun toString() = "TSQueryCursor(byteRange=$byteRange, pointRange=$pointRange)"
+
+    override fun close() {
+        cleaner?.let { it.clean() } ?: run { delete(self) }
+    }
+
+    @FastNative
+    private external fun exec(query: TSQuery, node: TSNode)
+
+    private external fun nextMatch(query: TSQuery, tree: TSTree): TSQueryMatch?
+
+    private external fun nextCapture(query: TSQuery, tree: TSTree): Pair<UInt, TSQueryMatch>?
+
+    @FastNative
+    private external fun nativeSetMaxStartDepth(value: Int)
+
+    @FastNative
+    private external fun nativeSetByteRange(start: Int, end: Int)
+
+    @FastNative
+    private external fun nativeSetPointRange(start: TSPoint, end: TSPoint)
+
+    private class CleanAction(private val cursor: Long) : Runnable {
+        override fun run() = delete(cursor)
+    }
+
+    private companion object {
+        @JvmStatic
+        @CriticalNative
+        private external fun init(): Long
+
+        @JvmStatic
+        @CriticalNative
+        private external fun delete(cursor: Long)
+    }
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package x.github.module.treesitter
+
+import java.util.concurrent.ConcurrentLinkedQueue
+import java.util.concurrent.atomic.AtomicInteger
+
+/**
+ * A thread-safe pool of [query cursors][TSQueryCursor].
+ *
+ * Every thread that executes a query takes its own cursor from the pool,
+ * the cursors are [reset][TSQueryCursor.reset] when they are returned, and
+ * at most [maxSize] idle cursors are kept, the others are closed.
+ *
+ * #### Example
+ *
+ * ```kotlin
+ * val captures = pool.withCursor { cursor ->
+ *     cursor.captures(query, tree.rootNode).toList()
+ * }
+ * ```
+ */
+class TSQueryCursorPool @JvmOverloads constructor(
+    val maxSize: Int = Runtime.getRuntime().availableProcessors()
+) : AutoCloseable {
+
+    private val cursors = ConcurrentLinkedQueue<TSQueryCursor>()
+
+    // the number of idle cursors in the queue
+    private val idleCount = AtomicInteger(0)
+
+    /** Take an idle cursor from the pool, or create a new one. */
+    fun acquire(): TSQueryCursor =
+        cursors.poll()?.also { idleCount.decrementAndGet() } ?: TSQueryCursor()
+
+    /** Return the [cursor] to the pool, it must not be used after that. */
+    fun release(cursor: TSQueryCursor) {
+        cursor.reset()
+        if (idleCount.incrementAndGet() <= maxSize) {
+            cursors.offer(cursor)
+        } else {
+            idleCount.decrementAndGet()
+            cursor.close()
+        }
+    }
+
+    /** Run the [block] with a cursor of the pool, and return the cursor after that. */
+    inline fun <R> withCursor(block: (TSQueryCursor) -> R): R {
+        val cursor = acquire()
+        try {
+            return block(cursor)
+        } finally {
+            release(cursor)
+        }
+    }
+
+    override fun toString() = "TSQueryCursorPool(maxSize=$maxSize, idle=${idleCount.get()})"
+
+    /** Close all the idle cursors, the pool can still be used after that. */
+    override fun close() {
+        while (true) {
+            val cursor = cursors.poll() ?: break
+            idleCount.decrementAndGet()
+            cursor.close()
+        }
+    }
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package x.github.module.treesitter
+
+import dalvik.annotation.optimization.CriticalNative
+import dalvik.annotation.optimization.FastNative
+import java.lang.ref.Cleaner
+
+/**
+ * The structural selection of a tree, expand and shrink the selection by the enclosing
+ * named nodes, move it to the sibling nodes, and select the text objects of a
+ * `textobjects.scm` query like `@function.outer` and `@parameter.inner`.
+ *
+ * The chain of the enclosing nodes is computed once for the first press, the next
+ * presses of the returned selection only move along the cached chain, no [TSNode] is
+ * created. The text objects are collected by one pass of the query over the tree on
+ * the first lookup, then a lookup is a search of the sorted objects of the capture.
+ * Both are computed again when the tree is changed. The text predicates `#eq?`, `#match?`
+ * and `#any-of?` with their negations are evaluated on the UTF-8 text of the [TSOffsetIndex],
+ * `#make-range!` makes an object from the start of its first capture to the end of the second,
+ * and the captures started with `_` like `@_start` only serve the predicates.
+ *
+ * The ranges are UTF-8 bytes packed as `[startByte, endByte]`, empty if not found.
+ *
+ * __NOTE:__ If you're targeting Android SDK level < 33,
+ * you must `use` or [close] the instance to free up resources.
+ *
+ * #### Example
+ *
+ * ```kotlin
+ * val selection = TSSelection(TSQuery(language, textobjectsPattern))
+ * // every press expands the last selection by one level
+ * selection.expand(tree, start, end).takeIf { it.isNotEmpty() }?.let { select(it[0], it[1]) }
+ * // the enclosing function
+ * selection.select(tree, offsetIndex, "function.outer", start, end)
+ * ```
+ *
+ * @constructor Create the selection of the [textobjects] query if any, the query
+ *  must be kept open until the selection is closed.
+ */
+class TSSelection private constructor(
+    private val self: Long,
+    // the native selection reads the textobjects query on every tree
+    @Suppress("unused") private val textobjects: TSQuery?
+) : AutoCloseable {
+
+    @JvmOverloads
+    constructor(textobjects: TSQuery? = null) : this(init(textobjects), textobjects)
+
+    private val cleaner: Cleaner.Cleanable?
+
+    init {
+        cleaner = RefCleaner(this, CleanAction(self))
+    }
+
+    /**
+     * Get the smallest named node strictly enclosing the UTF-8 range from [start]
+     * until [end], expanding the returned range again moves one level up the chain.
+     */
+    @FastNative
+    external fun expand(tree: TSTree, start: Int, end: Int): IntArray
+
+    /**
+     * Get the previous level of the chain of the range, down to the range of the first
+     * [expand], or the largest node at the [start] inside a range not made by expand.
+     */
+    @FastNative
+    external fun shrink(tree: TSTree, start: Int, end: Int): IntArray
+
+    /**
+     * Get the next named sibling of the selected node, or the previous one if not
+     * [forward], a range not made of a node moves from the innermost node around it.
+     */
+    @FastNative
+    external fun sibling(tree: TSTree, start: Int, end: Int, forward: Boolean): IntArray
+
+    /**
+     * Get the smallest text object of the [capture] like `function.outer` strictly
+     * enclosing the UTF-8 range, so selecting it again selects the enclosing one.
+     * The [index] is the text of the [tree] for the predicates.
+     */
+    external fun select(tree: TSTree, index: TSOffsetIndex, capture: String, start: Int, end: Int): IntArray
+
+    /**
+     * Get the first text object of the [capture] started after the UTF-8 [byte],
+     * or the last one started before it if not [forward], like the next function.
+     * The [index] is the text of the [tree] for the predicates.
+     */
+    external fun move(tree: TSTree, index: TSOffsetIndex, capture: String, byte: Int, forward: Boolean): IntArray
+
+    /** Forget the chain and the text objects, required whenever the tree is [edited][TSTree.edit] in place. */
+    @FastNative
+    external fun reset()
+
+    override fun close() {
+        cleaner?.let { it.clean() } ?: run { delete(self) }
+    }
+
+    private class CleanAction(private val selection: Long) : Runnable {
+        override fun run() = delete(selection)
+    }
+
+    private companion object {
+        @JvmStatic
+        @FastNative
+        private external fun init(textobjects: TSQuery?): Long
+
+        @JvmStatic
+        @CriticalNative
+        private external fun delete(selection: Long)
+    }
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package x.github.module.treesitter
+
+import dalvik.annotation.optimization.FastNative
+import java.util.concurrent.atomic.LongAdder
+
+/**
+ * The counters and trace spans of the parse and query hot paths.
+ *
+ * The stats are disabled by default, when disabled each instrumented
+ * call only checks a flag. When enabled, the parse and query spans are
+ * written to ATrace on Android and can be captured by Perfetto,
+ * on a desktop JVM they are kept in memory, see [dumpTrace].
+ *
+ * #### Example
+ *
+ * ```kotlin
+ * TSStats.isEnabled = true
+ * // typing in the editor...
+ * val stats = TSStats.snapshot()
+ * Log.i(TAG, "reparse reuse ${stats.reuseRatio}, ${stats.jniObjects} JNI objects")
+ * ```
+ */
+object TSStats {
+
+    init {
+        System.loadLibrary("android-tree-sitter")
+    }
+
+    /** Enable or disable the counters and trace spans. */
+    @Volatile
+    var isEnabled: Boolean = false
+        set(value) {
+            nativeSetEnabled(value)
+            field = value
+        }
+
+    // the predicates are checked in kotlin, see TSQuery.matches
+    private val predicateRejections = LongAdder()
+
+    /**
+     * A snapshot of the counters, summed over all the threads.
+     *
+     * @property parseCount The number of parses.
+     * @property parseNanos The time spent in parsing.
+     * @property bytesRead The bytes of the source code read by the parser.
+     * @property reparseCount The number of parses with an old tree.
+     * @property reparseBytes The document bytes of the reparses.
+     * @property reparseChangedBytes The bytes of the changed ranges of the reparses.
+     * @property queryCount The number of query executions.
+     * @property queryNanos The time spent in the query cursor.
+     * @property queryMatches The number of matches produced.
+     * @property queryCaptures The number of captures produced.
+     * @property predicateRejections The number of matches rejected by the predicates.
+     * @property jniObjects The number of java objects allocated by the native layer.
+     */
+    data class Snapshot(
+        val parseCount: Long,
+        val parseNanos: Long,
+        val bytesRead: Long,
+        val reparseCount: Long,
+        val reparseBytes: Long,
+        val reparseChangedBytes: Long,
+        val queryCount: Long,
+        val queryNanos: Long,
+        val queryMatches: Long,
+        val queryCaptures: Long,
+        val predicateRejections: Long,
+        val jniObjects: Long
+    ) {
+        /** The ratio of the document that the reparses did not need to change. */
+        val reuseRatio: Double
+            get() = if (reparseBytes > 0) 1.0 - reparseChangedBytes.toDouble() / reparseBytes else 0.0
+    }
+
+    /** Get a snapshot of the counters. */
+    fun snapshot(): Snapshot {
+        val values = LongArray(COUNTER_COUNT)
+        nativeSnapshot(values)
+        return Snapshot(
+            parseCount = values[0],
+            parseNanos = values[1],
+            bytesRead = values[2],
+            reparseCount = values[3],
+            reparseBytes = values[4],
+            reparseChangedBytes = values[5],
+            queryCount = values[6],
+            queryNanos = values[7],
+            queryMatches = values[8],
+            queryCaptures = values[9],
+            predicateRejections = predicateRejections.sum(),
+            jniObjects = values[10]
+        )
+    }
+
+    /** Reset the counters and the recorded trace events. */
+    fun reset() {
+        predicateRejections.reset()
+        nativeReset()
+    }
+
+    /**
+     * Write the recorded trace spans as Chrome trace event JSON,
+     * which can be opened by `chrome://tracing` or Perfetto.
+     *
+     * @return `false` on Android, where the spans are written to ATrace.
+     */
+    @FastNative
+    external fun dumpTrace(pathname: String): Boolean
+
+    internal fun rejectPredicate() {
+        if (isEnabled) predicateRejections.increment()
+    }
+
+    // the number of the native counters, see ts_stats.h
+    private const val COUNTER_COUNT = 11
+
+    @FastNative
+    private external fun nativeSetEnabled(value: Boolean)
+
+    @FastNative
+    private external fun nativeSnapshot(values: LongArray)
+
+    @FastNative
+    private external fun nativeReset()
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package x.github.module.treesitter
+
+import dalvik.annotation.optimization.CriticalNative
+import dalvik.annotation.optimization.FastNative
+import java.lang.ref.Cleaner
+
+/**
+ * The styles of a theme compiled for the capture ids of a [TSQuery].
+ *
+ * Every style is packed to a `Long` by [pack], so that the highlighter looks up
+ * the style by the [capture id][TSQueryCapture.id] without hashing the capture
+ * name. A capture name without a style falls back to its parent name, like
+ * `function.method` to `function`, which is resolved once when compiling.
+ *
+ * __NOTE:__ If you're targeting Android SDK level < 33,
+ * you must `use` or [close] the instance to free up resources.
+ *
+ * #### Example
+ *
+ * ```kotlin
+ * val table = TSStyleTable(query, mapOf("function" to TSStyleTable.pack(fg = 0xff61afef.toInt())))
+ * val style = table[capture.id]
+ * if (style != TSStyleTable.NONE) draw(TSStyleTable.foreground(style))
+ * ```
+ *
+ * @constructor Compile the [theme] that maps the capture names to the packed styles.
+ */
+class TSStyleTable private constructor(private val self: Long) : AutoCloseable {
+
+    constructor(query: TSQuery, theme: Map<String, Long>) : this(
+        init(query, theme.keys.toTypedArray(), theme.values.toLongArray())
+    )
+
+    private val cleaner: Cleaner.Cleanable?
+
+    init {
+        cleaner = RefCleaner(this, CleanAction(self))
+    }
+
+    /** The number of the capture ids of the query. */
+    @get:JvmName("getSize")
+    val size: Int
+        @FastNative external get
+
+    /** Get the packed style of the capture [id], or [NONE]. */
+    operator fun get(id: UInt): Long = get(self, id.toInt())
+
+    /** Get the packed style of the [capture], or [NONE]. */
+    operator fun get(capture: TSQueryCapture): Long = get(self, capture.id.toInt())
+
+    /**
+     * Resolve the [captures] of a line to the non-overlapping runs of the range
+     * from [start] until [end], so that the runs are drawn without span objects.
+     *
+     * The captures are packed as `[start, end, captureId]`, the first [count] of them
+     * are painted in order, a later capture overrides an earlier one, so the inner
+     * node wins over the outer node, the captures without a style are skipped.
+     * The runs are packed as `[start, end, captureId]` too, they cover the whole range,
+     * the text without a style has the capture id `-1`, and the neighbouring runs
+     * of the same style are merged.
+     *
+     * @throws [IllegalArgumentException] If the [count] exceeds the [captures].
+     */
+    @FastNative
+    @Throws(IllegalArgumentException::class)
+    external fun resolveRuns(captures: IntArray, count: Int, start: Int, end: Int): IntArray
+
+    override fun toString() = "TSStyleTable(size=$size)"
+
+    override fun close() {
+        cleaner?.let { it.clean() } ?: run { delete(self) }
+    }
+
+    private class CleanAction(private val table: Long) : Runnable {
+        override fun run() = delete(table)
+    }
+
+    companion object {
+        /** The capture without a style. */
+        const val NONE = 0L
+
+        /** The number of the values of a capture or a run packed by [resolveRuns]. */
+        const val RUN_STRIDE = 3
+
+        private const val BACKGROUND_SHIFT = 32
+        private const val ALPHA_SHIFT = 56
+        private const val BOLD = 1L shl 60
+        private const val ITALIC = 1L shl 61
+        private const val UNDERLINE = 1L shl 62
+        private const val STRIKETHROUGH = 1L shl 63
+
+        /**
+         * Pack a style to a `Long`, the foreground is kept as ARGB, the alpha of the
+         * background is kept in 4 bits, a transparent color means no color.
+         */
+        @JvmStatic
+        @JvmOverloads
+        fun pack(
+            fg: Int? = null,
+            bg: Int? = null,
+            bold: Boolean = false,
+            italic: Boolean = false,
+            underline: Boolean = false,
+            strikethrough: Boolean = false
+        ): Long {
+            var style = (fg ?: 0).toLong() and 0xffffffffL
+            if (bg != null && bg ushr 24 != 0) {
+                val alpha = maxOf((bg ushr 24) / 17, 1).toLong()
+                style = style or ((bg.toLong() and 0xffffffL) shl BACKGROUND_SHIFT) or (alpha shl ALPHA_SHIFT)
+            }
+            if (bold) style = style or BOLD
+            if (italic) style = style or ITALIC
+            if (underline) style = style or UNDERLINE
+            if (strikethrough) style = style or STRIKETHROUGH
+            return style
+        }
+
+        /** The foreground ARGB of the [style], `0` is no foreground. */
+        @JvmStatic
+        fun foreground(style: Long): Int = style.toInt()
+
+        /** The background ARGB of the [style], `0` is no background. */
+        @JvmStatic
+        fun background(style: Long): Int {
+            val alpha = ((style ushr ALPHA_SHIFT) and 0xfL).toInt() * 17
+            if (alpha == 0) return 0
+            return (alpha shl 24) or ((style ushr BACKGROUND_SHIFT) and 0xffffffL).toInt()
+        }
+
+        @JvmStatic
+        fun isBold(style: Long) = (style and BOLD) != 0L
+
+        @JvmStatic
+        fun isItalic(style: Long) = (style and ITALIC) != 0L
+
+        @JvmStatic
+        fun isUnderline(style: Long) = (style and UNDERLINE) != 0L
+
+        @JvmStatic
+        fun isStrikethrough(style: Long) = (style and STRIKETHROUGH) != 0L
+
+        @JvmStatic
+        @Throws(IllegalArgumentException::class)
+        private external fun init(query: TSQuery, keys: Array<String>, values: LongArray): Long
+
+        @JvmStatic
+        @CriticalNative
+        private external fun get(table: Long, id: Int): Long
+
+        @JvmStatic
+        @CriticalNative
+        private external fun delete(table: Long)
+    }
+}
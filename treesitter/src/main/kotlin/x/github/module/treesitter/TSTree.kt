@@ -34,6 +34,13 @@ class TSTree internal constructor(
 
     private val cleaner: Cleaner.Cleanable?
 
+    /**
+     * The offset index of the UTF-8 source code, if the tree
+     * is parsed by [TSParser.parse] with a [TSOffsetIndex].
+     */
+    var offsetIndex: TSOffsetIndex? = null
+        internal set
+
     init {
         cleaner = RefCleaner(this, CleanAction(self))
     }
@@ -63,7 +70,22 @@ class TSTree internal constructor(
      */
     @FastNative
     external fun edit(edit: TSInputEdit)
-    
+
+    /**
+     * Apply a batch of edits to the syntax tree in a single native call.
+     *
+     * Each edit is packed as [EDIT_STRIDE] integers in the order
+     * `startByte, oldEndByte, newEndByte, startPoint.row, startPoint.column,
+     * oldEndPoint.row, oldEndPoint.column, newEndPoint.row, newEndPoint.column`,
+     * the edits are applied in the order they appear in the array.
+     *
+     * @throws [IllegalArgumentException]
+     *  If the array size is not a multiple of [EDIT_STRIDE].
+     */
+    @FastNative
+    @Throws(IllegalArgumentException::class)
+    external fun editAll(edits: IntArray)
+
     @FastNative
     external fun dotGraph(pathname: String)
     
@@ -73,7 +95,21 @@ class TSTree internal constructor(
      * You need to copy a syntax tree in order to use it on multiple
      * threads or coroutines, as syntax trees are not thread safe.
      */
-    fun copy() = TSTree(copy(self), source, language)
+    fun copy() = TSTree(copy(self), source, language).also { it.offsetIndex = offsetIndex }
+
+    /**
+     * Create an immutable snapshot of the syntax tree for the background workers.
+     *
+     * The tree is copied by `ts_tree_copy` and the [offset index][offsetIndex]
+     * shares the UTF-8 bytes of the document, so the snapshot is cheap to make
+     * and stays valid while this tree and the index are edited.
+     *
+     * @param generation The generation of the document, see [TSTreeSnapshot.generation].
+     */
+    fun snapshot(generation: Long) = TSTreeSnapshot(
+        TSTree(copy(self), source, language).also { it.offsetIndex = offsetIndex?.copy() },
+        generation
+    )
 
     /** Create a new tree cursor starting from the node of the tree. */
     fun walk() = TSTreeCursor(rootNode)
@@ -101,7 +137,10 @@ class TSTree internal constructor(
         override fun run() = delete(tree)
     }
 
-    private companion object {
+    companion object {
+        /** The number of integers of a packed edit, see [editAll]. */
+        const val EDIT_STRIDE = 9
+
         @JvmStatic
         @CriticalNative
         private external fun copy(tree: Long): Long
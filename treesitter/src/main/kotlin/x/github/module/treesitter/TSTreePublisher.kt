@@ -0,0 +1,123 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package x.github.module.treesitter
+
+import dalvik.annotation.optimization.CriticalNative
+import dalvik.annotation.optimization.FastNative
+import java.lang.ref.Cleaner
+
+/**
+ * Publish the latest complete [tree snapshot][TSTreeSnapshot] from the parser
+ * threads to the readers, like the renderer, without any lock on the read path.
+ *
+ * A new snapshot replaces the current one by an atomic pointer swap. A reader pins
+ * the current epoch while it reads the snapshot, and a replaced snapshot is closed
+ * once no reader holds an epoch before the swap, so the reader never sees a closed
+ * tree and the replaced trees are released as soon as the last reader is done.
+ *
+ * __NOTE:__ If you're targeting Android SDK level < 33,
+ * you must `use` or [close] the instance to free up resources.
+ *
+ * #### Example
+ *
+ * ```kotlin
+ * // the parser thread
+ * publisher.publish(tree.snapshot(generation))
+ * // the render thread
+ * publisher.read { snapshot ->
+ *     snapshot?.let { query.captures(it.rootNode) }
+ * }
+ * ```
+ */
+class TSTreePublisher private constructor(private val self: Long) : AutoCloseable {
+
+    /** Create a new publisher without any snapshot. */
+    constructor() : this(init())
+
+    private val cleaner: Cleaner.Cleanable?
+
+    init {
+        cleaner = RefCleaner(this, CleanAction(self))
+    }
+
+    /** The generation of the current snapshot, or `-1` if nothing is published. */
+    @get:JvmName("getGeneration")
+    val generation: Long
+        @FastNative external get
+
+    /** The number of the replaced snapshots that are still read by a reader. */
+    @get:JvmName("getRetiredCount")
+    val retiredCount: Int
+        @FastNative external get
+
+    /**
+     * Replace the current snapshot, the publisher takes over the reference
+     * of the [snapshot] and closes it once no reader can see it.
+     */
+    fun publish(snapshot: TSTreeSnapshot) = nativePublish(snapshot, snapshot.generation)
+
+    /**
+     * Read the current snapshot, which stays valid until the [block] returns,
+     * [retain][TSTreeSnapshot.retain] it to keep it after that.
+     *
+     * @throws [IllegalStateException] If too many readers are reading at the same time.
+     */
+    @Throws(IllegalStateException::class)
+    inline fun <R> read(block: (TSTreeSnapshot?) -> R): R {
+        val slot = pin()
+        try {
+            return block(current())
+        } finally {
+            unpin(slot)
+        }
+    }
+
+    override fun toString() = "TSTreePublisher(generation=$generation, retired=$retiredCount)"
+
+    /** Close the current snapshot and the replaced ones, no reader can be reading. */
+    override fun close() {
+        cleaner?.let { it.clean() } ?: run { delete(self) }
+    }
+
+    // closes the reclaimed snapshots by calling back into java, so not a fast native
+    private external fun nativePublish(snapshot: TSTreeSnapshot, generation: Long)
+
+    @PublishedApi
+    @FastNative
+    internal external fun pin(): Int
+
+    @PublishedApi
+    @FastNative
+    internal external fun current(): TSTreeSnapshot?
+
+    // may close the reclaimed snapshots like nativePublish
+    @PublishedApi
+    internal external fun unpin(slot: Int)
+
+    private class CleanAction(private val publisher: Long) : Runnable {
+        override fun run() = delete(publisher)
+    }
+
+    private companion object {
+        @JvmStatic
+        @CriticalNative
+        private external fun init(): Long
+
+        @JvmStatic
+        private external fun delete(publisher: Long)
+    }
+}
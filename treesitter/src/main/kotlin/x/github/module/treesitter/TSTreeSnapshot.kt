@@ -0,0 +1,97 @@
+/*
+ * Copyright © 2023 Github Lzhiyong
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package x.github.module.treesitter
+
+import java.util.concurrent.atomic.AtomicInteger
+
+/**
+ * An immutable snapshot of a [syntax tree][TSTree], made by [TSTree.snapshot].
+ *
+ * The snapshot is never edited, so it can be read by many threads at the same
+ * time while the editor keeps editing the original tree. The source code is read
+ * from the snapshot of the offset index, or from the string the tree was parsed from.
+ *
+ * The snapshot is reference counted, every worker that keeps it must [retain]
+ * it and [close] it when done, the last close releases the native memory.
+ *
+ * #### Example
+ *
+ * ```kotlin
+ * val snapshot = tree.snapshot(generation)
+ * executor.execute {
+ *     snapshot.use { outline(it.rootNode, it::text) }
+ * }
+ * ```
+ */
+class TSTreeSnapshot internal constructor(
+    /** The copy of the syntax tree, it must not be edited. */
+    val tree: TSTree,
+    /** The generation of the document that the tree was parsed from. */
+    val generation: Long
+) : AutoCloseable {
+
+    private val refCount = AtomicInteger(1)
+
+    /** The root node of the syntax tree. */
+    val rootNode: TSNode
+        get() = tree.rootNode
+
+    /** The offset index of the UTF-8 source code, if the tree was parsed with one. */
+    val offsetIndex: TSOffsetIndex?
+        get() = tree.offsetIndex
+
+    /** Check if the snapshot is released by the last [close]. */
+    val isClosed: Boolean
+        get() = refCount.get() <= 0
+
+    /**
+     * Get the source code of the [node], if available.
+     *
+     * The offsets of the tree are UTF-8 bytes if the tree has an [offsetIndex],
+     * the text is read from the index if the tree is not parsed from a string.
+     */
+    fun text(node: TSNode): CharSequence? {
+        val index = offsetIndex
+        return if (index != null && tree.text() == null) {
+            index.text(node.startByte.toInt(), node.endByte.toInt())
+        } else {
+            node.text()
+        }
+    }
+
+    /**
+     * Take a reference to the snapshot for another worker.
+     *
+     * @throws [IllegalStateException] If the snapshot was already released.
+     */
+    @Throws(IllegalStateException::class)
+    fun retain(): TSTreeSnapshot {
+        val count = refCount.getAndUpdate { if (it > 0) it + 1 else it }
+        check(count > 0) { "The snapshot of generation $generation is already released" }
+        return this
+    }
+
+    override fun toString() = "TSTreeSnapshot(generation=$generation, tree=$tree)"
+
+    /** Release the reference, the last one closes the tree and the index. */
+    override fun close() {
+        if (refCount.decrementAndGet() == 0) {
+            offsetIndex?.close()
+            tree.close()
+        }
+    }
+}
@@ -22,6 +22,31 @@ enum class TSInputEncoding { UTF8, UTF16 }
 /* Get the parser log type */
 enum class TSLogType { PARSE, LEX }
 
+/* Get the event of a parser log record, keep the same order as the ts_log_ring.h */
+enum class TSLogEvent {
+    OTHER,
+    NEW_PARSE,
+    PROCESS,
+    LEX_EXTERNAL,
+    LEX_INTERNAL,
+    LEXED_LOOKAHEAD,
+    SHIFT,
+    SHIFT_EXTRA,
+    REDUCE,
+    ACCEPT,
+    DETECT_ERROR,
+    RECOVER,
+    SKIP_TOKEN,
+    REUSE_NODE,
+    CANT_REUSE_NODE,
+    BREAKDOWN,
+    CONDENSE,
+    RESUME,
+    DONE,
+    CONSUME_CHARACTER,
+    SKIP_CHARACTER
+}
+
 /* Get the tree sitter language symbol type */
 enum class TSSymbolType {
     REGULAR,
@@ -34,10 +59,12 @@ enum class TSSymbolType {
  *
  * @property node The captured node.
  * @property name The name of the capture.
+ * @property id The capture id in the query, see [TSStyleTable].
  */
 data class TSQueryCapture internal constructor(
     @get:JvmName("node") val node: TSNode,
-    @get:JvmName("name") val name: String
+    @get:JvmName("name") val name: String,
+    @get:JvmName("getId") val id: UInt
 ) {
     override fun toString() = "TSQueryCapture(name=$name, node=$node)"
 }